@@ -0,0 +1,194 @@
+#include "QColor"
+#include "QFile"
+#include "QJsonArray"
+#include "QJsonDocument"
+#include "QJsonObject"
+#include "QRegularExpression"
+
+#include <array>
+#include <cstdio>
+
+#include "PanelLayout.hpp"
+
+static bool ParseBackend(const QString& aName, RendererType& aType)
+{
+    struct BackendName
+    {
+        const char* mName;
+        RendererType mType;
+    };
+
+    static constexpr BackendName cBackends[] = {
+        { "d3d11", RendererType::Dx11Renderer },
+        { "d3d12", RendererType::Dx12Renderer },
+        { "opengl", RendererType::OpenGL3_3Renderer },
+        { "vulkan", RendererType::VkRenderer },
+        { "sdl", RendererType::SdlRenderRenderer },
+        { "software", RendererType::SoftwareRenderer },
+    };
+
+    for (const BackendName& backend : cBackends)
+    {
+        if (0 == aName.compare(backend.mName, Qt::CaseInsensitive))
+        {
+            aType = backend.mType;
+            return true;
+        }
+    }
+
+    printf("Unknown backend \"%s\"\n", qPrintable(aName));
+    return false;
+}
+
+static bool ParseArea(const QString& aName, ads::DockWidgetArea& aArea)
+{
+    struct AreaName
+    {
+        const char* mName;
+        ads::DockWidgetArea mArea;
+    };
+
+    static constexpr AreaName cAreas[] = {
+        { "top", ads::TopDockWidgetArea },
+        { "bottom", ads::BottomDockWidgetArea },
+        { "left", ads::LeftDockWidgetArea },
+        { "right", ads::RightDockWidgetArea },
+        { "center", ads::CenterDockWidgetArea },
+    };
+
+    for (const AreaName& area : cAreas)
+    {
+        if (0 == aName.compare(area.mName, Qt::CaseInsensitive))
+        {
+            aArea = area.mArea;
+            return true;
+        }
+    }
+
+    printf("Unknown dock area \"%s\"\n", qPrintable(aName));
+    return false;
+}
+
+std::vector<PanelDescription> DefaultPanelLayout()
+{
+    std::vector<PanelDescription> panels;
+
+#if WIN32
+    panels.push_back({ RendererType::Dx11Renderer, {}, 1, ads::TopDockWidgetArea, color{ 0x00, 0xFF, 0x00, 0xFF } });
+    panels.push_back({ RendererType::Dx12Renderer, {}, 1, ads::TopDockWidgetArea, color{ 0xFF, 0x00, 0xFF, 0xFF } });
+#endif // WIN32
+
+#ifdef HAVE_VULKAN
+    panels.push_back({ RendererType::VkRenderer, {}, 1, ads::TopDockWidgetArea, color{ 0x00, 0x00, 0xFF, 0xFF } });
+#endif // HAVE_VULKAN
+
+    panels.push_back({ RendererType::OpenGL3_3Renderer, {}, 1, ads::TopDockWidgetArea, color{ 0xFF, 0x00, 0x00, 0xFF } });
+    panels.push_back({ RendererType::SoftwareRenderer, {}, 1, ads::BottomDockWidgetArea, color{ 0x20, 0x20, 0x20, 0xFF } });
+    panels.push_back({ RendererType::SdlRenderRenderer, {}, 1, ads::BottomDockWidgetArea, color{ 0x00, 0x00, 0x00, 0xFF } });
+
+    return panels;
+}
+
+bool ParsePanelDescription(const QString& aText, PanelDescription& aPanel)
+{
+    static const QRegularExpression cPattern{ R"(^(\w+)(?::([\w-]+))?(?:\*(\d+))?(?:@(\w+))?$)" };
+
+    QRegularExpressionMatch match = cPattern.match(aText.trimmed());
+    if (!match.hasMatch())
+    {
+        printf("Can't parse panel \"%s\", expected backend[:driver][*count][@area]\n", qPrintable(aText));
+        return false;
+    }
+
+    PanelDescription panel;
+    if (!ParseBackend(match.captured(1), panel.mType))
+    {
+        return false;
+    }
+
+    panel.mDriver = match.captured(2).toStdString();
+
+    if (match.hasCaptured(3))
+    {
+        panel.mCount = match.captured(3).toInt();
+    }
+
+    if (match.hasCaptured(4) && !ParseArea(match.captured(4), panel.mArea))
+    {
+        return false;
+    }
+
+    aPanel = panel;
+    return true;
+}
+
+bool LoadPanelLayout(const QString& aPath, std::vector<PanelDescription>& aPanels)
+{
+    QFile file{ aPath };
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        printf("Failed to open layout %s\n", qPrintable(aPath));
+        return false;
+    }
+
+    QJsonParseError error;
+    QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &error);
+    if (document.isNull())
+    {
+        printf("Failed to parse layout %s: %s\n", qPrintable(aPath), qPrintable(error.errorString()));
+        return false;
+    }
+
+    std::vector<PanelDescription> panels;
+    for (const QJsonValue& value : document.object()["panels"].toArray())
+    {
+        QJsonObject object = value.toObject();
+        PanelDescription panel;
+
+        if (!ParseBackend(object["backend"].toString(), panel.mType))
+        {
+            return false;
+        }
+
+        panel.mDriver = object["driver"].toString().toStdString();
+        panel.mCount = object["count"].toInt(1);
+
+        if (object.contains("area") && !ParseArea(object["area"].toString(), panel.mArea))
+        {
+            return false;
+        }
+
+        if (object.contains("clearColor"))
+        {
+            QColor clearColor = QColor::fromString(object["clearColor"].toString());
+            if (!clearColor.isValid())
+            {
+                printf("Invalid clearColor \"%s\" in %s\n", qPrintable(object["clearColor"].toString()), qPrintable(aPath));
+                return false;
+            }
+
+            panel.mClearColor = color{ (Uint8)clearColor.red(), (Uint8)clearColor.green(), (Uint8)clearColor.blue(), 0xFF };
+        }
+
+        panels.push_back(panel);
+    }
+
+    aPanels = std::move(panels);
+    return true;
+}
+
+color PanelPaletteColor(size_t aIndex)
+{
+    static constexpr std::array<color, 8> cPalette = { {
+        { 0x00, 0x00, 0xFF, 0xFF },
+        { 0xFF, 0x00, 0x00, 0xFF },
+        { 0x00, 0xFF, 0x00, 0xFF },
+        { 0x00, 0x80, 0x80, 0xFF },
+        { 0xFF, 0x00, 0xFF, 0xFF },
+        { 0x80, 0x80, 0x00, 0xFF },
+        { 0x20, 0x20, 0x20, 0xFF },
+        { 0x80, 0x40, 0x00, 0xFF },
+    } };
+
+    return cPalette[aIndex % cPalette.size()];
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "QString"
+
+#include "DockManager.h"
+
+#include "Renderers/Renderer.hpp"
+
+// One line of a panel layout: which backend, how many of it and where they dock.
+struct PanelDescription
+{
+    RendererType mType = RendererType::VkRenderer;
+
+    // SdlRenderRenderer only. Empty means one panel per render driver SDL reports.
+    std::string mDriver;
+
+    int mCount = 1;
+    ads::DockWidgetArea mArea = ads::TopDockWidgetArea;
+
+    // Picked from a palette by panel index when not given.
+    std::optional<color> mClearColor;
+};
+
+// The panels main() opens when it isn't told otherwise.
+std::vector<PanelDescription> DefaultPanelLayout();
+
+// Parses the command line form of a panel, backend[:driver][*count][@area], for example
+// "vulkan*4@top" or "sdl:opengl@bottom". Backends are d3d11, d3d12, opengl, vulkan, sdl and
+// software, areas are top, bottom, left, right and center.
+bool ParsePanelDescription(const QString& aText, PanelDescription& aPanel);
+
+// Reads a layout file of the form:
+//
+//   { "panels": [ { "backend": "vulkan", "count": 2, "area": "top", "clearColor": "#0000ff" },
+//                 { "backend": "sdl", "driver": "opengl", "area": "bottom" } ] }
+//
+// Everything but backend is optional. Prints what's wrong and returns false on bad input.
+bool LoadPanelLayout(const QString& aPath, std::vector<PanelDescription>& aPanels);
+
+// Stable clear color for the aIndex'th panel, so panels of a layout are told apart at a glance.
+color PanelPaletteColor(size_t aIndex);
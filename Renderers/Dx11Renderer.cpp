@@ -211,8 +211,9 @@ DX11Renderer::DX11Renderer(SDL_Window* aWindow)
     mD3DDevice->CreateRasterizerState(&rasterizerDesc, mRasterState.GetAddressOf());
 }
 
-void DX11Renderer::Initialize()
+bool DX11Renderer::Initialize()
 {
+    return true;
 }
 
 void DX11Renderer::Update()
@@ -224,6 +225,8 @@ void DX11Renderer::Update()
         mClearColor.a / 255.f,
     };
 
+    BeginSubmit();
+
     mD3DDeviceContext->RSSetState(mRasterState.Get());
 
     int width, height;
@@ -252,11 +255,31 @@ void DX11Renderer::Update()
     mD3DDeviceContext->PSSetShader( mPixelShader.Get(), nullptr, 0 );
     mD3DDeviceContext->Draw( cVertexCount, 0 );
 
-    mSwapChain->Present(1, 0); // Present with vsync
+    mSwapChain->Present(mSyncInterval, 0);
+
+    EndPresent();
+}
+
+PresentMode DX11Renderer::ApplyPresentMode(PresentMode aMode)
+{
+    // We're on a flip model swapchain without tearing support, so a sync interval of 0 
+    // behaves like mailbox rather than truly immediate.
+    switch (aMode)
+    {
+        case PresentMode::Mailbox:
+        case PresentMode::Immediate:
+            mSyncInterval = 0;
+            return PresentMode::Mailbox;
+        default:
+            mSyncInterval = 1;
+            return PresentMode::Fifo;
+    }
 }
 
 void DX11Renderer::Resize(unsigned int aWidth, unsigned int aHeight)
 {
+    Renderer::Resize(aWidth, aHeight);
+
     CleanupRenderTarget();
     mSwapChain->ResizeBuffers(0, (UINT)aWidth, (UINT)aHeight, DXGI_FORMAT_UNKNOWN, 0);
     CreateRenderTarget();
@@ -12,11 +12,14 @@ class DX11Renderer : public Renderer
 public:
 	DX11Renderer(SDL_Window* aWindow);
 
-	void Initialize() override;
+	bool Initialize() override;
 	void Update() override;
 	void Resize(unsigned int aWidth, unsigned int aHeight) override;
     virtual const char* Name() override { return "Dx11Renderer"; };
 
+protected:
+    PresentMode ApplyPresentMode(PresentMode aMode) override;
+
 private:
 	void CleanupRenderTarget();
 	void CreateRenderTarget();
@@ -36,4 +39,5 @@ private:
 	
 
 	ID3D11RenderTargetView* mMainRenderTargetView = nullptr;
+    UINT mSyncInterval = 1;
 };
@@ -253,8 +253,9 @@ DX12Renderer::DX12Renderer(SDL_Window* aWindow)
     }
 }
 
-void DX12Renderer::Initialize()
+bool DX12Renderer::Initialize()
 {
+    return true;
 }
 
 void DX12Renderer::Update()
@@ -320,18 +321,40 @@ void DX12Renderer::Update()
 
     ThrowIfFailed(mCommandList->Close());
 
+    BeginSubmit();
+
     // Execute the command list.
     ID3D12CommandList* ppCommandLists[] = { mCommandList.Get() };
     mCommandQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
 
     // Present the frame.
-    ThrowIfFailed(mSwapChain->Present(1, 0));
+    ThrowIfFailed(mSwapChain->Present(mSyncInterval, 0));
+
+    EndPresent();
 
     WaitForPreviousFrame();
 }
 
+PresentMode DX12Renderer::ApplyPresentMode(PresentMode aMode)
+{
+    // We're on a flip model swapchain without tearing support, so a sync interval of 0 
+    // behaves like mailbox rather than truly immediate.
+    switch (aMode)
+    {
+        case PresentMode::Mailbox:
+        case PresentMode::Immediate:
+            mSyncInterval = 0;
+            return PresentMode::Mailbox;
+        default:
+            mSyncInterval = 1;
+            return PresentMode::Fifo;
+    }
+}
+
 void DX12Renderer::Resize(unsigned int aWidth, unsigned int aHeight)
 {
+    Renderer::Resize(aWidth, aHeight);
+
     // Don't allow 0 size swap chain back buffers.
     aWidth = std::max(1u, aWidth);
     aHeight = std::max(1u, aHeight);
@@ -17,11 +17,14 @@ class DX12Renderer : public Renderer
 public:
 	DX12Renderer(SDL_Window* aWindow);
 
-	void Initialize() override;
+	bool Initialize() override;
 	void Update() override;
 	void Resize(unsigned int aWidth, unsigned int aHeight) override;
     virtual const char* Name() override { return "Dx12Renderer"; };
 
+protected:
+    PresentMode ApplyPresentMode(PresentMode aMode) override;
+
 private:
     void WaitForPreviousFrame();
     void GetHardwareAdapter(
@@ -52,4 +55,5 @@ private:
     HANDLE mFenceEvent;
     Microsoft::WRL::ComPtr<ID3D12Fence> mFence;
     UINT64 mFenceValue;
+    UINT mSyncInterval = 1;
 };
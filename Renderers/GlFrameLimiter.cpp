@@ -0,0 +1,46 @@
+#include <algorithm>
+
+#include "Renderers/GlFrameLimiter.hpp"
+
+void GlFrameLimiter::SetMaxQueuedFrames(size_t aFrames)
+{
+    mMaxQueuedFrames = std::min(aFrames, cMaxQueuedFrames);
+}
+
+Uint64 GlFrameLimiter::EndFrame()
+{
+    if (0 == mMaxQueuedFrames)
+    {
+        Reset();
+        return 0;
+    }
+
+    mFences[(mOldest + mCount) % mFences.size()] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    ++mCount;
+
+    Uint64 startNs = SDL_GetTicksNS();
+
+    while (mCount > mMaxQueuedFrames)
+    {
+        // The flush bit makes sure the fence actually reaches the GPU, or we'd wait forever.
+        GLsync& fence = mFences[mOldest];
+        glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+        glDeleteSync(fence);
+        fence = nullptr;
+
+        mOldest = (mOldest + 1) % mFences.size();
+        --mCount;
+    }
+
+    return SDL_GetTicksNS() - startNs;
+}
+
+void GlFrameLimiter::Reset()
+{
+    for (; 0 != mCount; --mCount)
+    {
+        glDeleteSync(mFences[mOldest]);
+        mFences[mOldest] = nullptr;
+        mOldest = (mOldest + 1) % mFences.size();
+    }
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+#include "glad/glad.h"
+
+#include "SDL3/SDL.h"
+
+// Caps how many frames the driver may have queued. Every swap is followed by a fence, and
+// once more than the cap are outstanding we wait on the oldest, so input is never more than
+// that many frames behind whatever the driver's own queue depth happens to be.
+class GlFrameLimiter
+{
+public:
+    static constexpr size_t cMaxQueuedFrames = 8;
+
+    // 0 turns the limiter off. Clamped to cMaxQueuedFrames.
+    void SetMaxQueuedFrames(size_t aFrames);
+    size_t GetMaxQueuedFrames() const { return mMaxQueuedFrames; }
+
+    // Call right after the swap. Returns how long it waited, in nanoseconds.
+    Uint64 EndFrame();
+
+    // Drops every fence, for when the context goes away.
+    void Reset();
+
+private:
+    std::array<GLsync, cMaxQueuedFrames + 1> mFences = {};
+    size_t mOldest = 0;
+    size_t mCount = 0;
+    size_t mMaxQueuedFrames = 2;
+};
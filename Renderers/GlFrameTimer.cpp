@@ -0,0 +1,34 @@
+#include "Renderers/GlFrameTimer.hpp"
+
+void GlFrameTimer::Begin(float aScale)
+{
+    if (mCount == mQueries.size())
+    {
+        return;
+    }
+
+    if (0 == mQueries[0].mQuery)
+    {
+        for (Query& query : mQueries)
+        {
+            glGenQueries(1, &query.mQuery);
+        }
+    }
+
+    Query& query = mQueries[(mOldest + mCount) % mQueries.size()];
+    query.mScale = aScale;
+    glBeginQuery(GL_TIME_ELAPSED, query.mQuery);
+    mTiming = true;
+}
+
+void GlFrameTimer::End()
+{
+    if (!mTiming)
+    {
+        return;
+    }
+
+    glEndQuery(GL_TIME_ELAPSED);
+    ++mCount;
+    mTiming = false;
+}
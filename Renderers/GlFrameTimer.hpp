@@ -0,0 +1,56 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+#include "glad/glad.h"
+
+// Times the GPU side of frames with GL_TIME_ELAPSED queries, without ever waiting on one. A
+// frame's time is only read back once the GPU is done with it, usually a frame or two
+// later, so each carries the render scale it was drawn at for whoever it's reported to.
+class GlFrameTimer
+{
+public:
+    static constexpr size_t cMaxPendingFrames = 4;
+
+    // Around the GL calls to time, once per frame. Frames started while cMaxPendingFrames
+    // are still on the GPU aren't timed.
+    void Begin(float aScale);
+    void End();
+
+    // Calls aResult(milliseconds, scale) for each frame the GPU has finished, oldest first.
+    template <typename tCallback>
+    void Collect(tCallback&& aResult)
+    {
+        while (0 != mCount)
+        {
+            Query& query = mQueries[mOldest];
+
+            GLint available = 0;
+            glGetQueryObjectiv(query.mQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available)
+            {
+                return;
+            }
+
+            GLuint64 elapsedNs = 0;
+            glGetQueryObjectui64v(query.mQuery, GL_QUERY_RESULT, &elapsedNs);
+            aResult((double)elapsedNs / 1000000.0, query.mScale);
+
+            mOldest = (mOldest + 1) % mQueries.size();
+            --mCount;
+        }
+    }
+
+private:
+    struct Query
+    {
+        GLuint mQuery = 0;
+        float mScale = 1.0f;
+    };
+
+    std::array<Query, cMaxPendingFrames> mQueries = {};
+    size_t mOldest = 0;
+    size_t mCount = 0;
+    bool mTiming = false;
+};
@@ -0,0 +1,380 @@
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#define SDL_FUNCTION_POINTER_IS_VOID_POINTER
+#include "SDL3/SDL.h"
+
+#include "glad/glad.h"
+
+#include "Renderers/GlProgramManager.hpp"
+
+void LoadGlFunctions()
+{
+    static std::once_flag loaded;
+    std::call_once(loaded, []()
+    {
+        gladLoadGLLoader(SDL_GL_GetProcAddress);
+    });
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Helpers:
+static uint64_t Fnv1a(const void* aData, size_t aSize, uint64_t aHash = 0xcbf29ce484222325ull)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(aData);
+    for (size_t i = 0; i < aSize; ++i)
+    {
+        aHash ^= bytes[i];
+        aHash *= 0x100000001b3ull;
+    }
+
+    return aHash;
+}
+
+static uint64_t Fnv1a(const std::string& aString, uint64_t aHash = 0xcbf29ce484222325ull)
+{
+    // Include the terminator so ("ab", "c") and ("a", "bc") don't collide.
+    return Fnv1a(aString.c_str(), aString.size() + 1, aHash);
+}
+
+static void SetContextAttributes()
+{
+    // Decide GL+GLSL versions
+#if defined(IMGUI_IMPL_OPENGL_ES2)
+    // GL ES 2.0 + GLSL 100
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, 0);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_ES);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 2);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 0);
+#elif defined(__APPLE__)
+    // GL 3.2 Core + GLSL 150
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, SDL_GL_CONTEXT_FORWARD_COMPATIBLE_FLAG); // Always required on Mac
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 2);
+#else
+    // GL 3.3 + GLSL 130
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, 0);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 0);
+#endif
+
+    // Create window with graphics context
+    SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
+    SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
+    SDL_GL_SetAttribute(SDL_GL_STENCIL_SIZE, 8);
+}
+
+static bool CheckShader(GLuint aShader, const char* aStage)
+{
+    GLint status = GL_FALSE;
+    glGetShaderiv(aShader, GL_COMPILE_STATUS, &status);
+
+    if (GL_TRUE != status)
+    {
+        char log[1024] = {};
+        glGetShaderInfoLog(aShader, sizeof(log), nullptr, log);
+        printf("Failed to compile %s shader:\n%s\n", aStage, log);
+        return false;
+    }
+
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// GlProgramManager:
+GlProgramManager& GlProgramManager::Get()
+{
+    static GlProgramManager manager;
+    return manager;
+}
+
+GlProgramManager::~GlProgramManager()
+{
+    {
+        std::lock_guard lock{ mMutex };
+        mStopping = true;
+    }
+    mCondition.notify_all();
+
+    if (mWorker.joinable())
+    {
+        mWorker.join();
+    }
+}
+
+SDL_GLContext GlProgramManager::CreateContext(SDL_Window* aWindow)
+{
+    std::lock_guard lock{ mContextMutex };
+
+    SetContextAttributes();
+
+    // The first context we make is the root of the share group. It lives on a hidden window
+    // so it doesn't go away with any one panel, and the worker's context hangs off of it.
+    if (nullptr == mRootContext)
+    {
+        mHiddenWindow = SDL_CreateWindow("GlProgramManager", 1, 1, SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+        SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 0);
+        mRootContext = SDL_GL_CreateContext(mHiddenWindow);
+
+        SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 1);
+        mWorkerContext = SDL_GL_CreateContext(mHiddenWindow);
+
+        if ((nullptr == mRootContext) || (nullptr == mWorkerContext))
+        {
+            printf("SDL Error: %s\n", SDL_GetError());
+        }
+
+        // The worker has to be able to make its context current.
+        SDL_GL_MakeCurrent(mHiddenWindow, nullptr);
+        StartWorker();
+    }
+
+    SDL_GL_MakeCurrent(mHiddenWindow, mRootContext);
+    SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 1);
+    SDL_GLContext context = SDL_GL_CreateContext(aWindow);
+    SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 0);
+
+    if (nullptr == context)
+    {
+        printf("SDL Error: %s\n", SDL_GetError());
+    }
+
+    return context;
+}
+
+std::shared_ptr<GlProgram> GlProgramManager::RequestProgram(const char* aVertexSource, const char* aFragmentSource)
+{
+    auto program = std::make_shared<GlProgram>();
+    program->mVertexSource = aVertexSource;
+    program->mFragmentSource = aFragmentSource;
+    program->mSourceHash = Fnv1a(program->mFragmentSource, Fnv1a(program->mVertexSource));
+
+    std::lock_guard lock{ mMutex };
+
+    // Every panel asking for the same sources shares the one program.
+    auto [it, inserted] = mPrograms.try_emplace(program->mSourceHash, program);
+    if (inserted)
+    {
+        mQueue.push_back(program);
+        mCondition.notify_one();
+    }
+
+    return it->second;
+}
+
+void GlProgramManager::StartWorker()
+{
+    mWorker = std::thread([this]()
+    {
+        WorkerMain();
+    });
+}
+
+void GlProgramManager::WorkerMain()
+{
+    SDL_GL_MakeCurrent(mHiddenWindow, mWorkerContext);
+    LoadGlFunctions();
+
+    for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+    {
+        const char* value = reinterpret_cast<const char*>(glGetString(name));
+        mDriver += value ? value : "";
+        mDriver += '\n';
+    }
+
+    // Plenty of 3.3 drivers expose program binaries through the extension alone.
+    GLint binaryFormats = 0;
+    if (GLAD_GL_VERSION_4_1 || GLAD_GL_ARB_get_program_binary)
+    {
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binaryFormats);
+    }
+    mSupportsBinaries = (0 < binaryFormats);
+
+    if (char* prefPath = SDL_GetPrefPath("playmer", "SDL3_Qt_Example"))
+    {
+        mCacheDirectory = prefPath;
+        SDL_free(prefPath);
+    }
+
+    while (true)
+    {
+        std::shared_ptr<GlProgram> program;
+
+        {
+            std::unique_lock lock{ mMutex };
+            mCondition.wait(lock, [this]()
+            {
+                return mStopping || !mQueue.empty();
+            });
+
+            if (mStopping)
+            {
+                break;
+            }
+
+            program = std::move(mQueue.front());
+            mQueue.pop_front();
+        }
+
+        Build(*program);
+    }
+
+    SDL_GL_MakeCurrent(mHiddenWindow, nullptr);
+}
+
+void GlProgramManager::Build(GlProgram& aProgram)
+{
+    Uint64 start = SDL_GetTicksNS();
+
+    std::string cachePath;
+    if (mSupportsBinaries && !mCacheDirectory.empty())
+    {
+        // Chained rather than xor'd, so two programs can't cancel each other out on
+        // some other driver.
+        char name[64];
+        snprintf(name, sizeof(name), "gl_program_%016" PRIx64 ".bin", Fnv1a(mDriver, aProgram.mSourceHash));
+        cachePath = mCacheDirectory + name;
+    }
+
+    bool fromCache = false;
+    GLuint program = cachePath.empty() ? 0 : LoadCachedBinary(cachePath);
+
+    if (0 != program)
+    {
+        fromCache = true;
+    }
+    else
+    {
+        program = CompileAndLink(aProgram);
+
+        if ((0 != program) && !cachePath.empty())
+        {
+            SaveBinary(program, cachePath);
+        }
+    }
+
+    if (0 == program)
+    {
+        aProgram.mFailed.store(true, std::memory_order_release);
+        return;
+    }
+
+    // Other contexts in the group only see the program once this context is done with it.
+    glFinish();
+    aProgram.mProgram.store(program, std::memory_order_release);
+
+    printf("GL program %016" PRIx64 " ready in %.2f ms (%s)\n",
+        aProgram.mSourceHash,
+        (double)(SDL_GetTicksNS() - start) / (double)SDL_NS_PER_MS,
+        fromCache ? "binary cache" : "compiled");
+}
+
+unsigned int GlProgramManager::LoadCachedBinary(const std::string& aPath)
+{
+    size_t size = 0;
+    void* data = SDL_LoadFile(aPath.c_str(), &size);
+
+    if (nullptr == data)
+    {
+        return 0;
+    }
+
+    // The file is the binary format enum followed by the binary itself.
+    GLuint program = 0;
+    if (size > sizeof(GLenum))
+    {
+        GLenum format;
+        memcpy(&format, data, sizeof(format));
+
+        program = glCreateProgram();
+        glProgramBinary(program, format, static_cast<const char*>(data) + sizeof(format), (GLsizei)(size - sizeof(format)));
+
+        // Drivers are free to reject binaries, after an update for instance, in which case
+        // we go back to source.
+        GLint status = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &status);
+        if (GL_TRUE != status)
+        {
+            printf("Cached GL program %s was rejected by the driver, recompiling\n", aPath.c_str());
+            glDeleteProgram(program);
+            program = 0;
+        }
+    }
+
+    SDL_free(data);
+    return program;
+}
+
+unsigned int GlProgramManager::CompileAndLink(GlProgram& aProgram)
+{
+    const char* vertexSource = aProgram.mVertexSource.c_str();
+    const char* fragmentSource = aProgram.mFragmentSource.c_str();
+
+    GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(vertexShader, 1, &vertexSource, NULL);
+    glCompileShader(vertexShader);
+
+    GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(fragmentShader, 1, &fragmentSource, NULL);
+    glCompileShader(fragmentShader);
+
+    GLuint program = 0;
+    if (CheckShader(vertexShader, "vertex") && CheckShader(fragmentShader, "fragment"))
+    {
+        program = glCreateProgram();
+
+        if (mSupportsBinaries)
+        {
+            glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        }
+
+        glAttachShader(program, vertexShader);
+        glAttachShader(program, fragmentShader);
+        glLinkProgram(program);
+
+        GLint status = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &status);
+        if (GL_TRUE != status)
+        {
+            char log[1024] = {};
+            glGetProgramInfoLog(program, sizeof(log), nullptr, log);
+            printf("Failed to link GL program:\n%s\n", log);
+            glDeleteProgram(program);
+            program = 0;
+        }
+        else
+        {
+            glDetachShader(program, vertexShader);
+            glDetachShader(program, fragmentShader);
+        }
+    }
+
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+    return program;
+}
+
+void GlProgramManager::SaveBinary(unsigned int aProgram, const std::string& aPath)
+{
+    GLint length = 0;
+    glGetProgramiv(aProgram, GL_PROGRAM_BINARY_LENGTH, &length);
+
+    if (0 >= length)
+    {
+        return;
+    }
+
+    std::vector<char> data(sizeof(GLenum) + (size_t)length);
+    GLenum format = 0;
+    glGetProgramBinary(aProgram, length, nullptr, &format, data.data() + sizeof(GLenum));
+    memcpy(data.data(), &format, sizeof(format));
+
+    if (!SDL_SaveFile(aPath.c_str(), data.data(), data.size()))
+    {
+        printf("Failed to write GL program cache %s: %s\n", aPath.c_str(), SDL_GetError());
+    }
+}
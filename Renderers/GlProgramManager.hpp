@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include "SDL3/SDL.h"
+
+// glad keeps its function pointers in globals. Every context is in the same share group on
+// the same driver, so they're loaded once, by whichever thread first has a context current.
+// Loading walks the extension list and allocates, so it isn't something to do per frame.
+void LoadGlFunctions();
+
+// A linked GL program that may still be compiling on the worker.
+class GlProgram
+{
+public:
+    // 0 until the program is linked and usable from any context in the share group.
+    unsigned int Get() const { return mProgram.load(std::memory_order_acquire); }
+    bool Failed() const { return mFailed.load(std::memory_order_acquire); }
+
+private:
+    friend class GlProgramManager;
+
+    std::string mVertexSource;
+    std::string mFragmentSource;
+    uint64_t mSourceHash = 0;
+    std::atomic<unsigned int> mProgram = 0;
+    std::atomic<bool> mFailed = false;
+};
+
+// Owns the GL share group every OpenGL3_3Renderer context belongs to, plus a worker thread
+// with its own context in that group. Programs are compiled and linked on the worker,
+// deduplicated across panels by source, and cached on disk with glGetProgramBinary keyed
+// by source hash and driver string so later runs can skip the compiler entirely.
+class GlProgramManager
+{
+public:
+    static GlProgramManager& Get();
+
+    ~GlProgramManager();
+
+    // Creates a context for aWindow in the shared group. GUI thread only, as with any
+    // other SDL window call. The context is left current on the calling thread.
+    SDL_GLContext CreateContext(SDL_Window* aWindow);
+
+    // Never blocks, the returned program becomes usable once the worker gets to it.
+    std::shared_ptr<GlProgram> RequestProgram(const char* aVertexSource, const char* aFragmentSource);
+
+private:
+    GlProgramManager() = default;
+
+    void StartWorker();
+    void WorkerMain();
+    void Build(GlProgram& aProgram);
+    unsigned int LoadCachedBinary(const std::string& aPath);
+    unsigned int CompileAndLink(GlProgram& aProgram);
+    void SaveBinary(unsigned int aProgram, const std::string& aPath);
+
+    std::mutex mContextMutex;
+    SDL_Window* mHiddenWindow = nullptr;
+    SDL_GLContext mRootContext = nullptr;
+    SDL_GLContext mWorkerContext = nullptr;
+
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::deque<std::shared_ptr<GlProgram>> mQueue;
+    std::unordered_map<uint64_t, std::shared_ptr<GlProgram>> mPrograms;
+    std::thread mWorker;
+    bool mStopping = false;
+
+    // Only touched by the worker.
+    std::string mCacheDirectory;
+    std::string mDriver;
+    bool mSupportsBinaries = false;
+};
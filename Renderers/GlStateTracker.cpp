@@ -0,0 +1,207 @@
+#include <algorithm>
+
+#include "Renderers/GlStateTracker.hpp"
+
+void GlStateTracker::Invalidate()
+{
+    mProgram = cUnknown;
+    mVertexArray = cUnknown;
+    mBuffers.fill(cUnknown);
+    mActiveTexture = cUnknown;
+    mTextures2D.fill(cUnknown);
+
+    mBlend = Flag::Unknown;
+    mBlendSource = cUnknown;
+    mBlendDestination = cUnknown;
+    mDepthTest = Flag::Unknown;
+    mDepthMask = Flag::Unknown;
+    mDepthFunc = cUnknown;
+
+    mViewportKnown = false;
+    mClearColorKnown = false;
+}
+
+bool GlStateTracker::Changed(bool aChanged)
+{
+    ++(aChanged ? mStats.mCallsIssued : mStats.mCallsDropped);
+    return aChanged;
+}
+
+bool GlStateTracker::SetFlag(Flag& aFlag, bool aEnabled)
+{
+    Flag flag = aEnabled ? Flag::On : Flag::Off;
+    if (!Changed(aFlag != flag))
+    {
+        return false;
+    }
+
+    aFlag = flag;
+    return true;
+}
+
+int GlStateTracker::BufferTargetIndex(GLenum aTarget)
+{
+    switch (aTarget)
+    {
+        case GL_ARRAY_BUFFER: return ArrayBuffer;
+        case GL_ELEMENT_ARRAY_BUFFER: return ElementArrayBuffer;
+        case GL_UNIFORM_BUFFER: return UniformBuffer;
+        case GL_PIXEL_UNPACK_BUFFER: return PixelUnpackBuffer;
+        case GL_COPY_WRITE_BUFFER: return CopyWriteBuffer;
+        default: return -1;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Bindings:
+void GlStateTracker::UseProgram(GLuint aProgram)
+{
+    if (Changed(mProgram != aProgram))
+    {
+        mProgram = aProgram;
+        glUseProgram(aProgram);
+    }
+}
+
+void GlStateTracker::BindVertexArray(GLuint aVertexArray)
+{
+    if (Changed(mVertexArray != aVertexArray))
+    {
+        mVertexArray = aVertexArray;
+        glBindVertexArray(aVertexArray);
+
+        // The element array binding is part of the vertex array, and we don't know what
+        // the new one has.
+        mBuffers[ElementArrayBuffer] = cUnknown;
+    }
+}
+
+void GlStateTracker::BindBuffer(GLenum aTarget, GLuint aBuffer)
+{
+    int index = BufferTargetIndex(aTarget);
+    if (index < 0)
+    {
+        Changed(true);
+        glBindBuffer(aTarget, aBuffer);
+        return;
+    }
+
+    if (Changed(mBuffers[index] != aBuffer))
+    {
+        mBuffers[index] = aBuffer;
+        glBindBuffer(aTarget, aBuffer);
+    }
+}
+
+void GlStateTracker::BindTexture(GLuint aUnit, GLenum aTarget, GLuint aTexture)
+{
+    if (Changed(mActiveTexture != aUnit))
+    {
+        mActiveTexture = aUnit;
+        glActiveTexture(GL_TEXTURE0 + aUnit);
+    }
+
+    if ((GL_TEXTURE_2D != aTarget) || (aUnit >= cTextureUnits))
+    {
+        Changed(true);
+        glBindTexture(aTarget, aTexture);
+        return;
+    }
+
+    if (Changed(mTextures2D[aUnit] != aTexture))
+    {
+        mTextures2D[aUnit] = aTexture;
+        glBindTexture(aTarget, aTexture);
+    }
+}
+
+void GlStateTracker::OnBufferDeleted(GLuint aBuffer)
+{
+    std::replace(mBuffers.begin(), mBuffers.end(), aBuffer, (GLuint)0);
+}
+
+void GlStateTracker::OnTextureDeleted(GLuint aTexture)
+{
+    std::replace(mTextures2D.begin(), mTextures2D.end(), aTexture, (GLuint)0);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Fixed function:
+void GlStateTracker::SetBlend(bool aEnabled)
+{
+    if (SetFlag(mBlend, aEnabled))
+    {
+        if (aEnabled)
+        {
+            glEnable(GL_BLEND);
+        }
+        else
+        {
+            glDisable(GL_BLEND);
+        }
+    }
+}
+
+void GlStateTracker::SetBlendFunc(GLenum aSource, GLenum aDestination)
+{
+    if (Changed((mBlendSource != aSource) || (mBlendDestination != aDestination)))
+    {
+        mBlendSource = aSource;
+        mBlendDestination = aDestination;
+        glBlendFunc(aSource, aDestination);
+    }
+}
+
+void GlStateTracker::SetDepthTest(bool aEnabled)
+{
+    if (SetFlag(mDepthTest, aEnabled))
+    {
+        if (aEnabled)
+        {
+            glEnable(GL_DEPTH_TEST);
+        }
+        else
+        {
+            glDisable(GL_DEPTH_TEST);
+        }
+    }
+}
+
+void GlStateTracker::SetDepthMask(bool aEnabled)
+{
+    if (SetFlag(mDepthMask, aEnabled))
+    {
+        glDepthMask(aEnabled ? GL_TRUE : GL_FALSE);
+    }
+}
+
+void GlStateTracker::SetDepthFunc(GLenum aFunction)
+{
+    if (Changed(mDepthFunc != aFunction))
+    {
+        mDepthFunc = aFunction;
+        glDepthFunc(aFunction);
+    }
+}
+
+void GlStateTracker::SetViewport(GLint aX, GLint aY, GLsizei aWidth, GLsizei aHeight)
+{
+    std::array<GLint, 4> viewport = { aX, aY, aWidth, aHeight };
+    if (Changed(!mViewportKnown || (mViewport != viewport)))
+    {
+        mViewport = viewport;
+        mViewportKnown = true;
+        glViewport(aX, aY, aWidth, aHeight);
+    }
+}
+
+void GlStateTracker::SetClearColor(float aRed, float aGreen, float aBlue, float aAlpha)
+{
+    std::array<float, 4> clearColor = { aRed, aGreen, aBlue, aAlpha };
+    if (Changed(!mClearColorKnown || (mClearColor != clearColor)))
+    {
+        mClearColor = clearColor;
+        mClearColorKnown = true;
+        glClearColor(aRed, aGreen, aBlue, aAlpha);
+    }
+}
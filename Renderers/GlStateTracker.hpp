@@ -0,0 +1,99 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "glad/glad.h"
+
+// Shadows the GL state a context has bound so calls that wouldn't change anything never
+// reach the driver. One per context, since that's what the state belongs to, and only
+// correct as long as everything that touches the context goes through it; anything that
+// doesn't has to be followed by Invalidate.
+class GlStateTracker
+{
+public:
+    struct Stats
+    {
+        uint64_t mCallsIssued = 0;
+        uint64_t mCallsDropped = 0;
+    };
+
+    static constexpr size_t cTextureUnits = 16;
+
+    GlStateTracker() { Invalidate(); }
+
+    // Forgets everything, the next call of every kind goes through.
+    void Invalidate();
+
+    void UseProgram(GLuint aProgram);
+    void BindVertexArray(GLuint aVertexArray);
+
+    // GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER, GL_UNIFORM_BUFFER, GL_PIXEL_UNPACK_BUFFER
+    // and GL_COPY_WRITE_BUFFER are shadowed, other targets always go through.
+    void BindBuffer(GLenum aTarget, GLuint aBuffer);
+
+    // Only GL_TEXTURE_2D is shadowed. Selects aUnit as the active texture unit if it isn't.
+    void BindTexture(GLuint aUnit, GLenum aTarget, GLuint aTexture);
+
+    // Forgets a deleted object, GL unbinds it on deletion and a new one may reuse the name.
+    void OnBufferDeleted(GLuint aBuffer);
+    void OnTextureDeleted(GLuint aTexture);
+
+    void SetBlend(bool aEnabled);
+    void SetBlendFunc(GLenum aSource, GLenum aDestination);
+    void SetDepthTest(bool aEnabled);
+    void SetDepthMask(bool aEnabled);
+    void SetDepthFunc(GLenum aFunction);
+    void SetViewport(GLint aX, GLint aY, GLsizei aWidth, GLsizei aHeight);
+    void SetClearColor(float aRed, float aGreen, float aBlue, float aAlpha);
+
+    // Since the last ResetStats.
+    const Stats& GetStats() const { return mStats; }
+    void ResetStats() { mStats = {}; }
+
+private:
+    // Tri-state, so a flag nobody has set yet isn't mistaken for one that's off.
+    enum class Flag : uint8_t
+    {
+        Unknown,
+        Off,
+        On
+    };
+
+    static constexpr GLuint cUnknown = ~0u;
+
+    enum BufferTarget
+    {
+        ArrayBuffer,
+        ElementArrayBuffer,
+        UniformBuffer,
+        PixelUnpackBuffer,
+        CopyWriteBuffer,
+        BufferTargetCount
+    };
+
+    // Counts the call and returns whether it has to be made.
+    bool Changed(bool aChanged);
+    bool SetFlag(Flag& aFlag, bool aEnabled);
+    static int BufferTargetIndex(GLenum aTarget);
+
+    GLuint mProgram = cUnknown;
+    GLuint mVertexArray = cUnknown;
+    std::array<GLuint, BufferTargetCount> mBuffers;
+    GLuint mActiveTexture = cUnknown;
+    std::array<GLuint, cTextureUnits> mTextures2D;
+
+    Flag mBlend = Flag::Unknown;
+    GLenum mBlendSource = cUnknown;
+    GLenum mBlendDestination = cUnknown;
+    Flag mDepthTest = Flag::Unknown;
+    Flag mDepthMask = Flag::Unknown;
+    GLenum mDepthFunc = cUnknown;
+
+    std::array<GLint, 4> mViewport;
+    std::array<float, 4> mClearColor;
+    bool mViewportKnown = false;
+    bool mClearColorKnown = false;
+
+    Stats mStats;
+};
@@ -0,0 +1,220 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "SDL3/SDL.h"
+
+#include "Renderers/GlStateTracker.hpp"
+#include "Renderers/GlStreamBuffer.hpp"
+
+static GlStreamBuffer::Mode PickMode()
+{
+    bool supportsStorage = GLAD_GL_VERSION_4_4 || GLAD_GL_ARB_buffer_storage;
+
+    // For comparing the paths on a driver that supports all of them.
+    if (const char* forced = SDL_getenv("GL_STREAM_BUFFER"))
+    {
+        if (0 == strcmp(forced, "orphan"))
+        {
+            return GlStreamBuffer::Mode::Orphan;
+        }
+        else if (0 == strcmp(forced, "unsynchronized"))
+        {
+            return GlStreamBuffer::Mode::Unsynchronized;
+        }
+        else if ((0 == strcmp(forced, "persistent")) && !supportsStorage)
+        {
+            printf("GL_STREAM_BUFFER=persistent needs ARB_buffer_storage, mapping unsynchronized instead\n");
+        }
+    }
+
+    return supportsStorage ? GlStreamBuffer::Mode::Persistent : GlStreamBuffer::Mode::Unsynchronized;
+}
+
+void GlStreamBuffer::Initialize(GlStateTracker& aState, GLenum aTarget, size_t aSegmentSize)
+{
+    mTarget = aTarget;
+    mSegmentSize = aSegmentSize;
+    mMode = PickMode();
+
+    // Orphaning gets a fresh buffer from the driver every frame, there's nothing to ring.
+    mSegments = (Mode::Orphan == mMode) ? 1 : cSegmentCount;
+
+    Create(aState);
+}
+
+void GlStreamBuffer::Destroy(GlStateTracker& aState)
+{
+    Release(aState);
+}
+
+void GlStreamBuffer::Create(GlStateTracker& aState)
+{
+    glGenBuffers(1, &mBuffer);
+    aState.BindBuffer(mTarget, mBuffer);
+    ++mGeneration;
+
+    GLsizeiptr size = (GLsizeiptr)Capacity();
+
+    if (Mode::Persistent == mMode)
+    {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(mTarget, size, nullptr, flags);
+        mPersistent = static_cast<unsigned char*>(glMapBufferRange(mTarget, 0, size, flags));
+
+        if (nullptr == mPersistent)
+        {
+            printf("Failed to persistently map the stream buffer, mapping unsynchronized instead\n");
+            mMode = Mode::Unsynchronized;
+            Release(aState);
+            Create(aState);
+        }
+    }
+    else
+    {
+        glBufferData(mTarget, size, nullptr, GL_STREAM_DRAW);
+    }
+}
+
+void GlStreamBuffer::Release(GlStateTracker& aState)
+{
+    for (GLsync& fence : mFences)
+    {
+        if (nullptr != fence)
+        {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+
+    if (0 != mBuffer)
+    {
+        // Deleting a mapped buffer unmaps it, and GL keeps it alive for draws in flight.
+        glDeleteBuffers(1, &mBuffer);
+        aState.OnBufferDeleted(mBuffer);
+        mBuffer = 0;
+    }
+
+    mPersistent = nullptr;
+    mMapped = nullptr;
+}
+
+void GlStreamBuffer::WaitForSegment(size_t aSegment)
+{
+    GLsync& fence = mFences[aSegment];
+    if (nullptr == fence)
+    {
+        return;
+    }
+
+    // Checked without waiting first, with enough segments the GPU is never this far behind.
+    GLenum result = glClientWaitSync(fence, 0, 0);
+    if ((GL_ALREADY_SIGNALED != result) && (GL_CONDITION_SATISFIED != result))
+    {
+        ++mStats.mStalls;
+        glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+    }
+
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
+void GlStreamBuffer::BeginFrame(GlStateTracker& aState)
+{
+    // Commands are executed in order, so this fence covers every draw that read the
+    // previous frame's segment.
+    if ((Mode::Orphan != mMode) && (0 != mBuffer))
+    {
+        mFences[mSegment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    if (0 != mRequired)
+    {
+        // Page aligned so a frame that needs a few more bytes than the last doesn't get its
+        // own reallocation.
+        size_t size = std::min(((mRequired + 4095) / 4096) * 4096, cMaxSegmentSize);
+        mRequired = 0;
+
+        if (size > mSegmentSize)
+        {
+            mSegmentSize = size;
+            Release(aState);
+            Create(aState);
+        }
+    }
+
+    mSegment = (mSegment + 1) % mSegments;
+    mUsed = 0;
+
+    GLintptr offset = (GLintptr)(mSegment * mSegmentSize);
+
+    switch (mMode)
+    {
+        case Mode::Persistent:
+        {
+            WaitForSegment(mSegment);
+            mMapped = mPersistent + offset;
+            break;
+        }
+        case Mode::Unsynchronized:
+        {
+            // The fence did the synchronizing, the driver doesn't need to.
+            WaitForSegment(mSegment);
+            aState.BindBuffer(mTarget, mBuffer);
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_FLUSH_EXPLICIT_BIT;
+            mMapped = static_cast<unsigned char*>(glMapBufferRange(mTarget, offset, (GLsizeiptr)mSegmentSize, flags));
+            break;
+        }
+        case Mode::Orphan:
+        {
+            aState.BindBuffer(mTarget, mBuffer);
+            glBufferData(mTarget, (GLsizeiptr)mSegmentSize, nullptr, GL_STREAM_DRAW);
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_FLUSH_EXPLICIT_BIT;
+            mMapped = static_cast<unsigned char*>(glMapBufferRange(mTarget, 0, (GLsizeiptr)mSegmentSize, flags));
+            break;
+        }
+    }
+}
+
+GlStreamBuffer::Allocation GlStreamBuffer::Allocate(size_t aBytes, size_t aAlignment)
+{
+    // Aligned in the buffer rather than the segment, so vertex offsets can be turned into
+    // a first vertex by dividing by the stride.
+    size_t base = mSegment * mSegmentSize;
+    size_t start = (((base + mUsed + aAlignment - 1) / aAlignment) * aAlignment) - base;
+
+    if (nullptr == mMapped)
+    {
+        return {};
+    }
+
+    if ((start + aBytes) > mSegmentSize)
+    {
+        // Everything that did fit plus everything that didn't, alignment included.
+        ++mStats.mOverflows;
+        mRequired = std::max(mRequired, mUsed) + aBytes + aAlignment;
+        return {};
+    }
+
+    mUsed = start + aBytes;
+
+    Allocation allocation;
+    allocation.mData = mMapped + start;
+    allocation.mOffset = (GLintptr)(base + start);
+    return allocation;
+}
+
+void GlStreamBuffer::Flush(GlStateTracker& aState)
+{
+    if ((Mode::Persistent != mMode) && (nullptr != mMapped))
+    {
+        aState.BindBuffer(mTarget, mBuffer);
+        if (0 != mUsed)
+        {
+            glFlushMappedBufferRange(mTarget, 0, (GLsizeiptr)mUsed);
+        }
+        glUnmapBuffer(mTarget);
+    }
+
+    mMapped = nullptr;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "glad/glad.h"
+
+class GlStateTracker;
+
+// A ring of buffer segments for data written once a frame, like dynamic vertices. Each
+// frame writes into its own segment, and a segment is only handed out again once the fence
+// from the last frame that used it has signalled, so the CPU never writes over something
+// the GPU is still reading and the driver never has to synchronize behind our back.
+//
+// Where ARB_buffer_storage (or GL 4.4) is available the buffer is mapped once, persistently
+// and coherently. Otherwise each frame maps its segment with glMapBufferRange unsynchronized,
+// or, set with GL_STREAM_BUFFER=orphan, orphans the whole buffer and lets the driver rename it.
+class GlStreamBuffer
+{
+public:
+    enum class Mode
+    {
+        Persistent,
+        Unsynchronized,
+        Orphan
+    };
+
+    struct Allocation
+    {
+        void* mData = nullptr;  // nullptr if the frame's segment is full.
+        GLintptr mOffset = 0;   // Into Buffer().
+    };
+
+    struct Stats
+    {
+        // Frames whose segment was still in use by the GPU and had to be waited for.
+        uint64_t mStalls = 0;
+
+        // Allocations that didn't fit, the buffer grows at the start of the next frame to
+        // what that frame asked for, up to cMaxSegmentSize.
+        uint64_t mOverflows = 0;
+    };
+
+    static constexpr size_t cSegmentCount = 3;
+    static constexpr size_t cMaxSegmentSize = 16 * 1024 * 1024;
+
+    // Needs the context current and functions loaded.
+    void Initialize(GlStateTracker& aState, GLenum aTarget, size_t aSegmentSize);
+    void Destroy(GlStateTracker& aState);
+
+    // Fences everything issued since the last BeginFrame against the previous segment, and
+    // moves to the next one, waiting on it only if the GPU is that far behind.
+    void BeginFrame(GlStateTracker& aState);
+
+    // Memory to write this frame's data to. Valid until Flush.
+    Allocation Allocate(size_t aBytes, size_t aAlignment);
+
+    // Makes what was written visible to GL. Only persistent mappings can be drawn from while
+    // mapped, so this has to come between the last write and the first draw.
+    void Flush(GlStateTracker& aState);
+
+    GLuint Buffer() const { return mBuffer; }
+
+    // Changes every time Buffer() is a new buffer object. Drivers happily hand a deleted
+    // buffer's name out again, so the name alone can't tell whoever points at it.
+    uint64_t Generation() const { return mGeneration; }
+    Mode GetMode() const { return mMode; }
+    size_t Capacity() const { return mSegmentSize * mSegments; }
+    const Stats& GetStats() const { return mStats; }
+
+private:
+    void Create(GlStateTracker& aState);
+    void Release(GlStateTracker& aState);
+    void WaitForSegment(size_t aSegment);
+
+    GLenum mTarget = 0;
+    GLuint mBuffer = 0;
+    uint64_t mGeneration = 0;
+    Mode mMode = Mode::Unsynchronized;
+    size_t mSegmentSize = 0;
+    size_t mSegments = cSegmentCount;
+
+    // Persistent mode keeps the whole buffer mapped here, the others map a segment a frame.
+    unsigned char* mPersistent = nullptr;
+    unsigned char* mMapped = nullptr;
+
+    size_t mSegment = 0;
+    size_t mUsed = 0;
+
+    // What this frame would have needed once something didn't fit, 0 while everything has.
+    size_t mRequired = 0;
+    std::array<GLsync, cSegmentCount> mFences = {};
+
+    Stats mStats;
+};
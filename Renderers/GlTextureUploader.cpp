@@ -0,0 +1,99 @@
+#include <cstring>
+
+#include "Renderers/GlStateTracker.hpp"
+#include "Renderers/GlTextureUploader.hpp"
+
+void GlTextureUploader::Initialize(size_t aStagingBytesPerFrame)
+{
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &mMaxTextureSize);
+    mStaging.Initialize(mState, GL_PIXEL_UNPACK_BUFFER, aStagingBytesPerFrame);
+    mState.BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    mPending.reserve(64);
+}
+
+void GlTextureUploader::BeginUploads()
+{
+    mStaging.BeginFrame(mState);
+    mPending.clear();
+}
+
+void GlTextureUploader::EndUploads()
+{
+    // Nothing can be read out of the staging buffer until it's been flushed and, if it
+    // isn't persistently mapped, unmapped.
+    mStaging.Flush(mState);
+
+    if (!mPending.empty())
+    {
+        // With an unpack buffer bound, the pixel pointer is an offset into it.
+        mState.BindBuffer(GL_PIXEL_UNPACK_BUFFER, mStaging.Buffer());
+
+        for (const PendingUpload& upload : mPending)
+        {
+            mState.BindTexture(0, GL_TEXTURE_2D, upload.mTexture);
+            glTexImage2D(GL_TEXTURE_2D, upload.mLevel, GL_RGBA8, upload.mWidth, upload.mHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, (const void*)upload.mOffset);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, upload.mLevel);
+        }
+    }
+
+    // Anything else that uploads expects to be reading from client memory.
+    mState.BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+uint64_t GlTextureUploader::CreateTexture(uint32_t aWidth, uint32_t aHeight, uint32_t aMipCount)
+{
+    if ((aWidth > (uint32_t)mMaxTextureSize) || (aHeight > (uint32_t)mMaxTextureSize))
+    {
+        return 0;
+    }
+
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    mState.BindTexture(0, GL_TEXTURE_2D, texture);
+
+    // Only [base, max] has to be defined for the texture to be complete, and the base
+    // starts out at the coarsest mip, which is the first one to arrive.
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, (GLint)aMipCount - 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)aMipCount - 1);
+
+    mBytes[texture] = 0;
+    return texture;
+}
+
+bool GlTextureUploader::UploadMip(uint64_t aTexture, uint32_t aLevel, uint32_t aWidth, uint32_t aHeight, const uint8_t* aPixels)
+{
+    size_t bytes = (size_t)aWidth * aHeight * 4;
+
+    // Rows of RGBA8 are always 4 byte aligned, which is what GL_UNPACK_ALIGNMENT defaults to.
+    GlStreamBuffer::Allocation staging = mStaging.Allocate(bytes, 4);
+    if (nullptr == staging.mData)
+    {
+        return false;
+    }
+
+    memcpy(staging.mData, aPixels, bytes);
+    mPending.push_back(PendingUpload{ (GLuint)aTexture, (GLint)aLevel, (GLsizei)aWidth, (GLsizei)aHeight, staging.mOffset });
+
+    mBytes[(GLuint)aTexture] += bytes;
+    mTextureBytes += bytes;
+    return true;
+}
+
+void GlTextureUploader::DestroyTexture(uint64_t aTexture)
+{
+    GLuint texture = (GLuint)aTexture;
+
+    // GL holds on to it until the draws that use it are done.
+    glDeleteTextures(1, &texture);
+    mState.OnTextureDeleted(texture);
+
+    if (auto it = mBytes.find(texture); it != mBytes.end())
+    {
+        mTextureBytes -= it->second;
+        mBytes.erase(it);
+    }
+}
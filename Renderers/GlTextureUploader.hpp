@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "glad/glad.h"
+
+#include "Renderers/GlStreamBuffer.hpp"
+#include "Renderers/TextureStreamer.hpp"
+
+class GlStateTracker;
+
+// Uploads through a pixel unpack buffer. A frame's mips are written into a GlStreamBuffer
+// segment and glTexImage2D copies them into their textures from there, so the driver can
+// do the transfer asynchronously rather than copying out of our memory before returning.
+// Levels are only defined as they arrive and the base level follows the finest one, so a
+// texture only takes up memory for the mips it has.
+class GlTextureUploader : public TextureUploader
+{
+public:
+    explicit GlTextureUploader(GlStateTracker& aState)
+        : mState{ aState }
+    {
+    }
+
+    // Needs the context current and functions loaded. Staging grows if a frame needs more.
+    void Initialize(size_t aStagingBytesPerFrame);
+
+    void BeginUploads() override;
+    void EndUploads() override;
+    uint64_t CreateTexture(uint32_t aWidth, uint32_t aHeight, uint32_t aMipCount) override;
+    bool UploadMip(uint64_t aTexture, uint32_t aLevel, uint32_t aWidth, uint32_t aHeight, const uint8_t* aPixels) override;
+    void DestroyTexture(uint64_t aTexture) override;
+
+    // What's been uploaded into textures that are still around.
+    uint64_t TextureBytes() const { return mTextureBytes; }
+    size_t StagingCapacity() const { return mStaging.Capacity(); }
+
+private:
+    struct PendingUpload
+    {
+        GLuint mTexture = 0;
+        GLint mLevel = 0;
+        GLsizei mWidth = 0;
+        GLsizei mHeight = 0;
+        GLintptr mOffset = 0;
+    };
+
+    GlStateTracker& mState;
+    GlStreamBuffer mStaging;
+    std::vector<PendingUpload> mPending;
+    GLint mMaxTextureSize = 0;
+
+    // GL won't tell us how big a texture is, so we count per texture what went into it.
+    std::unordered_map<GLuint, uint64_t> mBytes;
+    uint64_t mTextureBytes = 0;
+};
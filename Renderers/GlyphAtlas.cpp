@@ -0,0 +1,226 @@
+#include <cmath>
+#include <cstring>
+
+#include "Renderers/GlyphAtlas.hpp"
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Rasterizing:
+static std::mutex gRasterizerMutex;
+static GlyphRasterizer gRasterizer;
+
+void SetGlyphRasterizer(GlyphRasterizer aRasterizer)
+{
+    std::lock_guard lock{ gRasterizerMutex };
+    gRasterizer = std::move(aRasterizer);
+}
+
+static GlyphRasterizer GetGlyphRasterizer()
+{
+    std::lock_guard lock{ gRasterizerMutex };
+    return gRasterizer;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// GlyphAtlas:
+GlyphAtlas& GlyphAtlas::Shared()
+{
+    static GlyphAtlas atlas;
+    return atlas;
+}
+
+GlyphAtlas::GlyphAtlas()
+{
+    mPixels.resize((size_t)cSize * cSize);
+    mAdded.reserve(1024);
+}
+
+size_t GlyphAtlas::MaxQuads(std::span<const TextRun> aRuns)
+{
+    // A codepoint is at least a byte.
+    size_t bytes = 0;
+    for (const TextRun& run : aRuns)
+    {
+        bytes += run.mText.size();
+    }
+
+    return bytes;
+}
+
+size_t GlyphAtlas::GlyphCount() const
+{
+    std::lock_guard lock{ mMutex };
+    return mGlyphs.size();
+}
+
+size_t GlyphAtlas::Layout(std::span<const TextRun> aRuns, float aWidth, float aHeight, std::span<GlyphQuad> aQuads)
+{
+    size_t count = 0;
+    uint64_t generation = mGeneration;
+
+    // If the atlas fills up and is cleared partway through, the quads laid out before that
+    // point at glyphs that are gone. The second pass starts over without clearing, and
+    // leaves out whatever doesn't fit.
+    for (bool allowClear : { true, false })
+    {
+        count = 0;
+
+        for (const TextRun& run : aRuns)
+        {
+            float color[4] = { run.mColor.r / 255.f, run.mColor.g / 255.f, run.mColor.b / 255.f, run.mColor.a / 255.f };
+            float lineX = run.mOrigin.x * aWidth;
+            float x = lineX;
+            float baseline = std::round(run.mOrigin.y * aHeight);
+
+            const char* text = run.mText.data();
+            size_t remaining = run.mText.size();
+
+            while ((0 != remaining) && (count < aQuads.size()))
+            {
+                Uint32 codepoint = SDL_StepUTF8(&text, &remaining);
+                if ('\n' == codepoint)
+                {
+                    x = lineX;
+                    baseline += std::round(run.mPixelSize * 1.25f);
+                    continue;
+                }
+
+                const Glyph* glyph = Find(codepoint, run.mPixelSize, allowClear);
+                if (nullptr == glyph)
+                {
+                    continue;
+                }
+
+                // Snapped to whole pixels, so each texel lands on exactly one.
+                if (0 != glyph->mRect.w)
+                {
+                    float left = std::round(x) + glyph->mLeft;
+                    float top = baseline + glyph->mTop;
+
+                    GlyphQuad& quad = aQuads[count++];
+                    quad.mRect[0] = left / aWidth;
+                    quad.mRect[1] = top / aHeight;
+                    quad.mRect[2] = (left + glyph->mRect.w) / aWidth;
+                    quad.mRect[3] = (top + glyph->mRect.h) / aHeight;
+                    quad.mUv[0] = glyph->mRect.x / (float)cSize;
+                    quad.mUv[1] = glyph->mRect.y / (float)cSize;
+                    quad.mUv[2] = (glyph->mRect.x + glyph->mRect.w) / (float)cSize;
+                    quad.mUv[3] = (glyph->mRect.y + glyph->mRect.h) / (float)cSize;
+                    memcpy(quad.mColor, color, sizeof(color));
+                }
+
+                x += glyph->mAdvance;
+            }
+        }
+
+        if (generation == mGeneration)
+        {
+            break;
+        }
+    }
+
+    return count;
+}
+
+const GlyphAtlas::Glyph* GlyphAtlas::Find(char32_t aCodepoint, float aPixelSize, bool aAllowClear)
+{
+    uint64_t key = (uint64_t)aCodepoint | ((uint64_t)std::lround(aPixelSize * 64.0f) << 32);
+    if (auto it = mGlyphs.find(key); it != mGlyphs.end())
+    {
+        return &it->second;
+    }
+
+    mScratch.mWidth = 0;
+    mScratch.mHeight = 0;
+    mScratch.mLeft = 0;
+    mScratch.mTop = 0;
+    mScratch.mAdvance = 0.0f;
+    mScratch.mCoverage.clear();
+
+    // Glyphs that fail are kept as blanks, so they're only tried once.
+    Glyph glyph;
+    GlyphRasterizer rasterizer = GetGlyphRasterizer();
+    if (rasterizer && rasterizer(aCodepoint, aPixelSize, mScratch))
+    {
+        glyph.mLeft = mScratch.mLeft;
+        glyph.mTop = mScratch.mTop;
+        glyph.mAdvance = mScratch.mAdvance;
+
+        bool hasPixels = (0 != mScratch.mWidth) && (0 != mScratch.mHeight)
+            && (mScratch.mCoverage.size() >= (size_t)mScratch.mWidth * mScratch.mHeight);
+
+        // A pixel of padding right and below keeps linear filtering from pulling in the
+        // neighbours, everything to the left and above is some other glyph's padding.
+        SDL_Rect rect;
+        if (hasPixels && !Pack(mScratch.mWidth + 1, mScratch.mHeight + 1, rect))
+        {
+            if (!aAllowClear)
+            {
+                return nullptr;
+            }
+
+            // Clearing rather than evicting keeps this simple, and text that needs more than
+            // a whole atlas at once is the only way to get here every frame.
+            Clear();
+            hasPixels = Pack(mScratch.mWidth + 1, mScratch.mHeight + 1, rect);
+        }
+
+        if (hasPixels)
+        {
+            for (uint32_t y = 0; y < mScratch.mHeight; ++y)
+            {
+                memcpy(mPixels.data() + (size_t)(rect.y + y) * cSize + rect.x, mScratch.mCoverage.data() + (size_t)y * mScratch.mWidth, mScratch.mWidth);
+            }
+
+            glyph.mRect = SDL_Rect{ rect.x, rect.y, (int)mScratch.mWidth, (int)mScratch.mHeight };
+            mAdded.push_back(rect);
+        }
+    }
+
+    return &mGlyphs.emplace(key, glyph).first->second;
+}
+
+bool GlyphAtlas::Pack(uint32_t aWidth, uint32_t aHeight, SDL_Rect& aRect)
+{
+    // Shelf heights are rounded up so nearby sizes share them.
+    uint32_t height = (aHeight + 3) & ~3u;
+    if ((aWidth > cSize) || (height > cSize))
+    {
+        return false;
+    }
+
+    Shelf* best = nullptr;
+    for (Shelf& shelf : mShelves)
+    {
+        if ((height <= shelf.mHeight) && ((shelf.mUsed + aWidth) <= cSize) && ((nullptr == best) || (shelf.mHeight < best->mHeight)))
+        {
+            best = &shelf;
+        }
+    }
+
+    // Rather than wasting more than half of a taller shelf, start a new one if there's room.
+    if (((nullptr == best) || (best->mHeight > 2 * height)) && ((mShelvesBottom + height) <= cSize))
+    {
+        mShelves.push_back(Shelf{ mShelvesBottom, height, 0 });
+        mShelvesBottom += height;
+        best = &mShelves.back();
+    }
+
+    if (nullptr == best)
+    {
+        return false;
+    }
+
+    aRect = SDL_Rect{ (int)best->mUsed, (int)best->mY, (int)aWidth, (int)aHeight };
+    best->mUsed += aWidth;
+    return true;
+}
+
+void GlyphAtlas::Clear()
+{
+    std::fill(mPixels.begin(), mPixels.end(), (uint8_t)0);
+    mGlyphs.clear();
+    mShelves.clear();
+    mShelvesBottom = 0;
+    mAdded.clear();
+    ++mGeneration;
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "SDL3/SDL.h"
+
+#include "Renderers/Renderer.hpp"
+
+// A glyph's coverage, one byte per pixel with rows top to bottom. mLeft and mTop are where
+// the bitmap's top left corner sits relative to the pen on the baseline, y down.
+struct GlyphBitmap
+{
+    uint32_t mWidth = 0;
+    uint32_t mHeight = 0;
+    int32_t mLeft = 0;
+    int32_t mTop = 0;
+    float mAdvance = 0.0f;
+    std::vector<uint8_t> mCoverage;
+};
+
+// Rasterizes a glyph, called with the atlas locked from whichever thread is rendering.
+// Renderers don't come with one, so hosts have to install one before any text is drawn.
+using GlyphRasterizer = std::function<bool(char32_t aCodepoint, float aPixelSize, GlyphBitmap& aGlyph)>;
+void SetGlyphRasterizer(GlyphRasterizer aRasterizer);
+
+// A glyph as backends draw it, one instance of a four vertex strip. The rect is left, top,
+// right and bottom normalized to the viewport with y down, uv is the same in the atlas.
+struct GlyphQuad
+{
+    float mRect[4];
+    float mUv[4];
+    float mColor[4];
+};
+
+// How far a backend's copy of the atlas is up to date.
+struct GlyphAtlasCursor
+{
+    uint64_t mGeneration = 0;
+    size_t mUploaded = 0;
+};
+
+// One 8 bit coverage atlas shared by every panel, so a glyph is only rasterized once no
+// matter how many panels draw it. Glyphs are packed into shelves as they're first drawn
+// and every one added is logged, so each backend only uploads what's been added since its
+// last frame, merged into a rect per shelf. Once the atlas is full it's cleared, and every
+// backend's next upload is the whole of it.
+class GlyphAtlas
+{
+public:
+    static constexpr uint32_t cSize = 1024;
+
+    static GlyphAtlas& Shared();
+
+    // Enough quads for anything Prepare can make of aRuns.
+    static size_t MaxQuads(std::span<const TextRun> aRuns);
+
+    // Lays aRuns out for an aWidth by aHeight pixel viewport into aQuads and returns how
+    // many were written, rasterizing any glyph that isn't in the atlas yet. Then hands
+    // aUpload every rect of the atlas aCursor's copy doesn't have yet, as
+    // (const SDL_Rect&, const uint8_t* aPixels, size_t aPitch) with aPixels at the rect's
+    // top left. All under the lock, so the quads and the uploads always agree.
+    template <typename tUpload>
+    size_t Prepare(std::span<const TextRun> aRuns, float aWidth, float aHeight, std::span<GlyphQuad> aQuads, GlyphAtlasCursor& aCursor, tUpload&& aUpload)
+    {
+        std::lock_guard lock{ mMutex };
+        size_t quadCount = Layout(aRuns, aWidth, aHeight, aQuads);
+
+        if (aCursor.mGeneration != mGeneration)
+        {
+            // Everything that's ever been in it, the rows below are never sampled.
+            if (0 != mShelvesBottom)
+            {
+                aUpload(SDL_Rect{ 0, 0, (int)cSize, (int)mShelvesBottom }, mPixels.data(), (size_t)cSize);
+            }
+        }
+        else
+        {
+            // Glyphs are added left to right along a shelf, so consecutive ones in the same
+            // shelf merge into one rect.
+            SDL_Rect pending = {};
+            for (size_t i = aCursor.mUploaded; i < mAdded.size(); ++i)
+            {
+                const SDL_Rect& added = mAdded[i];
+                if ((0 != pending.w) && (added.y == pending.y))
+                {
+                    pending.w = added.x + added.w - pending.x;
+                    pending.h = std::max(pending.h, added.h);
+                    continue;
+                }
+
+                if (0 != pending.w)
+                {
+                    aUpload(pending, mPixels.data() + (size_t)pending.y * cSize + pending.x, (size_t)cSize);
+                }
+
+                pending = added;
+            }
+
+            if (0 != pending.w)
+            {
+                aUpload(pending, mPixels.data() + (size_t)pending.y * cSize + pending.x, (size_t)cSize);
+            }
+        }
+
+        aCursor.mGeneration = mGeneration;
+        aCursor.mUploaded = mAdded.size();
+        return quadCount;
+    }
+
+    size_t GlyphCount() const;
+
+private:
+    struct Glyph
+    {
+        SDL_Rect mRect = {};
+        int32_t mLeft = 0;
+        int32_t mTop = 0;
+        float mAdvance = 0.0f;
+    };
+
+    struct Shelf
+    {
+        uint32_t mY = 0;
+        uint32_t mHeight = 0;
+        uint32_t mUsed = 0;
+    };
+
+    GlyphAtlas();
+
+    size_t Layout(std::span<const TextRun> aRuns, float aWidth, float aHeight, std::span<GlyphQuad> aQuads);
+    const Glyph* Find(char32_t aCodepoint, float aPixelSize, bool aAllowClear);
+    bool Pack(uint32_t aWidth, uint32_t aHeight, SDL_Rect& aRect);
+    void Clear();
+
+    mutable std::mutex mMutex;
+    std::vector<uint8_t> mPixels;
+
+    // Keyed by codepoint and pixel size.
+    std::unordered_map<uint64_t, Glyph> mGlyphs;
+    std::vector<Shelf> mShelves;
+    uint32_t mShelvesBottom = 0;
+
+    // Every glyph rect since the last clear, padding included, in the order they were added.
+    std::vector<SDL_Rect> mAdded;
+    uint64_t mGeneration = 1;
+
+    GlyphBitmap mScratch;
+};
@@ -1,4 +1,7 @@
+#include <algorithm>
+#include <cstddef>
 #include <cstdio>
+#include <cstring>
 
 #define SDL_FUNCTION_POINTER_IS_VOID_POINTER
 #include "SDL3/SDL.h"
@@ -6,6 +9,7 @@
 #include "glad/glad.h"
 
 #include "Renderers/Renderer.hpp"
+#include "Renderers/GlProgramManager.hpp"
 #include "Renderers/OpenGL3_3Renderer.hpp"
 
 
@@ -23,6 +27,54 @@ const char *fragmentShaderSource = "#version 330 core\n"
     "    FragColor = vec4(1.0f, 0.5f, 0.2f, 1.0f);\n"
     "} \0";
 
+// A quad from four vertex IDs drawn as a strip, uRect being its left, top, right and bottom
+// in clip space.
+const char *imageVertexShaderSource = "#version 330 core\n"
+    "uniform vec4 uRect;\n"
+    "out vec2 vUv;\n"
+    "void main()\n"
+    "{\n"
+    "   vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);\n"
+    "   vUv = corner;\n"
+    "   gl_Position = vec4(mix(uRect.x, uRect.z, corner.x), mix(uRect.y, uRect.w, corner.y), 0.0, 1.0);\n"
+    "}\0";
+
+const char *imageFragmentShaderSource = "#version 330 core\n"
+    "uniform sampler2D uImage;\n"
+    "in vec2 vUv;\n"
+    "out vec4 FragColor;\n"
+    "void main()\n"
+    "{\n"
+    "    FragColor = texture(uImage, vUv);\n"
+    "} \0";
+
+// One glyph quad per instance, from the same four vertex strip as the images.
+const char *textVertexShaderSource = "#version 330 core\n"
+    "layout (location = 0) in vec4 aRect;\n"
+    "layout (location = 1) in vec4 aUv;\n"
+    "layout (location = 2) in vec4 aColor;\n"
+    "out vec2 vUv;\n"
+    "out vec4 vColor;\n"
+    "void main()\n"
+    "{\n"
+    "   vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);\n"
+    "   vec2 position = mix(aRect.xy, aRect.zw, corner);\n"
+    "   vUv = mix(aUv.xy, aUv.zw, corner);\n"
+    "   vColor = aColor;\n"
+    "   gl_Position = vec4(position.x * 2.0 - 1.0, 1.0 - position.y * 2.0, 0.0, 1.0);\n"
+    "}\0";
+
+const char *textFragmentShaderSource = "#version 330 core\n"
+    "uniform sampler2D uAtlas;\n"
+    "in vec2 vUv;\n"
+    "in vec4 vColor;\n"
+    "out vec4 FragColor;\n"
+    "void main()\n"
+    "{\n"
+    "    float alpha = vColor.a * texture(uAtlas, vUv).r;\n"
+    "    FragColor = vec4(vColor.rgb * alpha, alpha);\n"
+    "} \0";
+
 
 static char const* Source(GLenum source)
 {
@@ -90,6 +142,27 @@ static void APIENTRY messageCallback(GLenum source,
 }
 
 
+// For calls that can come from the GUI thread while another thread renders, a context can
+// only be current on one thread at a time so it's let go of again on the way out.
+class ScopedCurrentContext
+{
+public:
+    ScopedCurrentContext(SDL_Window* aWindow, SDL_GLContext aContext)
+        : mWindow{ aWindow }
+    {
+        SDL_GL_MakeCurrent(aWindow, aContext);
+    }
+
+    ~ScopedCurrentContext()
+    {
+        SDL_GL_MakeCurrent(mWindow, nullptr);
+    }
+
+private:
+    SDL_Window* mWindow;
+};
+
+
 std::unique_ptr<Renderer> CreateOpenGL3_3Renderer(SDL_Window* aWindow)
 {
     return std::unique_ptr<Renderer>(new OpenGL3_3Renderer(aWindow));
@@ -98,43 +171,24 @@ std::unique_ptr<Renderer> CreateOpenGL3_3Renderer(SDL_Window* aWindow)
 OpenGL3_3Renderer::OpenGL3_3Renderer(SDL_Window* aWindow)
 	: Renderer{ aWindow }
 {
-    
-    // Decide GL+GLSL versions
-#if defined(IMGUI_IMPL_OPENGL_ES2)
-    // GL ES 2.0 + GLSL 100
-    const char* glsl_version = "#version 100";
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, 0);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_ES);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 2);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 0);
-#elif defined(__APPLE__)
-    // GL 3.2 Core + GLSL 150
-    const char* glsl_version = "#version 150";
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, SDL_GL_CONTEXT_FORWARD_COMPATIBLE_FLAG); // Always required on Mac
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 2);
-#else
-    // GL 3.3 + GLSL 130
-    const char* glsl_version = "#version 330";
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, 0);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 0);
-#endif
-
-    // Create window with graphics context
-    SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
-    SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
-    SDL_GL_SetAttribute(SDL_GL_STENCIL_SIZE, 8);
-
-
-    mGlContext = SDL_GL_CreateContext(mWindow);
-    SDL_GL_MakeCurrent(mWindow, mGlContext);
+    // Every panel's context is in the same share group, so programs only get built once.
+    mGlContext = GlProgramManager::Get().CreateContext(mWindow);
+
+    // Initialize runs on a worker thread, and a context can only be current on one thread 
+    // at a time, so let go of it here.
+    SDL_GL_MakeCurrent(mWindow, nullptr);
+}
+
+bool OpenGL3_3Renderer::Initialize()
+{
+    if ((nullptr == mGlContext) || !SDL_GL_MakeCurrent(mWindow, mGlContext))
+    {
+        printf("Failed to make the GL context current. Error: %s\n", SDL_GetError());
+        return false;
+    }
 
-    gladLoadGLLoader(SDL_GL_GetProcAddress);
+    LoadGlFunctions();
 
-        
     glEnable(GL_DEBUG_OUTPUT);
 
     // FIXME: This doesn't work on Apple when I tested it, need to look into this more on 
@@ -142,63 +196,411 @@ OpenGL3_3Renderer::OpenGL3_3Renderer(SDL_Window* aWindow)
     #if defined(_WIN32)
         glDebugMessageCallback(messageCallback, this);
     #endif
-        
-    vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-    glCompileShader(vertexShader);
 
-    fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-    glCompileShader(fragmentShader);
+    // Compiled (or pulled from the binary cache) on the program manager's thread, we draw
+    // without it until it's ready.
+    mProgram = GlProgramManager::Get().RequestProgram(vertexShaderSource, fragmentShaderSource);
+    mImageProgram = GlProgramManager::Get().RequestProgram(imageVertexShaderSource, imageFragmentShaderSource);
+    mTextProgram = GlProgramManager::Get().RequestProgram(textVertexShaderSource, textFragmentShaderSource);
+
+    if (const char* draws = SDL_getenv("GL_RENDERER_DRAWS"))
+    {
+        mDrawCount = std::max(1, atoi(draws));
+    }
+
+    if (const char* queued = SDL_getenv("GL_MAX_QUEUED_FRAMES"))
+    {
+        mFrameLimiter.SetMaxQueuedFrames((size_t)std::max(0, atoi(queued)));
+    }
+
+    glGenVertexArrays(1, &VAO);
+    mVertices.Initialize(mState, GL_ARRAY_BUFFER, cVertexStreamSegmentSize);
+    mTextureUploader.Initialize(mTextures.UploadBudget());
+
+    glGenVertexArrays(1, &mTextVao);
+    mState.BindVertexArray(mTextVao);
+    for (GLuint i = 0; i < 3; ++i)
+    {
+        glEnableVertexAttribArray(i);
+        glVertexAttribDivisor(i, 1);
+    }
 
-    shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-        
-    glUseProgram(shaderProgram);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);  
-        
-    glGenVertexArrays(1, &VAO);  
-        
-    glGenBuffers(1, &VBO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glGenTextures(1, &mGlyphTexture);
+    mState.BindTexture(0, GL_TEXTURE_2D, mGlyphTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, GlyphAtlas::cSize, GlyphAtlas::cSize, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * TriangleVerts.size(), TriangleVerts.data(), GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);  
+    SDL_GL_MakeCurrent(mWindow, nullptr);
+    return true;
 }
 
-void OpenGL3_3Renderer::Initialize()
+void OpenGL3_3Renderer::BindVertexStream()
 {
+    mState.BindVertexArray(VAO);
+
+    if (mVertexGenerationInVao == mVertices.Generation())
+    {
+        return;
+    }
+
+    // Offsets come in through the first vertex of each draw, the pointer stays at zero.
+    mState.BindBuffer(GL_ARRAY_BUFFER, mVertices.Buffer());
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, cVertexStride, (void*)0);
+    glEnableVertexAttribArray(0);
+    mVertexGenerationInVao = mVertices.Generation();
+}
+
+void OpenGL3_3Renderer::DrawImages()
+{
+    // Uploads go out whether or not we can draw yet, so the images are ready when we can.
+    mTextures.Update();
+    mTextureBytes = mTextureUploader.TextureBytes();
+
+    unsigned int program = mImageProgram->Get();
+    if (0 == program)
+    {
+        if (!mImages.empty() && !mImageProgram->Failed())
+        {
+            RequestAnimationFrame();
+        }
+        return;
+    }
+
+    if (-1 == mImageRectLocation)
+    {
+        mImageRectLocation = glGetUniformLocation(program, "uRect");
+    }
+
+    mState.UseProgram(program);
+    mState.BindVertexArray(VAO);
+    mState.SetBlend(false);
+    mState.SetDepthTest(false);
+
+    for (const ImageQuad& image : mImages)
+    {
+        uint64_t texture = mTextures.Acquire(image.mPath);
+        if (0 == texture)
+        {
+            continue;
+        }
+
+        // The rect is normalized with y down, clip space has it up.
+        mState.BindTexture(0, GL_TEXTURE_2D, (GLuint)texture);
+        glUniform4f(mImageRectLocation,
+            image.mRect.x * 2.0f - 1.0f,
+            1.0f - image.mRect.y * 2.0f,
+            (image.mRect.x + image.mRect.w) * 2.0f - 1.0f,
+            1.0f - (image.mRect.y + image.mRect.h) * 2.0f);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    }
+
+    // Keep drawing while there's more on the way, each frame sharpens what's there.
+    if (mTextures.Busy())
+    {
+        RequestAnimationFrame();
+    }
+
+    mTextures.ReportStats(mStats);
+}
+
+size_t OpenGL3_3Renderer::PrepareGlyphs(std::span<GlyphQuad> aQuads, int aWidth, int aHeight)
+{
+    // Uploads come straight from the atlas's memory, rows are a byte per texel and only
+    // the first few of each row of the atlas are ours.
+    mState.BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    mState.BindTexture(0, GL_TEXTURE_2D, mGlyphTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    mStats.mGlyphUploadBytes = 0;
+    uint64_t generation = mGlyphCursor.mGeneration;
+
+    size_t count = GlyphAtlas::Shared().Prepare(mText, (float)aWidth, (float)aHeight, aQuads, mGlyphCursor,
+        [this](const SDL_Rect& aRect, const uint8_t* aPixels, size_t aPitch)
+        {
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, (GLint)aPitch);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, aRect.x, aRect.y, aRect.w, aRect.h, GL_RED, GL_UNSIGNED_BYTE, aPixels);
+            mStats.mGlyphUploadBytes += (uint64_t)aRect.w * aRect.h;
+        });
+
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    if (generation != mGlyphCursor.mGeneration)
+    {
+        ++mStats.mGlyphFullUploads;
+    }
+
+    mStats.mGlyphsCached = GlyphAtlas::Shared().GlyphCount();
+    return count;
+}
+
+void OpenGL3_3Renderer::DrawGlyphs(GLintptr aOffset, size_t aQuadCount)
+{
+    unsigned int program = mTextProgram->Get();
+    if (0 == program)
+    {
+        if (!mTextProgram->Failed())
+        {
+            RequestAnimationFrame();
+        }
+        return;
+    }
+
+    mState.UseProgram(program);
+    mState.BindVertexArray(mTextVao);
+    mState.BindBuffer(GL_ARRAY_BUFFER, mVertices.Buffer());
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(GlyphQuad), (void*)(aOffset + offsetof(GlyphQuad, mRect)));
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(GlyphQuad), (void*)(aOffset + offsetof(GlyphQuad, mUv)));
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(GlyphQuad), (void*)(aOffset + offsetof(GlyphQuad, mColor)));
+
+    mState.BindTexture(0, GL_TEXTURE_2D, mGlyphTexture);
+    mState.SetBlend(true);
+    mState.SetBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    mState.SetDepthTest(false);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)aQuadCount);
 }
 
 void OpenGL3_3Renderer::Update()
 {
     SDL_GL_MakeCurrent(mWindow, mGlContext);
-    gladLoadGLLoader(SDL_GL_GetProcAddress);
+    LoadGlFunctions();
 
     // Rendering
     int width, height;
     SDL_GetWindowSize(mWindow, &width, &height);
 
-    glViewport(0, 0, width, height);
-    glClearColor(mClearColor.r * mClearColor.a, mClearColor.g * mClearColor.a, mClearColor.b * mClearColor.a, mClearColor.a);
+    BeginSubmit();
+    mState.ResetStats();
+
+    // Times come back a frame or two late, and carry the scale they were drawn at.
+    mFrameTimer.Collect([this](double aMs, float aScale)
+    {
+        ReportFrameCost(aMs, aScale);
+    });
+
+    // Frames below full resolution are drawn into the bottom left of a framebuffer the
+    // panel's size, so the scale can change every frame without reallocating it, and
+    // blitted up to the default one after.
+    float scale = GetRenderScale();
+    GLuint scaleFramebuffer = (scale < 1.0f) ? GetScaleFramebuffer(width, height) : 0;
+    int drawWidth = width, drawHeight = height;
+    if (0 != scaleFramebuffer)
+    {
+        ResolutionScaler::ScaleSize(width, height, scale, drawWidth, drawHeight);
+        glBindFramebuffer(GL_FRAMEBUFFER, scaleFramebuffer);
+    }
+
+    mFrameTimer.Begin(scale);
+
+    // Premultiplied, and normalized the way the other backends do it. Neither this nor the
+    // viewport changes often, so both are usually dropped.
+    float alpha = mClearColor.a / 255.f;
+    mState.SetViewport(0, 0, drawWidth, drawHeight);
+    mState.SetClearColor(mClearColor.r / 255.f * alpha, mClearColor.g / 255.f * alpha, mClearColor.b / 255.f * alpha, alpha);
     glClear(GL_COLOR_BUFFER_BIT);
 
-    glUseProgram(shaderProgram);
+    DrawImages();
 
-    glUseProgram(shaderProgram);
-    glBindVertexArray(VAO);
-    glDrawArrays(GL_TRIANGLES, 0, 3);
+    // This frame's vertices, written straight into memory the GPU isn't reading.
+    mVertices.BeginFrame(mState);
+    GlStreamBuffer::Allocation vertices = mVertices.Allocate(sizeof(float) * TriangleVerts.size(), cVertexStride);
+    if (nullptr != vertices.mData)
+    {
+        memcpy(vertices.mData, TriangleVerts.data(), sizeof(float) * TriangleVerts.size());
+    }
+
+    // Glyph quads are laid out straight into the stream, while the atlas uploads whatever
+    // our copy of it is missing.
+    GlStreamBuffer::Allocation glyphs;
+    size_t glyphCount = 0;
+    if (!mText.empty())
+    {
+        size_t maxQuads = GlyphAtlas::MaxQuads(mText);
+        glyphs = mVertices.Allocate(maxQuads * sizeof(GlyphQuad), alignof(GlyphQuad));
+        if (nullptr != glyphs.mData)
+        {
+            glyphCount = PrepareGlyphs(std::span<GlyphQuad>(static_cast<GlyphQuad*>(glyphs.mData), maxQuads), width, height);
+        }
+        else
+        {
+            RequestAnimationFrame();
+        }
+    }
+    mVertices.Flush(mState);
+
+    unsigned int program = mProgram->Get();
+    if ((0 != program) && (nullptr != vertices.mData))
+    {
+        BindVertexStream();
+        GLint firstVertex = (GLint)(vertices.mOffset / cVertexStride);
+
+        // Each draw states everything it needs, as a draw list would, and the tracker
+        // drops whatever's already bound.
+        for (int i = 0; i < mDrawCount; ++i)
+        {
+            mState.UseProgram(program);
+            mState.BindVertexArray(VAO);
+            mState.SetBlend(false);
+            mState.SetDepthTest(false);
+            glDrawArrays(GL_TRIANGLES, firstVertex, 3);
+        }
+    }
+    else if ((0 == program) && !mProgram->Failed())
+    {
+        // Keep checking back until the program manager is done with it.
+        ++mStats.mFramesWithSkippedDraws;
+        RequestAnimationFrame();
+    }
+    else if (nullptr == vertices.mData)
+    {
+        // The stream buffer was full, it's bigger next frame.
+        RequestAnimationFrame();
+    }
+
+    if (0 != glyphCount)
+    {
+        DrawGlyphs(glyphs.mOffset, glyphCount);
+    }
+
+    mFrameTimer.End();
+
+    if (0 != scaleFramebuffer)
+    {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, scaleFramebuffer);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+        glBlitFramebuffer(0, 0, drawWidth, drawHeight, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
 
     SDL_GL_SwapWindow(mWindow);
+
+    mStats.mStateCallsIssued = mState.GetStats().mCallsIssued;
+    mStats.mStateCallsDropped = mState.GetStats().mCallsDropped;
+
+    EndPresent();
+
+    // After the present stats, so they only measure the swap itself.
+    if (0 != mFrameLimiter.GetMaxQueuedFrames())
+    {
+        RecordQueueWait(mFrameLimiter.GetMaxQueuedFrames(), mFrameLimiter.EndFrame());
+    }
+}
+
+GLuint OpenGL3_3Renderer::GetScaleFramebuffer(int aWidth, int aHeight)
+{
+    if ((aWidth == mScaleWidth) && (aHeight == mScaleHeight))
+    {
+        return mScaleFramebuffer;
+    }
+
+    if (0 == mScaleFramebuffer)
+    {
+        glGenFramebuffers(1, &mScaleFramebuffer);
+        glGenRenderbuffers(1, &mScaleRenderbuffer);
+    }
+
+    glBindRenderbuffer(GL_RENDERBUFFER, mScaleRenderbuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, aWidth, aHeight);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, mScaleFramebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, mScaleRenderbuffer);
+    bool complete = (GL_FRAMEBUFFER_COMPLETE == glCheckFramebufferStatus(GL_FRAMEBUFFER));
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    if (!complete)
+    {
+        // Drawn at full resolution instead.
+        printf("Resolution scaling framebuffer of %dx%d is incomplete\n", aWidth, aHeight);
+        mScaleWidth = 0;
+        mScaleHeight = 0;
+        return 0;
+    }
+
+    mScaleWidth = aWidth;
+    mScaleHeight = aHeight;
+    return mScaleFramebuffer;
 }
 
 void OpenGL3_3Renderer::Resize(unsigned int aWidth, unsigned int aHeight)
 {
+    Renderer::Resize(aWidth, aHeight);
+}
+
+void OpenGL3_3Renderer::ReleaseThread()
+{
+    SDL_GL_MakeCurrent(mWindow, nullptr);
+}
+
+MemoryReport OpenGL3_3Renderer::GetMemoryReport()
+{
+    MemoryReport report;
+    report.mEntries.push_back(MemoryEntry{ "Vertex stream", mVertices.Capacity() });
+    report.mEntries.push_back(MemoryEntry{ "Textures", mTextureBytes });
+    report.mEntries.push_back(MemoryEntry{ "Texture staging", mTextureUploader.StagingCapacity() });
+    report.mEntries.push_back(MemoryEntry{ "Glyph atlas", (uint64_t)GlyphAtlas::cSize * GlyphAtlas::cSize });
+    report.mEntries.push_back(MemoryEntry{ "Resolution scaling target", (uint64_t)mScaleWidth * mScaleHeight * 4 });
+
+    // The default framebuffer is whatever the context was created with, the attributes
+    // are read back from the current context.
+    ScopedCurrentContext current{ mWindow, mGlContext };
+
+    int red = 0, green = 0, blue = 0, alpha = 0, depth = 0, stencil = 0, doubleBuffered = 0;
+    SDL_GL_GetAttribute(SDL_GL_RED_SIZE, &red);
+    SDL_GL_GetAttribute(SDL_GL_GREEN_SIZE, &green);
+    SDL_GL_GetAttribute(SDL_GL_BLUE_SIZE, &blue);
+    SDL_GL_GetAttribute(SDL_GL_ALPHA_SIZE, &alpha);
+    SDL_GL_GetAttribute(SDL_GL_DEPTH_SIZE, &depth);
+    SDL_GL_GetAttribute(SDL_GL_STENCIL_SIZE, &stencil);
+    SDL_GL_GetAttribute(SDL_GL_DOUBLEBUFFER, &doubleBuffered);
+
+    int width = 0, height = 0;
+    SDL_GetWindowSizeInPixels(mWindow, &width, &height);
+    uint64_t pixels = (uint64_t)width * height;
+
+    uint64_t colorBytes = pixels * ((red + green + blue + alpha + 7) / 8) * (doubleBuffered ? 2 : 1);
+    report.mEntries.push_back(MemoryEntry{ "Default color buffers", colorBytes, true });
+
+    // We never draw with depth or stencil, this is here so it's obvious what that costs.
+    uint64_t depthStencilBytes = pixels * ((depth + stencil + 7) / 8);
+    report.mEntries.push_back(MemoryEntry{ "Default depth/stencil buffer", depthStencilBytes, true });
+
+    return report;
+}
+
+PresentMode OpenGL3_3Renderer::ApplyPresentMode(PresentMode aMode)
+{
+    ScopedCurrentContext current{ mWindow, mGlContext };
+
+    // GL has no notion of mailbox, the closest we get is plain vsync.
+    switch (aMode)
+    {
+        case PresentMode::Immediate:
+        {
+            if (SDL_GL_SetSwapInterval(0))
+            {
+                return PresentMode::Immediate;
+            }
+            break;
+        }
+        case PresentMode::Adaptive:
+        {
+            // Late swap tearing isn't supported everywhere, fall through to vsync if not.
+            if (SDL_GL_SetSwapInterval(-1))
+            {
+                return PresentMode::Adaptive;
+            }
+            break;
+        }
+        default: break;
+    }
+
+    if (!SDL_GL_SetSwapInterval(1))
+    {
+        printf("SDL Error: %s\n", SDL_GetError());
+    }
 
+    return PresentMode::Fifo;
 }
@@ -1,6 +1,15 @@
 #pragma once
 
+#include "Renderers/GlFrameLimiter.hpp"
+#include "Renderers/GlFrameTimer.hpp"
+#include "Renderers/GlStateTracker.hpp"
+#include "Renderers/GlStreamBuffer.hpp"
+#include "Renderers/GlTextureUploader.hpp"
+#include "Renderers/GlyphAtlas.hpp"
 #include "Renderers/Renderer.hpp"
+#include "Renderers/TextureStreamer.hpp"
+
+class GlProgram;
 
 
 
@@ -9,16 +18,70 @@ class OpenGL3_3Renderer : public Renderer
 public:
 	OpenGL3_3Renderer(SDL_Window* aWindow);
 
-	void Initialize() override;
+	bool Initialize() override;
 	void Update() override;
 	void Resize(unsigned int aWidth, unsigned int aHeight) override;
     virtual const char* Name() override { return "OpenGL3_3Renderer"; };
+    MemoryReport GetMemoryReport() override;
+    void ReleaseThread() override;
+
+protected:
+    PresentMode ApplyPresentMode(PresentMode aMode) override;
 
 private:
-    unsigned int vertexShader;
-    unsigned int fragmentShader;
-    unsigned int shaderProgram;
+    static constexpr size_t cVertexStride = 3 * sizeof(float);
+    static constexpr size_t cVertexStreamSegmentSize = 64 * 1024;
+
+    void BindVertexStream();
+    void DrawImages();
+    size_t PrepareGlyphs(std::span<GlyphQuad> aQuads, int aWidth, int aHeight);
+    void DrawGlyphs(GLintptr aOffset, size_t aQuadCount);
+    GLuint GetScaleFramebuffer(int aWidth, int aHeight);
+
+    std::shared_ptr<GlProgram> mProgram;
     unsigned int VAO;
-    unsigned int VBO;
+
+    // Vertices are written fresh every frame, the VAO is repointed whenever the stream
+    // buffer grows into a new buffer object.
+    GlStreamBuffer mVertices;
+    uint64_t mVertexGenerationInVao = 0;
     SDL_GLContext mGlContext;
+
+    // Everything bound on mGlContext goes through here.
+    GlStateTracker mState;
+
+    // Images come in through the streamer, which uploads them through a pixel unpack
+    // buffer. Quads are generated in the vertex shader, there are no vertices to stream.
+    GlTextureUploader mTextureUploader{ mState };
+    TextureStreamer mTextures{ mTextureUploader };
+    std::shared_ptr<GlProgram> mImageProgram;
+    GLint mImageRectLocation = -1;
+
+    // This context's copy of the shared glyph atlas. Glyph quads are instances streamed
+    // through mVertices, and since GL 3.3 has no base instance the text VAO's attributes are
+    // pointed at each frame's quads.
+    GLuint mGlyphTexture = 0;
+    GlyphAtlasCursor mGlyphCursor;
+    unsigned int mTextVao = 0;
+    std::shared_ptr<GlProgram> mTextProgram;
+
+    // GL_MAX_QUEUED_FRAMES sets the cap, 0 leaves queueing up to the driver.
+    GlFrameLimiter mFrameLimiter;
+
+    // What the resolution scaler is fed, the GPU's time for each frame's drawing.
+    GlFrameTimer mFrameTimer;
+
+    // What frames below full resolution are drawn into, made when the first one is.
+    GLuint mScaleFramebuffer = 0;
+    GLuint mScaleRenderbuffer = 0;
+    int mScaleWidth = 0;
+    int mScaleHeight = 0;
+
+    // How many times the triangle is drawn each frame, GL_RENDERER_DRAWS sets it to give the
+    // state tracker a realistic amount of redundant binds to drop.
+    int mDrawCount = 1;
+
+    // GL won't tell us how big its objects are, so we count what we upload. Buffers are
+    // all in mVertices, which knows its own size.
+    uint64_t mTextureBytes = 0;
 };
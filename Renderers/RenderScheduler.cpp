@@ -0,0 +1,450 @@
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <thread>
+#include <utility>
+
+#include "Renderers/Renderer.hpp"
+#include "Renderers/RenderScheduler.hpp"
+
+#include "Utilities/ThreadPool.hpp"
+
+const char* ThreadingModelName(ThreadingModel aModel)
+{
+    switch (aModel)
+    {
+        case ThreadingModel::GuiThread: return "gui";
+        case ThreadingModel::SharedThread: return "shared";
+        case ThreadingModel::ThreadPerPanel: return "per-panel";
+        case ThreadingModel::Pool: return "pool";
+        default: return "unknown";
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// RenderScheduler:
+void RenderScheduler::Add(Renderer* aRenderer)
+{
+    Panel* panel = nullptr;
+    {
+        std::lock_guard lock{ mPanelsMutex };
+        mPanels.push_back(CreatePanel());
+        panel = mPanels.back().get();
+        panel->mRenderer = aRenderer;
+    }
+
+    aRenderer->SetInvalidatedCallback([this, panel]()
+    {
+        RequestFrame(*panel);
+    });
+
+    // The host may have invalidated before handing it over, without anyone listening.
+    RequestFrame(*panel);
+}
+
+void RenderScheduler::Remove(Renderer* aRenderer)
+{
+    std::unique_ptr<Panel> panel;
+    {
+        std::lock_guard lock{ mPanelsMutex };
+        auto it = std::find_if(mPanels.begin(), mPanels.end(), [aRenderer](const std::unique_ptr<Panel>& aPanel)
+        {
+            return aPanel->mRenderer == aRenderer;
+        });
+
+        if (it == mPanels.end())
+        {
+            return;
+        }
+
+        panel = std::move(*it);
+        mPanels.erase(it);
+    }
+
+    // Callbacks run with the renderer's damage lock held, so once this returns none are
+    // still in flight and no new frames get scheduled.
+    panel->mRemoved = true;
+    aRenderer->SetInvalidatedCallback(nullptr);
+    OnRemoved(*panel);
+}
+
+void RenderScheduler::SetContinuous(Renderer* aRenderer, bool aContinuous)
+{
+    std::lock_guard lock{ mPanelsMutex };
+    for (std::unique_ptr<Panel>& panel : mPanels)
+    {
+        if (panel->mRenderer == aRenderer)
+        {
+            panel->mContinuous = aContinuous;
+
+            if (aContinuous)
+            {
+                aRenderer->RequestAnimationFrame();
+            }
+        }
+    }
+}
+
+bool RenderScheduler::RenderPanel(Panel& aPanel)
+{
+    // Cleared before drawing, so an invalidation that lands mid-frame schedules another.
+    aPanel.mScheduled = false;
+
+    if (aPanel.mRemoved)
+    {
+        return false;
+    }
+
+    auto lock = aPanel.mRenderer->Lock();
+    bool rendered = aPanel.mRenderer->Render();
+    aPanel.mRenderer->ReleaseThread();
+    return rendered;
+}
+
+void RenderScheduler::ContinuePanel(Panel& aPanel)
+{
+    if (aPanel.mContinuous && !aPanel.mRemoved)
+    {
+        aPanel.mRenderer->RequestAnimationFrame();
+    }
+}
+
+void RenderScheduler::RemoveAll()
+{
+    while (true)
+    {
+        Renderer* renderer = nullptr;
+        {
+            std::lock_guard lock{ mPanelsMutex };
+            if (mPanels.empty())
+            {
+                return;
+            }
+
+            renderer = mPanels.back()->mRenderer;
+        }
+
+        Remove(renderer);
+    }
+}
+
+void RenderScheduler::RequestFrame(Panel& aPanel)
+{
+    if (!aPanel.mRemoved && !aPanel.mScheduled.exchange(true))
+    {
+        Schedule(aPanel);
+    }
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// One render thread for every panel:
+class SharedThreadScheduler : public RenderScheduler
+{
+public:
+    SharedThreadScheduler()
+    {
+        mThread = std::thread{ [this]() { ThreadMain(); } };
+    }
+
+    ~SharedThreadScheduler() override
+    {
+        RemoveAll();
+
+        {
+            std::lock_guard lock{ mMutex };
+            mStopping = true;
+        }
+
+        mCondition.notify_all();
+        mThread.join();
+    }
+
+protected:
+    void Schedule(Panel& aPanel) override
+    {
+        {
+            std::lock_guard lock{ mMutex };
+            mReady.push_back(&aPanel);
+        }
+
+        mCondition.notify_all();
+    }
+
+    void OnRemoved(Panel& aPanel) override
+    {
+        std::unique_lock lock{ mMutex };
+        std::erase(mReady, &aPanel);
+
+        // It may be in the round being rendered right now, wait that one out.
+        uint64_t round = mRoundsStarted;
+        mCondition.wait(lock, [this, round]() { return mRoundsFinished >= round; });
+    }
+
+private:
+    void ThreadMain()
+    {
+        std::unique_lock lock{ mMutex };
+
+        while (true)
+        {
+            mCondition.wait(lock, [this]() { return mStopping || !mReady.empty(); });
+
+            if (mStopping)
+            {
+                return;
+            }
+
+            // Everything that became ready since the last round goes in this one, and
+            // their presents go out together at the end of it.
+            std::swap(mReady, mRound);
+            ++mRoundsStarted;
+            lock.unlock();
+
+            for (Panel* panel : mRound)
+            {
+                RenderPanel(*panel);
+            }
+
+            FlushPendingPresents();
+
+            for (Panel* panel : mRound)
+            {
+                ContinuePanel(*panel);
+            }
+
+            mRound.clear();
+
+            lock.lock();
+            ++mRoundsFinished;
+            mCondition.notify_all();
+        }
+    }
+
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::vector<Panel*> mReady;
+    std::vector<Panel*> mRound; // Only touched by the render thread.
+    uint64_t mRoundsStarted = 0;
+    uint64_t mRoundsFinished = 0;
+    bool mStopping = false;
+    std::thread mThread;
+};
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// A render thread per panel:
+class ThreadPerPanelScheduler : public RenderScheduler
+{
+public:
+    ~ThreadPerPanelScheduler() override
+    {
+        RemoveAll();
+    }
+
+protected:
+    struct ThreadPanel : Panel
+    {
+        std::mutex mMutex;
+        std::condition_variable mCondition;
+        bool mWake = false;
+        bool mStopping = false;
+        std::thread mThread;
+    };
+
+    std::unique_ptr<Panel> CreatePanel() override
+    {
+        auto panel = std::make_unique<ThreadPanel>();
+        ThreadPanel* threadPanel = panel.get();
+        threadPanel->mThread = std::thread{ [this, threadPanel]() { ThreadMain(*threadPanel); } };
+        return panel;
+    }
+
+    void Schedule(Panel& aPanel) override
+    {
+        ThreadPanel& panel = static_cast<ThreadPanel&>(aPanel);
+        {
+            std::lock_guard lock{ panel.mMutex };
+            panel.mWake = true;
+        }
+
+        panel.mCondition.notify_one();
+    }
+
+    void OnRemoved(Panel& aPanel) override
+    {
+        ThreadPanel& panel = static_cast<ThreadPanel&>(aPanel);
+        {
+            std::lock_guard lock{ panel.mMutex };
+            panel.mStopping = true;
+        }
+
+        panel.mCondition.notify_one();
+        panel.mThread.join();
+    }
+
+private:
+    void ThreadMain(ThreadPanel& aPanel)
+    {
+        std::unique_lock lock{ aPanel.mMutex };
+
+        while (true)
+        {
+            aPanel.mCondition.wait(lock, [&aPanel]() { return aPanel.mStopping || aPanel.mWake; });
+
+            if (aPanel.mStopping)
+            {
+                return;
+            }
+
+            aPanel.mWake = false;
+            lock.unlock();
+
+            // Every thread flushes after its own frame, whatever else made it into the
+            // batch by then goes along with it.
+            RenderPanel(aPanel);
+            FlushPendingPresents();
+            ContinuePanel(aPanel);
+
+            lock.lock();
+        }
+    }
+};
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Frames as tasks on the work-stealing pool:
+class PoolScheduler : public RenderScheduler
+{
+public:
+    ~PoolScheduler() override
+    {
+        RemoveAll();
+    }
+
+protected:
+    struct PoolPanel : Panel
+    {
+        TaskGroup mGroup;
+
+        // A frame asked for while one is rendering is only submitted once it's done, so it
+        // can't end up on a thread that then blocks on the renderer's lock.
+        std::mutex mMutex;
+        bool mRendering = false;
+        bool mDeferred = false;
+    };
+
+    std::unique_ptr<Panel> CreatePanel() override
+    {
+        return std::make_unique<PoolPanel>();
+    }
+
+    void Schedule(Panel& aPanel) override
+    {
+        PoolPanel& panel = static_cast<PoolPanel&>(aPanel);
+
+        {
+            std::lock_guard lock{ panel.mMutex };
+            if (panel.mRendering)
+            {
+                panel.mDeferred = true;
+                return;
+            }
+        }
+
+        Submit(panel);
+    }
+
+    void OnRemoved(Panel& aPanel) override
+    {
+        mPool.Wait(static_cast<PoolPanel&>(aPanel).mGroup);
+    }
+
+private:
+    // Frames are batched in rounds. Everything submitted goes into the open round, which
+    // closes once one of its frames starts, and whichever of its frames finishes last
+    // flushes. Continuous panels land in later rounds, so they can't hold one open.
+    void Submit(PoolPanel& aPanel)
+    {
+        uint64_t round = 0;
+        {
+            std::lock_guard lock{ mRoundMutex };
+            round = mFirstRound + mRounds.size() - 1;
+            ++mRounds.back();
+        }
+
+        mPool.Submit(aPanel.mGroup, [this, &aPanel, round]()
+        {
+            RunFrame(aPanel, round);
+        });
+    }
+
+    void RunFrame(PoolPanel& aPanel, uint64_t aRound)
+    {
+        {
+            std::lock_guard lock{ mRoundMutex };
+            if (aRound == (mFirstRound + mRounds.size() - 1))
+            {
+                mRounds.push_back(0);
+            }
+        }
+
+        {
+            std::lock_guard lock{ aPanel.mMutex };
+            aPanel.mRendering = true;
+        }
+
+        RenderPanel(aPanel);
+
+        bool deferred = false;
+        {
+            std::lock_guard lock{ aPanel.mMutex };
+            aPanel.mRendering = false;
+            deferred = std::exchange(aPanel.mDeferred, false);
+        }
+
+        bool roundDone = false;
+        {
+            std::lock_guard lock{ mRoundMutex };
+            roundDone = (0 == --mRounds[aRound - mFirstRound]);
+
+            // The open round stays, even when it's empty.
+            while ((1 < mRounds.size()) && (0 == mRounds.front()))
+            {
+                mRounds.pop_front();
+                ++mFirstRound;
+            }
+        }
+
+        if (roundDone)
+        {
+            FlushPendingPresents();
+        }
+
+        ContinuePanel(aPanel);
+
+        if (deferred && !aPanel.mRemoved)
+        {
+            Submit(aPanel);
+        }
+    }
+
+    ThreadPool& mPool = ThreadPool::Shared();
+
+    // Frames yet to finish in each round, oldest first, mFirstRound being the front's id.
+    std::mutex mRoundMutex;
+    std::deque<size_t> mRounds{ 0 };
+    uint64_t mFirstRound = 0;
+};
+
+
+std::unique_ptr<RenderScheduler> CreateRenderScheduler(ThreadingModel aModel)
+{
+    switch (aModel)
+    {
+        case ThreadingModel::SharedThread: return std::make_unique<SharedThreadScheduler>();
+        case ThreadingModel::ThreadPerPanel: return std::make_unique<ThreadPerPanelScheduler>();
+        case ThreadingModel::Pool: return std::make_unique<PoolScheduler>();
+        default: return nullptr;
+    }
+}
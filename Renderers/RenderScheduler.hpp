@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class Renderer;
+
+// Which threads panels are rendered on.
+enum class ThreadingModel
+{
+    GuiThread,      // Everything on the GUI thread, from Qt's update requests.
+    SharedThread,   // One render thread that takes turns with every panel.
+    ThreadPerPanel, // A render thread for each panel.
+    Pool,           // Each frame is a task on the shared work-stealing pool.
+    Count
+};
+
+const char* ThreadingModelName(ThreadingModel aModel);
+
+// Renders panels off the GUI thread. A renderer that's been added is drawn whenever it's
+// invalidated, by whichever thread the model puts it on, and never by two threads at once:
+// Render runs with the renderer's lock held, and batched presents are flushed once each
+// round of renders has finished. Renderers that RequiresGuiThread stay with the host.
+class RenderScheduler
+{
+public:
+    virtual ~RenderScheduler() = default;
+
+    // Takes over the renderer's invalidated callback and schedules its first frame.
+    void Add(Renderer* aRenderer);
+
+    // Blocks until aRenderer isn't being rendered, after which it's the host's again.
+    void Remove(Renderer* aRenderer);
+
+    // Keeps frames coming for aRenderer even when nothing changed.
+    void SetContinuous(Renderer* aRenderer, bool aContinuous);
+
+protected:
+    struct Panel
+    {
+        virtual ~Panel() = default;
+
+        Renderer* mRenderer = nullptr;
+
+        // Set when a frame has been asked for and not yet started, so a burst of
+        // invalidations only queues one.
+        std::atomic<bool> mScheduled = false;
+        std::atomic<bool> mContinuous = false;
+        std::atomic<bool> mRemoved = false;
+    };
+
+    // Implementations that need per panel state hand out their own Panel subclass.
+    virtual std::unique_ptr<Panel> CreatePanel() { return std::make_unique<Panel>(); }
+
+    // Called once per invalidation that found the panel unscheduled, from any thread.
+    virtual void Schedule(Panel& aPanel) = 0;
+
+    // Returns once the panel isn't being rendered and won't be again.
+    virtual void OnRemoved(Panel& aPanel) = 0;
+
+    // Renders one frame for the panel on the calling thread. Returns whether it drew.
+    bool RenderPanel(Panel& aPanel);
+
+    // Asks for the panel's next frame if it's continuous. Called after the flush that
+    // follows RenderPanel, so a round isn't held open by panels that always have more.
+    void ContinuePanel(Panel& aPanel);
+
+    // For implementation destructors, while their Schedule and OnRemoved still exist.
+    void RemoveAll();
+
+private:
+    void RequestFrame(Panel& aPanel);
+
+    std::mutex mPanelsMutex;
+    std::vector<std::unique_ptr<Panel>> mPanels;
+};
+
+// nullptr for ThreadingModel::GuiThread, the host renders everything itself then.
+std::unique_ptr<RenderScheduler> CreateRenderScheduler(ThreadingModel aModel);
@@ -1,5 +1,7 @@
 #include <Renderers/Renderer.hpp>
 
+#include "Utilities/AllocationCounter.hpp"
+
 const std::array<float, 9> Renderer::TriangleVerts = {
 	-0.5f, -0.5f, 0.0f,
 	0.5f, -0.5f, 0.0f,
@@ -7,6 +9,365 @@ const std::array<float, 9> Renderer::TriangleVerts = {
 };  
 
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Helpers:
+static double ElapsedMs(Uint64 aStartNs)
+{
+    return (double)(SDL_GetTicksNS() - aStartNs) / (double)SDL_NS_PER_MS;
+}
+
+// Exponential moving average, seeded by the first sample.
+static void UpdateMovingAverage(double& aAverage, double aSample)
+{
+    static constexpr double cSmoothing = 0.1;
+    aAverage = (0.0 == aAverage) ? aSample : (aAverage + cSmoothing * (aSample - aAverage));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Damage tracking:
+bool Renderer::NeedsRedraw()
+{
+    std::lock_guard lock{ mDamageMutex };
+    return NeedsRedrawLocked();
+}
+
+bool Renderer::NeedsRedrawLocked()
+{
+    // Without a window the host draws us into its own surface and invalidates on resize.
+    if (nullptr == mWindow)
+    {
+        return mDirty || mAnimationRequested || mFullResolutionPending;
+    }
+
+    // The size the host last gave Resize, SDL's window calls belong on the GUI thread and
+    // we may well be on a scheduler thread.
+    if ((mWindowWidth != mLastWidth) || (mWindowHeight != mLastHeight))
+    {
+        mLastWidth = mWindowWidth;
+        mLastHeight = mWindowHeight;
+        mFullDamage = true;
+        mDirty = true;
+    }
+
+    return mDirty || mAnimationRequested || mFullResolutionPending;
+}
+
+void Renderer::Resize(unsigned int aWidth, unsigned int aHeight)
+{
+    std::lock_guard lock{ mDamageMutex };
+    mWindowWidth = (int)aWidth;
+    mWindowHeight = (int)aHeight;
+}
+
+bool Renderer::Render()
+{
+    // Input is drained in one batch per frame, whether or not it ends up changing anything.
+    Uint64 oldestInputNs = 0;
+    size_t drained = mInputQueue.Drain([this, &oldestInputNs](const InputEvent& aEvent)
+    {
+        if (0 == oldestInputNs)
+        {
+            oldestInputNs = aEvent.mTimestampNs;
+        }
+
+        if (OnInput(aEvent))
+        {
+            Invalidate();
+        }
+    });
+
+    uint64_t dropped = mInputQueue.Dropped();
+    bool redraw = false;
+
+    {
+        std::lock_guard lock{ mDamageMutex };
+        redraw = NeedsRedrawLocked();
+
+        if (redraw)
+        {
+            // Nothing but the full resolution frame we owe, so this is it.
+            bool fullResolution = !mDirty && !mAnimationRequested;
+            mFullResolutionPending = mFullResolutionPending && !fullResolution;
+            mFrameScale = fullResolution ? 1.0f : mResolutionScaler.GetScale();
+
+            // Take the damage and clear the flags before Update, so anything that invalidates
+            // while drawing (an animation, or a backend that has to recreate its swapchain)
+            // gets another frame. Swapping keeps both vectors' capacity around.
+            mDirty = false;
+            mAnimationRequested = false;
+            mFrameFullDamage = mFullDamage || fullResolution;
+            std::swap(mFrameDamageRects, mDamageRects);
+            mDamageRects.clear();
+            mFullDamage = false;
+        }
+    }
+
+    if (!redraw)
+    {
+        std::lock_guard lock{ mStatsMutex };
+        mStats.mInputEventsProcessed += drained;
+        mStats.mInputEventsDropped = dropped;
+        return false;
+    }
+
+    mFrameArena.Reset();
+
+    // The counts are this thread's, which is only fair because ThreadPool::Wait never runs
+    // anything but the waited on group's tasks. What Update waits on is part of the frame,
+    // another panel's frame stolen on the way isn't, and can't end up counted here.
+    AllocationCounts allocationsBefore = GetThreadAllocationCounts();
+    Uint64 updateStartNs = SDL_GetTicksNS();
+    Update();
+
+    double cpuFrameMs = ElapsedMs(updateStartNs);
+
+    if (mFrameScale < 1.0f)
+    {
+        // Asked for like an animation frame, hosts schedule it the same way.
+        std::lock_guard lock{ mDamageMutex };
+        bool wasClean = !mDirty && !mAnimationRequested && !mFullResolutionPending;
+        mFullResolutionPending = true;
+
+        if (wasClean && mInvalidatedCallback)
+        {
+            mInvalidatedCallback();
+        }
+    }
+
+    AllocationCounts allocationsAfter = GetThreadAllocationCounts();
+    uint64_t frameAllocations = allocationsAfter.mAllocations - allocationsBefore.mAllocations;
+    uint64_t frameAllocatedBytes = allocationsAfter.mBytes - allocationsBefore.mBytes;
+    double inputToPresentMs = (0 != oldestInputNs) ? ElapsedMs(oldestInputNs) : 0.0;
+    bool firstSteadyStateAllocation = false;
+
+    // Everything the frame measured goes out at once, GetStats may be reading on another
+    // thread.
+    {
+        std::lock_guard lock{ mStatsMutex };
+        mStats.mInputEventsProcessed += drained;
+        mStats.mInputEventsDropped = dropped;
+        UpdateMovingAverage(mStats.mCpuFrameMs, cpuFrameMs);
+        mStats.mRenderScale = mFrameScale;
+        mStats.mFrameAllocations = frameAllocations;
+        mStats.mFrameAllocatedBytes = frameAllocatedBytes;
+
+        if ((++mStats.mFramesRendered > cWarmUpFrames) && (0 != frameAllocations))
+        {
+            firstSteadyStateAllocation = (0 == mStats.mSteadyStateFramesWithAllocations++);
+        }
+
+        if (0 != oldestInputNs)
+        {
+            UpdateMovingAverage(mStats.mInputToPresentMs, inputToPresentMs);
+        }
+    }
+
+    // Steady state frames are meant to be allocation free on every backend, say so the
+    // first time one isn't. The scaling benchmark's --scaling-allocation-free is what
+    // fails a run over it.
+    if (firstSteadyStateAllocation)
+    {
+        printf("%s made %llu heap allocations (%llu bytes) in a steady state frame\n",
+            Name(),
+            (unsigned long long)frameAllocations,
+            (unsigned long long)frameAllocatedBytes);
+    }
+
+    return true;
+}
+
+bool Renderer::PushInput(const InputEvent& aEvent)
+{
+    if (!mInputQueue.Push(aEvent))
+    {
+        return false;
+    }
+
+    // Make sure someone comes around to drain it, every time. A Render that's draining
+    // right now may have looked at the queue before this went in, so the queue not
+    // being empty doesn't mean a frame will pick it up. Hosts already fold repeated
+    // requests into one frame. The queue itself needs no lock, but the callback does,
+    // Remove relies on none running once it's been cleared.
+    {
+        std::lock_guard lock{ mDamageMutex };
+        if (mInvalidatedCallback)
+        {
+            mInvalidatedCallback();
+        }
+    }
+
+    return true;
+}
+
+void Renderer::Invalidate()
+{
+    std::lock_guard lock{ mDamageMutex };
+    mFullDamage = true;
+    mDamageRects.clear();
+    MarkDirty();
+}
+
+void Renderer::Invalidate(const SDL_Rect& aRect)
+{
+    std::lock_guard lock{ mDamageMutex };
+
+    if (!mFullDamage)
+    {
+        mDamageRects.push_back(aRect);
+    }
+
+    MarkDirty();
+}
+
+void Renderer::RequestAnimationFrame()
+{
+    std::lock_guard lock{ mDamageMutex };
+    bool wasClean = !mDirty && !mAnimationRequested;
+    mAnimationRequested = true;
+
+    if (wasClean && mInvalidatedCallback)
+    {
+        mInvalidatedCallback();
+    }
+}
+
+void Renderer::SetInvalidatedCallback(std::function<void()> aCallback)
+{
+    std::lock_guard lock{ mDamageMutex };
+    mInvalidatedCallback = std::move(aCallback);
+}
+
+void Renderer::SetClearColor(color aColor)
+{
+    if (mClearColor != aColor)
+    {
+        mClearColor = aColor;
+        Invalidate();
+    }
+}
+
+void Renderer::SetTriangleColor(color aColor)
+{
+    if (mTriangleColor != aColor)
+    {
+        mTriangleColor = aColor;
+        Invalidate();
+    }
+}
+
+void Renderer::SetImages(std::vector<ImageQuad> aImages)
+{
+    mImages = std::move(aImages);
+    Invalidate();
+}
+
+void Renderer::SetText(std::vector<TextRun> aText)
+{
+    mText = std::move(aText);
+    Invalidate();
+}
+
+void Renderer::MarkDirty()
+{
+    bool wasClean = !mDirty && !mAnimationRequested;
+    mDirty = true;
+
+    if (wasClean && mInvalidatedCallback)
+    {
+        mInvalidatedCallback();
+    }
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Presentation:
+const char* PresentModeName(PresentMode aMode)
+{
+    switch (aMode)
+    {
+        case PresentMode::Fifo: return "Fifo";
+        case PresentMode::Mailbox: return "Mailbox";
+        case PresentMode::Immediate: return "Immediate";
+        case PresentMode::Adaptive: return "Adaptive";
+        default: return "Unknown";
+    }
+}
+
+PresentMode Renderer::SetPresentMode(PresentMode aMode)
+{
+    PresentMode applied = ApplyPresentMode(aMode);
+
+    std::unique_lock lock{ mStatsMutex };
+    if (applied != mPresentMode)
+    {
+        mPresentMode = applied;
+        mThroughputWindowStartNs = 0;
+        mThroughputWindowFrames = 0;
+    }
+    lock.unlock();
+
+    Invalidate();
+    return applied;
+}
+
+RendererStats Renderer::GetStats() const
+{
+    std::lock_guard lock{ mStatsMutex };
+    return mStats;
+}
+
+void Renderer::BeginSubmit()
+{
+    std::lock_guard lock{ mStatsMutex };
+    mSubmitStartNs = SDL_GetTicksNS();
+}
+
+void Renderer::RecordQueueWait(size_t aMaxQueuedFrames, Uint64 aWaitNs)
+{
+    std::lock_guard lock{ mStatsMutex };
+    mStats.mMaxQueuedFrames = aMaxQueuedFrames;
+    UpdateMovingAverage(mStats.mQueueWaitMs, (double)aWaitNs / (double)SDL_NS_PER_MS);
+}
+
+void Renderer::ReportFrameCost(double aMs, float aScale)
+{
+    mResolutionScaler.AddFrame(aMs, aScale);
+
+    std::lock_guard lock{ mStatsMutex };
+    mStats.mFrameCostMs = mResolutionScaler.GetAverageMs();
+    mStats.mFrameBudgetMs = mResolutionScaler.GetBudgetMs();
+}
+
+void Renderer::EndPresent(size_t aFramesPerSubmit)
+{
+    static constexpr Uint64 cThroughputWindowNs = SDL_NS_PER_SECOND;
+
+    std::lock_guard lock{ mStatsMutex };
+    Uint64 now = SDL_GetTicksNS();
+    mStats.mFramesPerSubmit = aFramesPerSubmit;
+    PresentModeStats& stats = mStats.mPresentModes[(size_t)mPresentMode];
+
+    UpdateMovingAverage(stats.mSubmitToPresentMs, ElapsedMs(mSubmitStartNs));
+    ++stats.mFramesPresented;
+
+    if (0 == mThroughputWindowStartNs)
+    {
+        mThroughputWindowStartNs = now;
+        mThroughputWindowFrames = 0;
+        return;
+    }
+
+    ++mThroughputWindowFrames;
+
+    Uint64 elapsed = now - mThroughputWindowStartNs;
+    if (elapsed >= cThroughputWindowNs)
+    {
+        stats.mFramesPerSecond = (double)mThroughputWindowFrames * (double)SDL_NS_PER_SECOND / (double)elapsed;
+        mThroughputWindowStartNs = now;
+        mThroughputWindowFrames = 0;
+    }
+}
+
 
 std::unique_ptr<Renderer> CreateRenderer(SDL_Window* aWindow, RendererType aType, const char* aRenderBackend)
 {
@@ -22,6 +383,14 @@ std::unique_ptr<Renderer> CreateRenderer(SDL_Window* aWindow, RendererType aType
 			case RendererType::VkRenderer: return CreateVkRenderer(aWindow);
 		#endif // HAVE_VULKAN
             case RendererType::SdlRenderRenderer: return CreateSdlRenderRenderer(aWindow, aRenderBackend);
+            case RendererType::SoftwareRenderer: return CreateSoftwareRenderer(aWindow);
 		default: printf("No renderer of type %d", (int)aType);  return nullptr;
 	}
 }
+
+void FlushPendingPresents()
+{
+    #ifdef HAVE_VULKAN
+        FlushVkPendingPresents();
+    #endif // HAVE_VULKAN
+}
@@ -1,9 +1,18 @@
 #pragma once
 
 #include <array>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
 #include "SDL3/SDL.h"
 
+#include "Renderers/ResolutionScaler.hpp"
+
+#include "Utilities/FrameArena.hpp"
+#include "Utilities/SpscQueue.hpp"
+
 class Renderer;
 
 class Dx11Renderer;
@@ -14,10 +23,14 @@ class OpenGL3_3Renderer;
 std::unique_ptr<Renderer> CreateOpenGL3_3Renderer(SDL_Window*);
 class VkRenderer;
 std::unique_ptr<Renderer> CreateVkRenderer(SDL_Window*);
+void FlushVkPendingPresents();
 class SdlRenderRenderer;
 std::unique_ptr<Renderer> CreateSdlRenderRenderer(SDL_Window*, const char* aRenderBackend);
+std::unique_ptr<Renderer> CreateSdlSurfaceRenderer(SDL_Surface*);
 class SdlGpuRenderer;
 std::unique_ptr<Renderer> CreateSdlGpuRenderer(SDL_Window*, const char* aRenderBackend);
+class SoftwareRenderer;
+std::unique_ptr<Renderer> CreateSoftwareRenderer(SDL_Window*);
 
 enum class RendererType
 {
@@ -26,15 +39,189 @@ enum class RendererType
 	OpenGL3_3Renderer,
 	VkRenderer,
     SdlRenderRenderer,
-    SdlGpuRenderer
+    SdlGpuRenderer,
+    SoftwareRenderer
 };
 
 std::unique_ptr<Renderer> CreateRenderer(SDL_Window* aWindow, RendererType aType, const char* aRenderBackend);
 
+// Some backends (Vulkan) don't submit or present from Render, they queue the frame so every
+// panel on the device goes to the GPU in one batch. Hosts call this after a round of Render
+// calls to send those batches off.
+void FlushPendingPresents();
+
+
+// Uniform presentation setting across backends, each maps it onto whatever its swapchain
+// or swap interval API offers and falls back to Fifo when it can't.
+enum class PresentMode
+{
+    Fifo,      // Vsync, frames queue up behind each other.
+    Mailbox,   // Vsync, the newest frame replaces whatever is queued.
+    Immediate, // No vsync, may tear.
+    Adaptive,  // Vsync, unless we missed the interval, then tear.
+    Count
+};
+
+const char* PresentModeName(PresentMode aMode);
+
+struct PresentModeStats
+{
+    uint64_t mFramesPresented = 0;
+
+    // Exponential moving average of the time from the backend starting to submit a frame
+    // to its present call returning, on the CPU.
+    double mSubmitToPresentMs = 0.0;
+
+    // Presented frames per second, measured over roughly one second windows.
+    double mFramesPerSecond = 0.0;
+};
+
+struct RendererStats
+{
+    // Exponential moving average of the CPU time spent in Update.
+    double mCpuFrameMs = 0.0;
+    uint64_t mFramesRendered = 0;
+
+    // Kept per mode so switching back and forth lets us compare them.
+    std::array<PresentModeStats, (size_t)PresentMode::Count> mPresentModes;
+
+    // Exponential moving average of the time from the oldest input event drained in a
+    // frame being received to that frame's present returning.
+    double mInputToPresentMs = 0.0;
+    uint64_t mInputEventsProcessed = 0;
+    uint64_t mInputEventsDropped = 0;
+
+    // Frames drawn while a pipeline or program they needed was still being built, either
+    // with a simpler fallback or with the draw left out entirely.
+    uint64_t mFramesWithFallbackPipeline = 0;
+    uint64_t mFramesWithSkippedDraws = 0;
+
+    // For backends that batch submission across panels, how many frames went out in the
+    // same submit as this panel's last one.
+    size_t mFramesPerSubmit = 0;
+
+    // For backends that shadow API state, the state calls made during the last Update and
+    // how many more were dropped for not changing anything.
+    uint64_t mStateCallsIssued = 0;
+    uint64_t mStateCallsDropped = 0;
+
+    // For backends that cap how many frames the driver may queue, the cap and an average of
+    // how long each frame waited for older ones to finish to stay under it.
+    size_t mMaxQueuedFrames = 0;
+    double mQueueWaitMs = 0.0;
+
+    // For backends that stream images in, what's on the GPU against the budget, how many are
+    // still being read, decoded or uploaded, and how many were evicted to stay under it.
+    size_t mTexturesResident = 0;
+    size_t mTexturesStreaming = 0;
+    uint64_t mTextureResidentBytes = 0;
+    uint64_t mTextureBudgetBytes = 0;
+    uint64_t mTextureEvictions = 0;
+
+    // For backends that draw text, glyphs in the shared atlas, what the last Update uploaded
+    // into this panel's copy of it, and how many times that had to be the whole atlas.
+    size_t mGlyphsCached = 0;
+    uint64_t mGlyphUploadBytes = 0;
+    uint64_t mGlyphFullUploads = 0;
+
+    // For backends that draw through a render graph, the passes it runs each frame, the ones
+    // culled for drawing into nothing anyone reads, the barriers it records, and the memory
+    // saved by placing transients that are never alive at the same time together.
+    uint32_t mGraphPasses = 0;
+    uint32_t mGraphPassesCulled = 0;
+    uint32_t mGraphBarriers = 0;
+    uint64_t mGraphAliasingSavedBytes = 0;
+
+    // For backends that scale their resolution to a frame time budget, the scale the last
+    // frame was drawn at, and what frames cost at it against the budget. 0 budget when
+    // scaling is off.
+    float mRenderScale = 1.0f;
+    double mFrameCostMs = 0.0;
+    double mFrameBudgetMs = 0.0;
+
+    // Heap allocations made on the rendering thread during the last Update. Pool threads
+    // helping with the frame aren't included.
+    uint64_t mFrameAllocations = 0;
+    uint64_t mFrameAllocatedBytes = 0;
+
+    // Frames past warm up that allocated at all, this should stay at zero.
+    uint64_t mSteadyStateFramesWithAllocations = 0;
+};
+
+// Memory a backend knows it's holding on to. Sizes it can't query (swapchain images, the
+// default framebuffer) are estimated from dimensions and formats, and flagged as such.
+struct MemoryEntry
+{
+    const char* mName = "";
+    uint64_t mBytes = 0;
+    bool mEstimated = false;
+};
+
+// A device memory heap as the driver sees it. These are device wide, so every panel on the
+// same device reports the same heaps.
+struct MemoryHeapReport
+{
+    bool mDeviceLocal = false;
+    uint64_t mBudgetBytes = 0;     // What the process can use before it starts to hurt.
+    uint64_t mUsageBytes = 0;      // What the process is using, including outside of our allocator.
+    uint64_t mBlockBytes = 0;      // What our allocator has taken from the driver.
+    uint64_t mAllocationBytes = 0; // What's been handed out from those blocks.
+    uint32_t mAllocationCount = 0;
+};
+
+struct MemoryReport
+{
+    std::vector<MemoryEntry> mEntries;
+    std::vector<MemoryHeapReport> mHeaps;
+};
+
+enum class InputEventType
+{
+    KeyDown,
+    KeyUp,
+    MouseMove,
+    MouseButtonDown,
+    MouseButtonUp,
+    MouseWheel,
+    FocusIn,
+    FocusOut
+};
+
+// Input from either Qt or SDL, normalized to SDL's conventions (keycodes, button indices,
+// window relative coordinates).
+struct InputEvent
+{
+    InputEventType mType;
+    Uint64 mTimestampNs = 0; // On the SDL_GetTicksNS clock.
+    SDL_Keycode mKey = SDLK_UNKNOWN;
+    Uint8 mButton = 0;
+    float mX = 0.0f;
+    float mY = 0.0f;
+};
+
+// An image file drawn as a quad. The rect is normalized to the surface, (0, 0) being its
+// top left and (1, 1) its bottom right, so it follows the panel around as it's resized.
+struct ImageQuad
+{
+    std::string mPath;
+    SDL_FRect mRect;
+};
 
 struct color
 {
     Uint8 r, g, b, a;
+
+    bool operator==(const color&) const = default;
+};
+
+// UTF-8 text in one size and color. The pen starts at mOrigin, normalized like ImageQuad's
+// rect, on the first line's baseline, and each newline moves it down a line.
+struct TextRun
+{
+    std::string mText;
+    SDL_FPoint mOrigin;
+    float mPixelSize = 16.0f;
+    color mColor = { 0xFF, 0xFF, 0xFF, 0xFF };
 };
 
 class Renderer
@@ -46,13 +233,82 @@ public:
 
 	}
 
-	virtual void Initialize() = 0;
+    virtual ~Renderer() = default;
+
+    // Constructors only do the work that has to happen on the GUI thread (context and
+    // window bound objects), Initialize is run once on a worker thread afterwards and
+    // should do the heavy lifting: loader init, device selection, shader compiles.
+    // Nothing else is called on the Renderer until Initialize has returned, and only the
+    // destructor if it returned false.
+	virtual bool Initialize() = 0;
 	virtual void Update() = 0;
+
+    // Called by the host on the GUI thread when the window changes size. Overrides call
+    // this first, it's where we note the size NeedsRedraw compares against.
 	virtual void Resize(unsigned int aWidth, unsigned int aHeight) = 0;
     virtual const char* Name() = 0;
-	
-    color mClearColor = {0x00, 0x00, 0xFF, 0xFF};
-    color mTriangleColor = {0xFF, 0x00, 0x00, 0xFF};
+
+    // Renders and presents a frame through Update, but only if something visible changed 
+    // since the last one. Returns whether a frame was rendered.
+    bool Render();
+
+    // A renderer is only ever used by one thread at a time. When it's rendered off the GUI
+    // thread (see RenderScheduler) the lock is held around Render, and the GUI thread has to
+    // hold it around everything else it calls, bar PushInput, Invalidate and
+    // RequestAnimationFrame, which are safe from any thread.
+    std::unique_lock<std::mutex> Lock() { return std::unique_lock<std::mutex>{ mRenderMutex }; }
+
+    // Backends whose API has to be driven from the thread that owns the window.
+    virtual bool RequiresGuiThread() { return false; }
+
+    // Called with the lock held after rendering on a thread that may not be the next one to
+    // use this renderer, so backends can let go of thread bound state like a current context.
+    virtual void ReleaseThread() {}
+
+    // Whether the next Render will actually draw, hosts use this to stop scheduling frames
+    // when a panel is static.
+    bool NeedsRedraw();
+
+    // Damages the whole surface, or just the given rectangle (in window coordinates).
+    void Invalidate();
+    void Invalidate(const SDL_Rect& aRect);
+
+    // Asks for one more frame even if nothing is damaged, animations call this every frame.
+    void RequestAnimationFrame();
+
+    // Queues input for the renderer, drained once at the start of the next Render. Only 
+    // the thread that owns the window may push. Returns false if the queue was full.
+    bool PushInput(const InputEvent& aEvent);
+
+    // Called whenever the renderer goes from clean to dirty so the host can schedule a frame.
+    // It's called on whichever thread invalidated, with the damage lock held, so it should
+    // only hand the work off and must not call back into the renderer.
+    void SetInvalidatedCallback(std::function<void()> aCallback);
+
+    // Switches the presentation mode without recreating the renderer. Returns the mode
+    // actually in use, which can differ when the backend doesn't support the request.
+    PresentMode SetPresentMode(PresentMode aMode);
+    PresentMode GetPresentMode() const { return mPresentMode; }
+
+    // A copy, present stats may be updated by whichever thread flushes a batched present.
+    RendererStats GetStats() const;
+
+    // What this panel's backend is holding on to, queried from the thread that renders.
+    virtual MemoryReport GetMemoryReport() { return {}; }
+
+    void SetClearColor(color aColor);
+    void SetTriangleColor(color aColor);
+    color GetClearColor() const { return mClearColor; }
+    color GetTriangleColor() const { return mTriangleColor; }
+
+    // Images drawn over the clear color and under the triangle. They're streamed in, so
+    // each shows up once it's been loaded and sharpens as its finer mips arrive. Backends
+    // without a texture streamer ignore them.
+    void SetImages(std::vector<ImageQuad> aImages);
+
+    // Text drawn over everything else, through the shared glyph atlas. Backends without a
+    // copy of the atlas ignore it.
+    void SetText(std::vector<TextRun> aText);
 
 	static const std::array<float, 9> TriangleVerts;
 	static constexpr unsigned int cVertexStride = 3 * sizeof(float);
@@ -60,5 +316,90 @@ public:
 	static constexpr unsigned int cVertexCount = 3;
 
 protected:
+    // Damage for the frame being drawn by Update. When HasFullDamage is true the rects are
+    // meaningless and the whole surface should be considered changed.
+    bool HasFullDamage() const { return mFrameFullDamage; }
+    const std::vector<SDL_Rect>& GetDamageRects() const { return mFrameDamageRects; }
+
+    // Applies the mode to the backend, returning the one it ended up with.
+    virtual PresentMode ApplyPresentMode(PresentMode aMode) { return PresentMode::Fifo; }
+
+    // Called for each input event drained at the start of a frame, return true if it
+    // changed something visible so the frame gets drawn.
+    virtual bool OnInput(const InputEvent& aEvent) { return false; }
+
+    // Backends call BeginSubmit right before they start handing the frame to the GPU and
+    // EndPresent once their present call has returned, the stats are built from these.
+    // EndPresent may be called from another thread than the one that rendered the frame.
+    void BeginSubmit();
+    void EndPresent(size_t aFramesPerSubmit = 0);
+
+    // Backends that limit how many frames are queued report how long they waited to.
+    void RecordQueueWait(size_t aMaxQueuedFrames, Uint64 aWaitNs);
+
+    // The fraction of the surface's size to draw this frame at. Backends that support it
+    // draw into an offscreen target at that size, scale it up to the surface on present,
+    // and report what the drawing cost with ReportFrameCost, not counting the upscale or
+    // any wait in present. Once a panel stops changing it gets one more frame at full
+    // resolution, the scale is only there to keep up while it's moving.
+    float GetRenderScale() const { return mFrameScale; }
+
+    // aScale is what the frame was drawn at, which backends that time frames on the GPU
+    // and find out a few frames later have to keep track of.
+    void ReportFrameCost(double aMs, float aScale);
+
+    // For anything that only has to live until the end of Update, reset before each one.
+    FrameArena mFrameArena;
+
 	SDL_Window* mWindow = nullptr;
+
+    PresentMode mPresentMode = PresentMode::Fifo;
+    RendererStats mStats;
+
+    color mClearColor = {0x00, 0x00, 0xFF, 0xFF};
+    color mTriangleColor = {0xFF, 0x00, 0x00, 0xFF};
+    std::vector<ImageQuad> mImages;
+    std::vector<TextRun> mText;
+
+private:
+    bool NeedsRedrawLocked();
+    void MarkDirty();
+
+    static constexpr size_t cInputQueueSize = 256;
+
+    // Frames allowed to allocate while caches, arenas and swapchains settle in.
+    static constexpr uint64_t cWarmUpFrames = 120;
+
+    SpscQueue<InputEvent, cInputQueueSize> mInputQueue;
+    std::mutex mRenderMutex;
+
+    // Guards the damage state and the invalidated callback.
+    std::mutex mDamageMutex;
+    std::function<void()> mInvalidatedCallback;
+    std::vector<SDL_Rect> mDamageRects;
+    int mWindowWidth = -1;
+    int mWindowHeight = -1;
+    int mLastWidth = -1;
+    int mLastHeight = -1;
+    bool mFullDamage = true;
+    bool mDirty = true;
+    bool mAnimationRequested = false;
+
+    // Set after a frame drawn below full resolution, and only acted on once nothing else
+    // needs drawing.
+    bool mFullResolutionPending = false;
+
+    ResolutionScaler mResolutionScaler;
+    float mFrameScale = 1.0f;
+
+    // The damage Update is drawing, taken from the above when the frame starts.
+    std::vector<SDL_Rect> mFrameDamageRects;
+    bool mFrameFullDamage = true;
+
+    // Guards mStats, which EndPresent updates from any thread and GetStats reads from the
+    // GUI thread while we render.
+    mutable std::mutex mStatsMutex;
+    Uint64 mSubmitStartNs = 0;
+    Uint64 mThroughputWindowStartNs = 0;
+    uint64_t mThroughputWindowFrames = 0;
 };
@@ -0,0 +1,91 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#include "SDL3/SDL.h"
+
+#include "Renderers/ResolutionScaler.hpp"
+
+// What frames are aimed at when the scale drops, short of the budget so the next frame
+// that's a little slower doesn't go straight over again.
+static constexpr double cTargetFraction = 0.85;
+
+// Frames have to come in under this fraction of the budget for cRaiseAfterFrames in a row
+// before the scale goes up by cRaiseStep. A step costs at most a fifth more time (0.5 to
+// 0.55), which still fits.
+static constexpr double cRaiseFraction = 0.7;
+static constexpr int cRaiseAfterFrames = 30;
+static constexpr float cRaiseStep = 0.05f;
+
+static constexpr double cSmoothing = 0.2;
+
+ResolutionScaler::ResolutionScaler()
+{
+    if (const char* budget = SDL_getenv("RESOLUTION_BUDGET_MS"))
+    {
+        mBudgetMs = std::max(0.0, atof(budget));
+    }
+
+    if (const char* minimum = SDL_getenv("RESOLUTION_MIN_SCALE"))
+    {
+        mMinScale = std::clamp((float)atof(minimum), 0.1f, 1.0f);
+    }
+}
+
+bool ResolutionScaler::AddFrame(double aFrameMs, float aScale)
+{
+    if (!Enabled() || (aScale <= 0.0f))
+    {
+        return false;
+    }
+
+    // As if it had been drawn at the current scale.
+    double ratio = (double)mScale / (double)aScale;
+    double sample = aFrameMs * ratio * ratio;
+    mAverageMs = (0.0 == mAverageMs) ? sample : (mAverageMs + cSmoothing * (sample - mAverageMs));
+
+    float scale = mScale;
+
+    if (mAverageMs > mBudgetMs)
+    {
+        // Straight to where the average says frames would fit, in one step.
+        scale = mScale * (float)std::sqrt(mBudgetMs * cTargetFraction / mAverageMs);
+        mFramesWithHeadroom = 0;
+    }
+    else if ((mAverageMs < (mBudgetMs * cRaiseFraction)) && (mScale < 1.0f))
+    {
+        if (++mFramesWithHeadroom >= cRaiseAfterFrames)
+        {
+            scale = mScale + cRaiseStep;
+            mFramesWithHeadroom = 0;
+        }
+    }
+    else
+    {
+        mFramesWithHeadroom = 0;
+    }
+
+    scale = std::clamp(scale, mMinScale, 1.0f);
+    if (scale == mScale)
+    {
+        return false;
+    }
+
+    SetScale(scale);
+    return true;
+}
+
+void ResolutionScaler::SetScale(float aScale)
+{
+    // The average carries over to the new scale, so it doesn't take a run of frames to
+    // notice the change worked.
+    double ratio = (double)aScale / (double)mScale;
+    mAverageMs *= ratio * ratio;
+    mScale = aScale;
+}
+
+void ResolutionScaler::ScaleSize(int aWidth, int aHeight, float aScale, int& aScaledWidth, int& aScaledHeight)
+{
+    aScaledWidth = std::max(1, (int)std::lround(aWidth * aScale));
+    aScaledHeight = std::max(1, (int)std::lround(aHeight * aScale));
+}
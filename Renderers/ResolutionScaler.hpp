@@ -0,0 +1,38 @@
+#pragma once
+
+// Picks the fraction of a panel's size to draw at so its frames stay within a time budget.
+// Fed what each frame cost to draw, it drops the scale as soon as frames run over and only
+// raises it again after a run of frames with room to spare, so it settles rather than
+// hunting. Both axes are scaled, so the pixels drawn, and for fill bound panels the time,
+// go with the square of the scale.
+//
+// RESOLUTION_BUDGET_MS sets the budget, 0 (the default) keeps panels at full resolution.
+// RESOLUTION_MIN_SCALE sets how far down it may go, 0.5 by default.
+class ResolutionScaler
+{
+public:
+    ResolutionScaler();
+
+    bool Enabled() const { return 0.0 < mBudgetMs; }
+    double GetBudgetMs() const { return mBudgetMs; }
+    float GetScale() const { return mScale; }
+
+    // The cost of a frame drawn at aScale, which backends that only find out a few frames
+    // later may report late. Returns whether the scale changed.
+    bool AddFrame(double aFrameMs, float aScale);
+
+    // What a frame would cost at the current scale, from the frames so far.
+    double GetAverageMs() const { return mAverageMs; }
+
+    // aWidth by aHeight at aScale, never less than a pixel.
+    static void ScaleSize(int aWidth, int aHeight, float aScale, int& aScaledWidth, int& aScaledHeight);
+
+private:
+    void SetScale(float aScale);
+
+    double mBudgetMs = 0.0;
+    float mMinScale = 0.5f;
+    float mScale = 1.0f;
+    double mAverageMs = 0.0;
+    int mFramesWithHeadroom = 0;
+};
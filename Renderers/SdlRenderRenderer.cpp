@@ -1,5 +1,55 @@
+#include <algorithm>
+
 #include "Renderers/SdlRenderRenderer.hpp"
 
+//////////////////////////////////////////////////////////////////////////////////////////////
+// SdlTextureUploader:
+uint64_t SdlTextureUploader::CreateTexture(uint32_t aWidth, uint32_t aHeight, uint32_t aMipCount)
+{
+    return (uint64_t)(uintptr_t)new Image{};
+}
+
+bool SdlTextureUploader::UploadMip(uint64_t aTexture, uint32_t aLevel, uint32_t aWidth, uint32_t aHeight, const uint8_t* aPixels)
+{
+    Image* image = (Image*)(uintptr_t)aTexture;
+
+    SDL_Texture* texture = SDL_CreateTexture(mRenderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, (int)aWidth, (int)aHeight);
+    if ((nullptr == texture) || !SDL_UpdateTexture(texture, nullptr, aPixels, (int)aWidth * 4))
+    {
+        // Keep drawing the coarser one, trying again wouldn't go any better.
+        printf("SDL Error: %s\n", SDL_GetError());
+        SDL_DestroyTexture(texture);
+        return true;
+    }
+
+    SDL_SetTextureScaleMode(texture, SDL_SCALEMODE_LINEAR);
+
+    // SDL defers destruction until the commands that use it have been flushed.
+    SDL_DestroyTexture(image->mTexture);
+    mTextureBytes -= image->mBytes;
+
+    image->mTexture = texture;
+    image->mBytes = (uint64_t)aWidth * aHeight * 4;
+    mTextureBytes += image->mBytes;
+    return true;
+}
+
+void SdlTextureUploader::DestroyTexture(uint64_t aTexture)
+{
+    Image* image = (Image*)(uintptr_t)aTexture;
+    SDL_DestroyTexture(image->mTexture);
+    mTextureBytes -= image->mBytes;
+    delete image;
+}
+
+SDL_Texture* SdlTextureUploader::Get(uint64_t aTexture)
+{
+    return ((Image*)(uintptr_t)aTexture)->mTexture;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// SDLRenderRenderer:
+
 SDLRenderRenderer::SDLRenderRenderer(SDL_Window* aWindow, const char* aRendererBackend)
     : Renderer{ aWindow }
     , mRendererBackend{ aRendererBackend }
@@ -8,40 +58,342 @@ SDLRenderRenderer::SDLRenderRenderer(SDL_Window* aWindow, const char* aRendererB
     mName += aRendererBackend;
     mName += " }";
 
-
+    // SDL's render API has to be used from the main thread, so unlike the other backends
+    // there's nothing for Initialize to do off of it.
     mRenderer = SDL_CreateRenderer(mWindow, mRendererBackend);
 
     if (nullptr == mRenderer) {
         printf("SDL Error: %s\n", SDL_GetError());
         __debugbreak();
     }
+
+    CreateResources();
+}
+
+SDLRenderRenderer::SDLRenderRenderer(SDL_Surface* aSurface)
+    : Renderer{ nullptr }
+    , mRendererBackend{ SDL_SOFTWARE_RENDERER }
+    , mSurface{ aSurface }
+    , mSurfaceWidth{ aSurface->w }
+    , mSurfaceHeight{ aSurface->h }
+{
+    mName = "SDLRenderer { software, host surface }";
+
+    mRenderer = SDL_CreateSoftwareRenderer(mSurface);
+
+    if (nullptr == mRenderer) {
+        printf("SDL Error: %s\n", SDL_GetError());
+        __debugbreak();
+    }
+
+    CreateResources();
+}
+
+SDLRenderRenderer::~SDLRenderRenderer()
+{
+    // Every texture belongs to the renderer, so they all go first.
+    mTextures.Clear();
+    SDL_DestroyTexture(mGlyphTexture);
+    SDL_DestroyTexture(mScaleTarget);
+    SDL_DestroyRenderer(mRenderer);
 }
 
-void SDLRenderRenderer::Initialize()
+void SDLRenderRenderer::CreateResources()
 {
+    mTextureUploader.Initialize(mRenderer);
+
+    mGlyphTexture = SDL_CreateTexture(mRenderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, GlyphAtlas::cSize, GlyphAtlas::cSize);
+    if (nullptr != mGlyphTexture)
+    {
+        SDL_SetTextureBlendMode(mGlyphTexture, SDL_BLENDMODE_BLEND);
+        SDL_SetTextureScaleMode(mGlyphTexture, SDL_SCALEMODE_LINEAR);
+    }
+}
+
+bool SDLRenderRenderer::Initialize()
+{
+    return true;
 }
 
 void SDLRenderRenderer::Update()
 {
+    BeginSubmit();
+    Uint64 drawStartNs = SDL_GetTicksNS();
+
+    int width = 0, height = 0;
+    if (nullptr != mSurface)
+    {
+        width = mSurfaceWidth;
+        height = mSurfaceHeight;
+    }
+    else
+    {
+        SDL_GetWindowSize(mWindow, &width, &height);
+    }
+
+    // Frames below full resolution go into the top left of a target the panel's size, so
+    // the scale can change every frame without recreating it.
+    float scale = GetRenderScale();
+    SDL_Texture* scaleTarget = (scale < 1.0f) ? GetScaleTarget(width, height) : nullptr;
+
+    int x = width, y = height;
+    if (nullptr != scaleTarget)
+    {
+        ResolutionScaler::ScaleSize(width, height, scale, x, y);
+        SDL_SetRenderTarget(mRenderer, scaleTarget);
+
+        SDL_Rect viewport{ 0, 0, x, y };
+        SDL_SetRenderViewport(mRenderer, &viewport);
+    }
+
     SDL_SetRenderDrawColor(mRenderer, mClearColor.r, mClearColor.g, mClearColor.b, mClearColor.a);
-    SDL_RenderClear(mRenderer);
 
-    int x = 0, y = 0;
-    SDL_GetWindowSize(mWindow, &x, &y);
+    if ((nullptr != mSurface) || (nullptr != scaleTarget))
+    {
+        // Clearing ignores the viewport, and what we draw into is usually bigger than us.
+        SDL_RenderFillRect(mRenderer, nullptr);
+    }
+    else
+    {
+        SDL_RenderClear(mRenderer);
+    }
+
+    mTextures.Update();
+    mTextureBytes = mTextureUploader.TextureBytes();
+
+    for (const ImageQuad& image : mImages)
+    {
+        uint64_t texture = mTextures.Acquire(image.mPath);
+        if (0 != texture)
+        {
+            SDL_FRect destination{ image.mRect.x * x, image.mRect.y * y, image.mRect.w * x, image.mRect.h * y };
+            SDL_RenderTexture(mRenderer, SdlTextureUploader::Get(texture), nullptr, &destination);
+        }
+    }
+
+    // Keep drawing while there's more on the way, each frame sharpens what's there.
+    if (mTextures.Busy())
+    {
+        RequestAnimationFrame();
+    }
+
+    mTextures.ReportStats(mStats);
+
     int width_center = x / 2;
     int height_center = y / 2;
 
     SDL_SetRenderDrawColor(mRenderer, mTriangleColor .r, mTriangleColor.g, mTriangleColor.b, mTriangleColor .a);
     SDL_FRect rect{ width_center - (width_center / 2), height_center - (height_center / 2), width_center, height_center };
     SDL_RenderFillRect(mRenderer, &rect);
+
+    DrawGlyphs(width, height, x, y);
+
+    // The software backend has drawn everything once this returns, the others have at
+    // least handed it to the driver, which is as close as the render API lets us get.
+    SDL_FlushRenderer(mRenderer);
+    ReportFrameCost((double)(SDL_GetTicksNS() - drawStartNs) / (double)SDL_NS_PER_MS, scale);
+
+    if (nullptr != scaleTarget)
+    {
+        SDL_SetRenderTarget(mRenderer, nullptr);
+
+        SDL_FRect source{ 0.0f, 0.0f, (float)x, (float)y };
+        SDL_FRect destination{ 0.0f, 0.0f, (float)width, (float)height };
+        SDL_RenderTexture(mRenderer, scaleTarget, &source, &destination);
+    }
+
     if (!SDL_RenderPresent(mRenderer)) {
         printf("SDL Error: %s\n", SDL_GetError());
     }
+
+    EndPresent();
+}
+
+SDL_Texture* SDLRenderRenderer::GetScaleTarget(int aWidth, int aHeight)
+{
+    if ((nullptr != mScaleTarget) && (mScaleTarget->w == aWidth) && (mScaleTarget->h == aHeight))
+    {
+        return mScaleTarget;
+    }
+
+    SDL_DestroyTexture(mScaleTarget);
+    mScaleTarget = nullptr;
+
+    if ((aWidth <= 0) || (aHeight <= 0))
+    {
+        return nullptr;
+    }
+
+    // No alpha, so it's copied rather than blended over whatever the window had.
+    mScaleTarget = SDL_CreateTexture(mRenderer, SDL_PIXELFORMAT_XRGB8888, SDL_TEXTUREACCESS_TARGET, aWidth, aHeight);
+    if (nullptr == mScaleTarget)
+    {
+        // Drawn at full resolution instead.
+        printf("SDL Error: %s\n", SDL_GetError());
+        return nullptr;
+    }
+
+    SDL_SetTextureBlendMode(mScaleTarget, SDL_BLENDMODE_NONE);
+    SDL_SetTextureScaleMode(mScaleTarget, SDL_SCALEMODE_LINEAR);
+    return mScaleTarget;
+}
+
+void SDLRenderRenderer::DrawGlyphs(int aWidth, int aHeight, int aDrawWidth, int aDrawHeight)
+{
+    mStats.mGlyphUploadBytes = 0;
+    if (mText.empty() || (nullptr == mGlyphTexture) || (0 == aWidth) || (0 == aHeight))
+    {
+        return;
+    }
+
+    std::span<GlyphQuad> quads = mFrameArena.AllocateArray<GlyphQuad>(GlyphAtlas::MaxQuads(mText));
+    uint64_t generation = mGlyphCursor.mGeneration;
+
+    size_t count = GlyphAtlas::Shared().Prepare(mText, (float)aWidth, (float)aHeight, quads, mGlyphCursor,
+        [this](const SDL_Rect& aRect, const uint8_t* aPixels, size_t aPitch)
+        {
+            mGlyphScratch.resize((size_t)aRect.w * aRect.h * 4);
+
+            uint8_t* texel = mGlyphScratch.data();
+            for (int y = 0; y < aRect.h; ++y)
+            {
+                const uint8_t* coverage = aPixels + (size_t)y * aPitch;
+                for (int x = 0; x < aRect.w; ++x, texel += 4)
+                {
+                    texel[0] = 0xFF;
+                    texel[1] = 0xFF;
+                    texel[2] = 0xFF;
+                    texel[3] = coverage[x];
+                }
+            }
+
+            SDL_UpdateTexture(mGlyphTexture, &aRect, mGlyphScratch.data(), aRect.w * 4);
+            mStats.mGlyphUploadBytes += mGlyphScratch.size();
+        });
+
+    if (generation != mGlyphCursor.mGeneration)
+    {
+        ++mStats.mGlyphFullUploads;
+    }
+
+    mStats.mGlyphsCached = GlyphAtlas::Shared().GlyphCount();
+
+    if (0 == count)
+    {
+        return;
+    }
+
+    // SDL_Renderer has no instancing, each quad is two indexed triangles.
+    std::span<SDL_Vertex> vertices = mFrameArena.AllocateArray<SDL_Vertex>(count * 4);
+    std::span<int> indices = mFrameArena.AllocateArray<int>(count * 6);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const GlyphQuad& quad = quads[i];
+        SDL_FColor color{ quad.mColor[0], quad.mColor[1], quad.mColor[2], quad.mColor[3] };
+        float left = quad.mRect[0] * aDrawWidth;
+        float top = quad.mRect[1] * aDrawHeight;
+        float right = quad.mRect[2] * aDrawWidth;
+        float bottom = quad.mRect[3] * aDrawHeight;
+
+        SDL_Vertex* corner = &vertices[i * 4];
+        corner[0] = SDL_Vertex{ { left, top }, color, { quad.mUv[0], quad.mUv[1] } };
+        corner[1] = SDL_Vertex{ { right, top }, color, { quad.mUv[2], quad.mUv[1] } };
+        corner[2] = SDL_Vertex{ { left, bottom }, color, { quad.mUv[0], quad.mUv[3] } };
+        corner[3] = SDL_Vertex{ { right, bottom }, color, { quad.mUv[2], quad.mUv[3] } };
+
+        int first = (int)(i * 4);
+        int* index = &indices[i * 6];
+        index[0] = first;
+        index[1] = first + 1;
+        index[2] = first + 2;
+        index[3] = first + 2;
+        index[4] = first + 1;
+        index[5] = first + 3;
+    }
+
+    SDL_RenderGeometry(mRenderer, mGlyphTexture, vertices.data(), (int)vertices.size(), indices.data(), (int)indices.size());
 }
 
 void SDLRenderRenderer::Resize(unsigned int aWidth, unsigned int aHeight)
 {
+    Renderer::Resize(aWidth, aHeight);
 
+    // Window backed renderers follow their window's size by themselves.
+    if (nullptr == mSurface)
+    {
+        return;
+    }
+
+    mSurfaceWidth = std::min((int)aWidth, mSurface->w);
+    mSurfaceHeight = std::min((int)aHeight, mSurface->h);
+
+    SDL_Rect viewport{ 0, 0, mSurfaceWidth, mSurfaceHeight };
+    SDL_SetRenderViewport(mRenderer, &viewport);
+}
+
+MemoryReport SDLRenderRenderer::GetMemoryReport()
+{
+    MemoryReport report;
+    report.mEntries.push_back(MemoryEntry{ "Textures", mTextureBytes });
+    report.mEntries.push_back(MemoryEntry{ "Glyph atlas", (uint64_t)GlyphAtlas::cSize * GlyphAtlas::cSize * 4 });
+
+    if (nullptr != mScaleTarget)
+    {
+        report.mEntries.push_back(MemoryEntry{ "Resolution scaling target", (uint64_t)mScaleTarget->w * mScaleTarget->h * 4 });
+    }
+
+    if (nullptr != mSurface)
+    {
+        // The host's, but it's there for nothing else.
+        report.mEntries.push_back(MemoryEntry{ "Render targets", (uint64_t)mSurface->pitch * mSurface->h });
+        return report;
+    }
+
+    // Whatever the backend renders into, assumed to be 32 bit and double buffered.
+    int width = 0, height = 0;
+    SDL_GetCurrentRenderOutputSize(mRenderer, &width, &height);
+    report.mEntries.push_back(MemoryEntry{ "Render targets", (uint64_t)width * height * 4 * 2, true });
+
+    return report;
+}
+
+PresentMode SDLRenderRenderer::ApplyPresentMode(PresentMode aMode)
+{
+    // The host decides when its surface is shown, there's nothing to sync with here.
+    if (nullptr != mSurface)
+    {
+        return PresentMode::Fifo;
+    }
+
+    // SDL_Renderer only knows about swap intervals, so mailbox ends up as plain vsync.
+    switch (aMode)
+    {
+        case PresentMode::Immediate:
+        {
+            if (SDL_SetRenderVSync(mRenderer, SDL_RENDERER_VSYNC_DISABLED))
+            {
+                return PresentMode::Immediate;
+            }
+            break;
+        }
+        case PresentMode::Adaptive:
+        {
+            if (SDL_SetRenderVSync(mRenderer, SDL_RENDERER_VSYNC_ADAPTIVE))
+            {
+                return PresentMode::Adaptive;
+            }
+            break;
+        }
+        default: break;
+    }
+
+    if (!SDL_SetRenderVSync(mRenderer, 1))
+    {
+        printf("SDL Error: %s\n", SDL_GetError());
+    }
+
+    return PresentMode::Fifo;
 }
 
 const char* SDLRenderRenderer::Name()
@@ -53,3 +405,8 @@ std::unique_ptr<Renderer> CreateSdlRenderRenderer(SDL_Window* aWindow, const cha
 {
     return std::unique_ptr<Renderer>(new SDLRenderRenderer(aWindow, aRenderBackend));
 }
+
+std::unique_ptr<Renderer> CreateSdlSurfaceRenderer(SDL_Surface* aSurface)
+{
+    return std::unique_ptr<Renderer>(new SDLRenderRenderer(aSurface));
+}
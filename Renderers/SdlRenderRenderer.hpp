@@ -3,19 +3,88 @@
 
 #include "SDL3/SDL.h"
 
+#include "Renderers/GlyphAtlas.hpp"
 #include "Renderers/Renderer.hpp"
+#include "Renderers/TextureStreamer.hpp"
+
+// SDL_Renderer textures have no mips, so each image's texture is recreated at the size of the
+// finest mip that's arrived so far and SDL scales it to the quad. SDL_UpdateTexture is the
+// render API's own staging path.
+class SdlTextureUploader : public TextureUploader
+{
+public:
+    void Initialize(SDL_Renderer* aRenderer) { mRenderer = aRenderer; }
+
+    uint64_t CreateTexture(uint32_t aWidth, uint32_t aHeight, uint32_t aMipCount) override;
+    bool UploadMip(uint64_t aTexture, uint32_t aLevel, uint32_t aWidth, uint32_t aHeight, const uint8_t* aPixels) override;
+    void DestroyTexture(uint64_t aTexture) override;
+
+    // nullptr until the first mip has been uploaded.
+    static SDL_Texture* Get(uint64_t aTexture);
+
+    uint64_t TextureBytes() const { return mTextureBytes; }
+
+private:
+    struct Image
+    {
+        SDL_Texture* mTexture = nullptr;
+        uint64_t mBytes = 0;
+    };
+
+    SDL_Renderer* mRenderer = nullptr;
+    uint64_t mTextureBytes = 0;
+};
 
 class SDLRenderRenderer : public Renderer
 {
 public:
     SDLRenderRenderer(SDL_Window* aWindow, const char* aRendererBackend);
-    virtual void Initialize() override;
+
+    // SDL's software renderer drawing straight into aSurface, which the host owns and shows
+    // itself, there's no window. Resize sets how much of the surface from its top left is
+    // the panel, so the host can make the surface once for the largest the panel gets.
+    // The host has to Invalidate on resize, there's no window size to notice it by.
+    SDLRenderRenderer(SDL_Surface* aSurface);
+    ~SDLRenderRenderer() override;
+
+    virtual bool Initialize() override;
     virtual void Update() override;
     virtual void Resize(unsigned int aWidth, unsigned int aHeight) override;
     virtual const char* Name() override;
+    virtual MemoryReport GetMemoryReport() override;
+
+    // SDL_Renderer isn't thread safe and some of its backends are tied to the main thread.
+    virtual bool RequiresGuiThread() override { return true; }
 
 protected:
+    PresentMode ApplyPresentMode(PresentMode aMode) override;
+    void CreateResources();
+    SDL_Texture* GetScaleTarget(int aWidth, int aHeight);
+
+    // Laid out for aWidth by aHeight, drawn into the top left aDrawWidth by aDrawHeight.
+    void DrawGlyphs(int aWidth, int aHeight, int aDrawWidth, int aDrawHeight);
+
     const char* mRendererBackend;
     SDL_Renderer* mRenderer = nullptr;
     std::string mName;
+
+    // Only when drawing into a host's surface, with the part of it that's the panel.
+    SDL_Surface* mSurface = nullptr;
+    int mSurfaceWidth = 0;
+    int mSurfaceHeight = 0;
+
+    // What frames below full resolution are drawn into, made when the first one is.
+    SDL_Texture* mScaleTarget = nullptr;
+
+    // Bytes of every texture we've created, SDL doesn't keep a total.
+    uint64_t mTextureBytes = 0;
+
+    SdlTextureUploader mTextureUploader;
+    TextureStreamer mTextures{ mTextureUploader };
+
+    // Our copy of the glyph atlas. There's no single channel texture format, so coverage is
+    // expanded into the alpha of white texels on the way in.
+    SDL_Texture* mGlyphTexture = nullptr;
+    GlyphAtlasCursor mGlyphCursor;
+    std::vector<uint8_t> mGlyphScratch;
 };
@@ -0,0 +1,356 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+    #define SOFTWARE_RENDERER_SSE2
+    #include <emmintrin.h>
+#endif
+
+#include "Renderers/SoftwareRenderer.hpp"
+
+#include "Utilities/ThreadPool.hpp"
+
+std::unique_ptr<Renderer> CreateSoftwareRenderer(SDL_Window* aWindow)
+{
+    return std::unique_ptr<Renderer>(new SoftwareRenderer(aWindow));
+}
+
+static Uint32 PackColor(color aColor)
+{
+    // XRGB8888, the alpha byte is ignored by the format but we keep it opaque anyway.
+    return (0xFFu << 24) | ((Uint32)aColor.r << 16) | ((Uint32)aColor.g << 8) | (Uint32)aColor.b;
+}
+
+SoftwareRenderer::SoftwareRenderer(SDL_Window* aWindow)
+    : Renderer{ aWindow }
+{
+}
+
+SoftwareRenderer::~SoftwareRenderer()
+{
+    // The surface only wraps mColorBuffer, so this frees the header and nothing else.
+    SDL_DestroySurface(mColorSurface);
+}
+
+bool SoftwareRenderer::Initialize()
+{
+    if (const char* threads = SDL_getenv("SOFTWARE_RENDERER_THREADS"))
+    {
+        mOwnedPool = std::make_unique<ThreadPool>((size_t)std::max(1, atoi(threads)));
+        mPool = mOwnedPool.get();
+    }
+    else
+    {
+        mPool = &ThreadPool::Shared();
+    }
+
+    printf("SoftwareRenderer using %zu worker threads\n", mPool->ThreadCount());
+    return true;
+}
+
+void SoftwareRenderer::Update()
+{
+    int width = 0, height = 0;
+    SDL_GetWindowSize(mWindow, &width, &height);
+
+    if ((width <= 0) || (height <= 0))
+    {
+        return;
+    }
+
+    if ((width != mTargetWidth) || (height != mTargetHeight))
+    {
+        ResizeTargets(width, height);
+    }
+
+    // Drawn into the top left of the color buffer at the frame's scale, the pitch stays
+    // the full size's so the scale can change every frame without reallocating.
+    float scale = GetRenderScale();
+    ResolutionScaler::ScaleSize(width, height, scale, mWidth, mHeight);
+    mTilesX = (mWidth + cTileSize - 1) / cTileSize;
+    mTilesY = (mHeight + cTileSize - 1) / cTileSize;
+
+    Uint64 drawStartNs = SDL_GetTicksNS();
+    mClearPixel = PackColor(mClearColor);
+
+    BinTriangles();
+
+    mPool->ParallelFor((size_t)(mTilesX * mTilesY), [this](size_t aTile)
+    {
+        RasterizeTile(aTile);
+    });
+
+    ReportFrameCost((double)(SDL_GetTicksNS() - drawStartNs) / (double)SDL_NS_PER_MS, scale);
+
+    SDL_Surface* windowSurface = SDL_GetWindowSurface(mWindow);
+    if (nullptr == windowSurface)
+    {
+        printf("SDL Error: %s\n", SDL_GetError());
+        return;
+    }
+
+    BeginSubmit();
+
+    // A plain copy when the window surface is XRGB8888 as well, a conversion otherwise.
+    // Frames drawn smaller are stretched over it with bilinear filtering.
+    if ((mWidth == mTargetWidth) && (mHeight == mTargetHeight))
+    {
+        SDL_BlitSurface(mColorSurface, nullptr, windowSurface, nullptr);
+    }
+    else
+    {
+        SDL_Rect source{ 0, 0, mWidth, mHeight };
+        SDL_BlitSurfaceScaled(mColorSurface, &source, windowSurface, nullptr, SDL_SCALEMODE_LINEAR);
+    }
+
+    if (!SDL_UpdateWindowSurface(mWindow))
+    {
+        printf("SDL Error: %s\n", SDL_GetError());
+    }
+
+    EndPresent();
+}
+
+void SoftwareRenderer::Resize(unsigned int aWidth, unsigned int aHeight)
+{
+    Renderer::Resize(aWidth, aHeight);
+
+    // The window surface follows the window on its own, and we pick up the new size for
+    // our own targets at the start of the next frame.
+}
+
+MemoryReport SoftwareRenderer::GetMemoryReport()
+{
+    MemoryReport report;
+    report.mEntries.push_back(MemoryEntry{ "Color buffer", mColorBuffer.capacity() * sizeof(Uint32) });
+
+    report.mEntries.push_back(MemoryEntry{ "Frame arena", mFrameArena.Capacity() });
+
+    if (SDL_Surface* surface = SDL_GetWindowSurface(mWindow))
+    {
+        report.mEntries.push_back(MemoryEntry{ "Window surface", (uint64_t)surface->pitch * surface->h });
+    }
+
+    return report;
+}
+
+PresentMode SoftwareRenderer::ApplyPresentMode(PresentMode aMode)
+{
+    switch (aMode)
+    {
+        case PresentMode::Immediate:
+        {
+            if (SDL_SetWindowSurfaceVSync(mWindow, SDL_WINDOW_SURFACE_VSYNC_DISABLED))
+            {
+                return PresentMode::Immediate;
+            }
+            break;
+        }
+        case PresentMode::Adaptive:
+        {
+            if (SDL_SetWindowSurfaceVSync(mWindow, SDL_WINDOW_SURFACE_VSYNC_ADAPTIVE))
+            {
+                return PresentMode::Adaptive;
+            }
+            break;
+        }
+        default: break;
+    }
+
+    SDL_SetWindowSurfaceVSync(mWindow, 1);
+    return PresentMode::Fifo;
+}
+
+void SoftwareRenderer::ResizeTargets(int aWidth, int aHeight)
+{
+    mTargetWidth = aWidth;
+    mTargetHeight = aHeight;
+    int tilesX = (aWidth + cTileSize - 1) / cTileSize;
+    int tilesY = (aHeight + cTileSize - 1) / cTileSize;
+    mPitch = tilesX * cTileSize;
+
+    mColorBuffer.assign((size_t)mPitch * (size_t)(tilesY * cTileSize), 0);
+
+    SDL_DestroySurface(mColorSurface);
+    mColorSurface = SDL_CreateSurfaceFrom(aWidth, aHeight, SDL_PIXELFORMAT_XRGB8888, mColorBuffer.data(), mPitch * (int)sizeof(Uint32));
+}
+
+void SoftwareRenderer::BinTriangles()
+{
+    size_t tileCount = (size_t)(mTilesX * mTilesY);
+    std::span<ScreenTriangle> triangles = mFrameArena.AllocateArray<ScreenTriangle>(TriangleVerts.size() / 9);
+    size_t triangleCount = 0;
+
+    // Counted per tile first (shifted up one), so the offsets come out of a prefix sum.
+    mBinOffsets = mFrameArena.AllocateArray<Uint32>(tileCount + 1);
+    std::fill(mBinOffsets.begin(), mBinOffsets.end(), 0);
+
+    Uint32 triangleColor = PackColor(mTriangleColor);
+
+    for (size_t i = 0; (i + 9) <= TriangleVerts.size(); i += 9)
+    {
+        ScreenTriangle triangle;
+        triangle.mColor = triangleColor;
+
+        // NDC to pixels, flipping y since NDC points up.
+        for (size_t v = 0; v < 3; ++v)
+        {
+            triangle.mX[v] = (TriangleVerts[i + v * 3 + 0] * 0.5f + 0.5f) * (float)mWidth;
+            triangle.mY[v] = (0.5f - TriangleVerts[i + v * 3 + 1] * 0.5f) * (float)mHeight;
+        }
+
+        float area = (triangle.mX[1] - triangle.mX[0]) * (triangle.mY[2] - triangle.mY[0])
+                   - (triangle.mX[2] - triangle.mX[0]) * (triangle.mY[1] - triangle.mY[0]);
+
+        if (0.0f == area)
+        {
+            continue;
+        }
+
+        // Normalize the winding so inside is always positive.
+        if (area < 0.0f)
+        {
+            std::swap(triangle.mX[1], triangle.mX[2]);
+            std::swap(triangle.mY[1], triangle.mY[2]);
+        }
+
+        float minX = std::min({ triangle.mX[0], triangle.mX[1], triangle.mX[2] });
+        float minY = std::min({ triangle.mY[0], triangle.mY[1], triangle.mY[2] });
+        float maxX = std::max({ triangle.mX[0], triangle.mX[1], triangle.mX[2] });
+        float maxY = std::max({ triangle.mY[0], triangle.mY[1], triangle.mY[2] });
+
+        triangle.mMinX = std::max(0, (int)std::floor(minX));
+        triangle.mMinY = std::max(0, (int)std::floor(minY));
+        triangle.mMaxX = std::min(mWidth - 1, (int)std::ceil(maxX));
+        triangle.mMaxY = std::min(mHeight - 1, (int)std::ceil(maxY));
+
+        if ((triangle.mMinX > triangle.mMaxX) || (triangle.mMinY > triangle.mMaxY))
+        {
+            continue;
+        }
+
+        triangles[triangleCount++] = triangle;
+
+        for (int tileY = triangle.mMinY / cTileSize; tileY <= triangle.mMaxY / cTileSize; ++tileY)
+        {
+            for (int tileX = triangle.mMinX / cTileSize; tileX <= triangle.mMaxX / cTileSize; ++tileX)
+            {
+                ++mBinOffsets[(size_t)(tileY * mTilesX + tileX) + 1];
+            }
+        }
+    }
+
+    mTriangles = triangles.first(triangleCount);
+
+    for (size_t i = 1; i <= tileCount; ++i)
+    {
+        mBinOffsets[i] += mBinOffsets[i - 1];
+    }
+
+    // Second pass drops each triangle into its tiles, in order, so tiles still draw them
+    // in submission order.
+    mBinTriangles = mFrameArena.AllocateArray<Uint32>(mBinOffsets[tileCount]);
+    std::span<Uint32> cursors = mFrameArena.AllocateArray<Uint32>(tileCount);
+    std::copy(mBinOffsets.begin(), mBinOffsets.end() - 1, cursors.begin());
+
+    for (size_t index = 0; index < mTriangles.size(); ++index)
+    {
+        const ScreenTriangle& triangle = mTriangles[index];
+
+        for (int tileY = triangle.mMinY / cTileSize; tileY <= triangle.mMaxY / cTileSize; ++tileY)
+        {
+            for (int tileX = triangle.mMinX / cTileSize; tileX <= triangle.mMaxX / cTileSize; ++tileX)
+            {
+                mBinTriangles[cursors[(size_t)(tileY * mTilesX + tileX)]++] = (Uint32)index;
+            }
+        }
+    }
+}
+
+void SoftwareRenderer::RasterizeTile(size_t aTile)
+{
+    int tileX = (int)aTile % mTilesX;
+    int tileY = (int)aTile / mTilesX;
+    int x0 = tileX * cTileSize;
+    int y0 = tileY * cTileSize;
+
+    for (int y = y0; y < (y0 + cTileSize); ++y)
+    {
+        Uint32* row = mColorBuffer.data() + (size_t)y * (size_t)mPitch + (size_t)x0;
+        std::fill(row, row + cTileSize, mClearPixel);
+    }
+
+    for (Uint32 index : mBinTriangles.subspan(mBinOffsets[aTile], mBinOffsets[aTile + 1] - mBinOffsets[aTile]))
+    {
+        const ScreenTriangle& triangle = mTriangles[index];
+
+        // Edge i runs from vertex i to vertex i + 1: e(x, y) = A * x + B * y + C.
+        float a[3], b[3], c[3];
+        for (int i = 0; i < 3; ++i)
+        {
+            int j = (i + 1) % 3;
+            a[i] = triangle.mY[i] - triangle.mY[j];
+            b[i] = triangle.mX[j] - triangle.mX[i];
+            c[i] = triangle.mX[i] * triangle.mY[j] - triangle.mX[j] * triangle.mY[i];
+        }
+
+        // Tiles start on a multiple of four and the buffer is padded out to whole tiles,
+        // so we can always work in aligned groups of four pixels.
+        int minX = std::max(triangle.mMinX, x0) & ~3;
+        int maxX = std::min(triangle.mMaxX, x0 + cTileSize - 1);
+        int minY = std::max(triangle.mMinY, y0);
+        int maxY = std::min(triangle.mMaxY, y0 + cTileSize - 1);
+
+        for (int y = minY; y <= maxY; ++y)
+        {
+            float pixelY = (float)y + 0.5f;
+            Uint32* row = mColorBuffer.data() + (size_t)y * (size_t)mPitch;
+
+#if defined(SOFTWARE_RENDERER_SSE2)
+            __m128 rowTerm[3];
+            __m128 stepX[3];
+            for (int i = 0; i < 3; ++i)
+            {
+                rowTerm[i] = _mm_set1_ps(b[i] * pixelY + c[i]);
+                stepX[i] = _mm_set1_ps(a[i]);
+            }
+
+            const __m128 zero = _mm_setzero_ps();
+            const __m128i fill = _mm_set1_epi32((int)triangle.mColor);
+
+            for (int x = minX; x <= maxX; x += 4)
+            {
+                float baseX = (float)x + 0.5f;
+                __m128 pixelX = _mm_set_ps(baseX + 3.0f, baseX + 2.0f, baseX + 1.0f, baseX);
+
+                __m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(stepX[0], pixelX), rowTerm[0]), zero);
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(stepX[1], pixelX), rowTerm[1]), zero));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(stepX[2], pixelX), rowTerm[2]), zero));
+
+                if (0 == _mm_movemask_ps(inside))
+                {
+                    continue;
+                }
+
+                __m128i mask = _mm_castps_si128(inside);
+                __m128i* destination = reinterpret_cast<__m128i*>(row + x);
+                __m128i existing = _mm_loadu_si128(destination);
+                _mm_storeu_si128(destination, _mm_or_si128(_mm_and_si128(mask, fill), _mm_andnot_si128(mask, existing)));
+            }
+#else
+            for (int x = minX; x <= maxX; ++x)
+            {
+                float pixelX = (float)x + 0.5f;
+
+                if (((a[0] * pixelX + (b[0] * pixelY + c[0])) >= 0.0f)
+                    && ((a[1] * pixelX + (b[1] * pixelY + c[1])) >= 0.0f)
+                    && ((a[2] * pixelX + (b[2] * pixelY + c[2])) >= 0.0f))
+                {
+                    row[x] = triangle.mColor;
+                }
+            }
+#endif
+        }
+    }
+}
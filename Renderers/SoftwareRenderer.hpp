@@ -0,0 +1,74 @@
+#pragma once
+
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "SDL3/SDL.h"
+
+#include "Renderers/Renderer.hpp"
+
+class ThreadPool;
+
+// Tiled CPU rasterizer. Triangles are binned into fixed size screen tiles, and tiles are
+// shaded in parallel on a work-stealing pool, evaluating edge functions four pixels at a
+// time where SSE2 is available. Output is deterministic for a given input, so it doubles
+// as a reference backend on machines without a GPU.
+class SoftwareRenderer : public Renderer
+{
+public:
+    SoftwareRenderer(SDL_Window* aWindow);
+    ~SoftwareRenderer() override;
+
+    bool Initialize() override;
+    void Update() override;
+    void Resize(unsigned int aWidth, unsigned int aHeight) override;
+    virtual const char* Name() override { return "SoftwareRenderer"; };
+    MemoryReport GetMemoryReport() override;
+
+    // SDL's window surface calls belong on the main thread, the tiles already go wide.
+    bool RequiresGuiThread() override { return true; }
+
+protected:
+    PresentMode ApplyPresentMode(PresentMode aMode) override;
+
+private:
+    struct ScreenTriangle
+    {
+        // Screen space positions, wound so every edge function is positive inside.
+        float mX[3];
+        float mY[3];
+        Uint32 mColor;
+        int mMinX, mMinY, mMaxX, mMaxY;
+    };
+
+    static constexpr int cTileSize = 64;
+
+    void ResizeTargets(int aWidth, int aHeight);
+    void BinTriangles();
+    void RasterizeTile(size_t aTile);
+
+    // Setting SOFTWARE_RENDERER_THREADS gives us a pool of exactly that size, which is how we
+    // measure scaling with core count, otherwise we share the process pool.
+    std::unique_ptr<ThreadPool> mOwnedPool;
+    ThreadPool* mPool = nullptr;
+
+    // Color buffer padded out to whole tiles so tile loops never need edge checks. It's
+    // the window's size, mWidth by mHeight is how much of it this frame draws.
+    std::vector<Uint32> mColorBuffer;
+    SDL_Surface* mColorSurface = nullptr;
+    int mTargetWidth = 0;
+    int mTargetHeight = 0;
+    int mWidth = 0;
+    int mHeight = 0;
+    int mTilesX = 0;
+    int mTilesY = 0;
+    int mPitch = 0;
+
+    // Rebuilt every frame in the frame arena. The bins are one flat list of triangle
+    // indices, tile i's being [mBinOffsets[i], mBinOffsets[i + 1]).
+    std::span<ScreenTriangle> mTriangles;
+    std::span<Uint32> mBinOffsets;
+    std::span<Uint32> mBinTriangles;
+    Uint32 mClearPixel = 0;
+};
@@ -0,0 +1,387 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+
+#include "SDL3/SDL.h"
+
+#include "Renderers/TextureStreamer.hpp"
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Decoding:
+static bool DecodeBmp(const char* aPath, DecodedImage& aImage)
+{
+    SDL_Surface* loaded = SDL_LoadBMP(aPath);
+    if (nullptr == loaded)
+    {
+        return false;
+    }
+
+    SDL_Surface* converted = SDL_ConvertSurface(loaded, SDL_PIXELFORMAT_RGBA32);
+    SDL_DestroySurface(loaded);
+    if (nullptr == converted)
+    {
+        return false;
+    }
+
+    aImage.mWidth = (uint32_t)converted->w;
+    aImage.mHeight = (uint32_t)converted->h;
+    aImage.mPixels.resize((size_t)aImage.mWidth * aImage.mHeight * 4);
+
+    size_t rowBytes = (size_t)aImage.mWidth * 4;
+    for (uint32_t y = 0; y < aImage.mHeight; ++y)
+    {
+        memcpy(aImage.mPixels.data() + y * rowBytes, static_cast<const uint8_t*>(converted->pixels) + (size_t)y * converted->pitch, rowBytes);
+    }
+
+    SDL_DestroySurface(converted);
+    return true;
+}
+
+static std::mutex gDecoderMutex;
+static ImageDecoder gDecoder = DecodeBmp;
+
+void SetImageDecoder(ImageDecoder aDecoder)
+{
+    std::lock_guard lock{ gDecoderMutex };
+    gDecoder = std::move(aDecoder);
+}
+
+static ImageDecoder GetImageDecoder()
+{
+    std::lock_guard lock{ gDecoderMutex };
+    return gDecoder;
+}
+
+// 2x2 box filter, odd sized mips repeat their last row or column.
+static void Downsample(const std::vector<uint8_t>& aSource, uint32_t aWidth, uint32_t aHeight, std::vector<uint8_t>& aDestination, uint32_t aDestinationWidth, uint32_t aDestinationHeight)
+{
+    aDestination.resize((size_t)aDestinationWidth * aDestinationHeight * 4);
+
+    for (uint32_t y = 0; y < aDestinationHeight; ++y)
+    {
+        const uint8_t* row0 = aSource.data() + (size_t)std::min(2 * y, aHeight - 1) * aWidth * 4;
+        const uint8_t* row1 = aSource.data() + (size_t)std::min(2 * y + 1, aHeight - 1) * aWidth * 4;
+        uint8_t* destination = aDestination.data() + (size_t)y * aDestinationWidth * 4;
+
+        for (uint32_t x = 0; x < aDestinationWidth; ++x)
+        {
+            size_t x0 = (size_t)std::min(2 * x, aWidth - 1) * 4;
+            size_t x1 = (size_t)std::min(2 * x + 1, aWidth - 1) * 4;
+
+            for (size_t c = 0; c < 4; ++c)
+            {
+                destination[x * 4 + c] = (uint8_t)((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) / 4);
+            }
+        }
+    }
+}
+
+void TextureStreamer::Decode(Texture& aTexture)
+{
+    DecodedImage image;
+    ImageDecoder decoder = GetImageDecoder();
+
+    if (!decoder || !decoder(aTexture.mPath.c_str(), image) || (0 == image.mWidth) || (0 == image.mHeight))
+    {
+        printf("Failed to load image %s\n", aTexture.mPath.c_str());
+        aTexture.mState.store(State::Failed, std::memory_order_release);
+        return;
+    }
+
+    uint32_t mipCount = 1;
+    for (uint32_t size = std::max(image.mWidth, image.mHeight); size > 1; size /= 2)
+    {
+        ++mipCount;
+    }
+
+    std::vector<Mip> mips(mipCount);
+    mips[0].mWidth = image.mWidth;
+    mips[0].mHeight = image.mHeight;
+    mips[0].mPixels = std::move(image.mPixels);
+
+    for (uint32_t i = 1; i < mipCount; ++i)
+    {
+        const Mip& source = mips[i - 1];
+        Mip& mip = mips[i];
+        mip.mWidth = std::max(1u, source.mWidth / 2);
+        mip.mHeight = std::max(1u, source.mHeight / 2);
+        Downsample(source.mPixels, source.mWidth, source.mHeight, mip.mPixels, mip.mWidth, mip.mHeight);
+    }
+
+    aTexture.mMips = std::move(mips);
+    aTexture.mMipCount = mipCount;
+    aTexture.mState.store(State::Decoded, std::memory_order_release);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// TextureStreamer:
+TextureStreamer::TextureStreamer(TextureUploader& aUploader)
+    : mUploader{ aUploader }
+{
+    mBudgetBytes = 256ull * 1024 * 1024;
+    if (const char* budget = SDL_getenv("TEXTURE_BUDGET_MB"))
+    {
+        mBudgetBytes = (uint64_t)std::max(1, atoi(budget)) * 1024 * 1024;
+    }
+
+    mUploadBytesPerFrame = 4 * 1024 * 1024;
+    if (const char* upload = SDL_getenv("TEXTURE_UPLOAD_KB"))
+    {
+        mUploadBytesPerFrame = (size_t)std::max(1, atoi(upload)) * 1024;
+    }
+
+    // Half the pool, the other half is left for the frames the images are drawn in.
+    mMaxDecodes = std::max<size_t>(1, ThreadPool::Shared().ThreadCount() / 2);
+}
+
+TextureStreamer::~TextureStreamer()
+{
+    // Decodes write into our textures. The GPU textures are the backend's, they go with its
+    // device or context.
+    ThreadPool::Shared().Wait(mDecodeTasks);
+}
+
+void TextureStreamer::Clear()
+{
+    ThreadPool::Shared().Wait(mDecodeTasks);
+
+    // Everything with a GPU texture is in mLru, uploading or not.
+    while (!mLru.empty())
+    {
+        Release(*mLru.front());
+    }
+
+    mTextures.clear();
+    mDecodeQueue.clear();
+    mDecoding.clear();
+    mUploading.clear();
+    mStreaming = 0;
+}
+
+void TextureStreamer::Update()
+{
+    ++mFrame;
+
+    CollectDecodes();
+    StartDecodes();
+    Upload();
+    Evict();
+}
+
+uint64_t TextureStreamer::Acquire(const std::string& aPath)
+{
+    auto it = mTextures.find(aPath);
+    if (it == mTextures.end())
+    {
+        it = mTextures.emplace(aPath, std::make_unique<Texture>()).first;
+        it->second->mPath = aPath;
+    }
+
+    Texture& texture = *it->second;
+    texture.mLastUsedFrame = mFrame;
+
+    if (State::Unloaded == texture.mState.load(std::memory_order_relaxed))
+    {
+        texture.mState.store(State::Queued, std::memory_order_relaxed);
+        mDecodeQueue.push_back(&texture);
+        ++mStreaming;
+        return 0;
+    }
+
+    if (0 == texture.mGpuTexture)
+    {
+        return 0;
+    }
+
+    mLru.splice(mLru.begin(), mLru, texture.mLruPosition);
+    return (0 != texture.mResidentMips) ? texture.mGpuTexture : 0;
+}
+
+void TextureStreamer::ReportStats(RendererStats& aStats) const
+{
+    aStats.mTexturesResident = mResident;
+    aStats.mTexturesStreaming = mStreaming;
+    aStats.mTextureResidentBytes = mResidentBytes;
+    aStats.mTextureBudgetBytes = mBudgetBytes;
+    aStats.mTextureEvictions = mEvictions;
+}
+
+void TextureStreamer::CollectDecodes()
+{
+    std::erase_if(mDecoding, [this](Texture* aTexture)
+    {
+        State state = aTexture->mState.load(std::memory_order_acquire);
+        if (State::Decoding == state)
+        {
+            return false;
+        }
+
+        if (State::Decoded == state)
+        {
+            mUploading.push_back(aTexture);
+        }
+        else
+        {
+            --mStreaming;
+        }
+
+        return true;
+    });
+}
+
+void TextureStreamer::StartDecodes()
+{
+    while (!mDecodeQueue.empty() && (mDecoding.size() < mMaxDecodes))
+    {
+        Texture* texture = mDecodeQueue.front();
+        mDecodeQueue.pop_front();
+
+        // Not drawn since it was queued, say a panel scrolled past it. It's queued again if
+        // it comes back.
+        if ((texture->mLastUsedFrame + 1) < mFrame)
+        {
+            texture->mState.store(State::Unloaded, std::memory_order_relaxed);
+            --mStreaming;
+            continue;
+        }
+
+        texture->mState.store(State::Decoding, std::memory_order_relaxed);
+        mDecoding.push_back(texture);
+
+        ThreadPool::Shared().Submit(mDecodeTasks, [texture]()
+        {
+            Decode(*texture);
+        });
+    }
+}
+
+void TextureStreamer::Upload()
+{
+    if (mUploading.empty())
+    {
+        return;
+    }
+
+    mUploader.BeginUploads();
+
+    size_t remaining = mUploadBytesPerFrame;
+    bool uploadedAny = false;
+    bool stagingFull = false;
+    bool progress = true;
+
+    // A mip per texture per pass, so every texture gets its coarse mips before any one of
+    // them gets its finest.
+    while (progress && !stagingFull && (0 != remaining))
+    {
+        progress = false;
+
+        for (Texture* texture : mUploading)
+        {
+            if (State::Resident == texture->mState.load(std::memory_order_relaxed))
+            {
+                continue;
+            }
+
+            if (0 == texture->mGpuTexture)
+            {
+                const Mip& finest = texture->mMips[0];
+                texture->mGpuTexture = mUploader.CreateTexture(finest.mWidth, finest.mHeight, texture->mMipCount);
+
+                if (0 == texture->mGpuTexture)
+                {
+                    printf("Failed to create a texture for %s\n", texture->mPath.c_str());
+                    texture->mState.store(State::Failed, std::memory_order_relaxed);
+                    std::vector<Mip>().swap(texture->mMips);
+                    --mStreaming;
+                    continue;
+                }
+
+                // The whole chain counts from the start, most backends allocate it up front.
+                texture->mBytes = 0;
+                for (const Mip& mip : texture->mMips)
+                {
+                    texture->mBytes += mip.mPixels.size();
+                }
+
+                texture->mResidentMips = 0;
+                texture->mState.store(State::Uploading, std::memory_order_relaxed);
+                texture->mLruPosition = mLru.insert(mLru.begin(), texture);
+                mResidentBytes += texture->mBytes;
+                ++mResident;
+            }
+
+            uint32_t level = texture->mMipCount - 1 - texture->mResidentMips;
+            const Mip& mip = texture->mMips[level];
+
+            // The first upload of a frame always goes, or a mip bigger than the whole
+            // budget would never make it.
+            if (uploadedAny && (mip.mPixels.size() > remaining))
+            {
+                continue;
+            }
+
+            if (!mUploader.UploadMip(texture->mGpuTexture, level, mip.mWidth, mip.mHeight, mip.mPixels.data()))
+            {
+                stagingFull = true;
+                break;
+            }
+
+            remaining -= std::min(remaining, mip.mPixels.size());
+            uploadedAny = true;
+            progress = true;
+
+            if (++texture->mResidentMips == texture->mMipCount)
+            {
+                texture->mState.store(State::Resident, std::memory_order_relaxed);
+                std::vector<Mip>().swap(texture->mMips);
+                --mStreaming;
+            }
+        }
+    }
+
+    std::erase_if(mUploading, [](Texture* aTexture)
+    {
+        State state = aTexture->mState.load(std::memory_order_relaxed);
+        return (State::Resident == state) || (State::Failed == state);
+    });
+
+    mUploader.EndUploads();
+}
+
+void TextureStreamer::Evict()
+{
+    while ((mResidentBytes > mBudgetBytes) && !mLru.empty())
+    {
+        // Anything drawn last frame is probably still on screen, evicting it would only
+        // have it stream straight back in. Everything warmer is too, so we stay over budget.
+        Texture* texture = mLru.back();
+        if ((texture->mLastUsedFrame + 1) >= mFrame)
+        {
+            break;
+        }
+
+        Release(*texture);
+        ++mEvictions;
+    }
+}
+
+void TextureStreamer::Release(Texture& aTexture)
+{
+    mUploader.DestroyTexture(aTexture.mGpuTexture);
+    mLru.erase(aTexture.mLruPosition);
+    mResidentBytes -= aTexture.mBytes;
+    --mResident;
+
+    if (State::Resident != aTexture.mState.load(std::memory_order_relaxed))
+    {
+        std::erase(mUploading, &aTexture);
+        --mStreaming;
+    }
+
+    std::vector<Mip>().swap(aTexture.mMips);
+    aTexture.mGpuTexture = 0;
+    aTexture.mBytes = 0;
+    aTexture.mResidentMips = 0;
+    aTexture.mState.store(State::Unloaded, std::memory_order_relaxed);
+}
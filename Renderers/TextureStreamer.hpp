@@ -0,0 +1,161 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Renderers/Renderer.hpp"
+#include "Utilities/ThreadPool.hpp"
+
+// Tightly packed 8 bit RGBA, rows top to bottom.
+struct DecodedImage
+{
+    uint32_t mWidth = 0;
+    uint32_t mHeight = 0;
+    std::vector<uint8_t> mPixels;
+};
+
+// Reads and decodes an image file, called on pool threads. The default only knows BMP,
+// through SDL, hosts with a better image library at hand can replace it before any
+// renderer starts streaming.
+using ImageDecoder = std::function<bool(const char* aPath, DecodedImage& aImage)>;
+void SetImageDecoder(ImageDecoder aDecoder);
+
+// What a backend implements to get decoded mips onto its GPU. Everything is called from
+// TextureStreamer::Update on the rendering thread, between BeginUploads and EndUploads.
+class TextureUploader
+{
+public:
+    virtual ~TextureUploader() = default;
+
+    virtual void BeginUploads() {}
+    virtual void EndUploads() {}
+
+    // A texture with room for aMipCount mips, none of them resident yet. 0 on failure.
+    virtual uint64_t CreateTexture(uint32_t aWidth, uint32_t aHeight, uint32_t aMipCount) = 0;
+
+    // Copies one RGBA8 mip in through the backend's staging path, aPixels is only valid for
+    // the call. Mips arrive coarsest first, and the texture should be drawn with aLevel as
+    // its finest mip from here on. Returning false means staging is full for this frame,
+    // the mip is tried again next one.
+    virtual bool UploadMip(uint64_t aTexture, uint32_t aLevel, uint32_t aWidth, uint32_t aHeight, const uint8_t* aPixels) = 0;
+
+    // The texture may still be in use by frames in flight, backends that have to wait for
+    // those before freeing it do so themselves.
+    virtual void DestroyTexture(uint64_t aTexture) = 0;
+};
+
+// Streams image files into textures for one renderer. Files are read, decoded and mipped on
+// the shared pool, a few at a time so the pool stays free for rendering. Each frame uploads
+// at most a fixed number of bytes, a mip per texture at a time starting from the coarsest,
+// so many images show up blurry quickly and sharpen over the following frames rather than
+// one big upload stalling the panel.
+//
+// Resident textures are kept in least recently used order and evicted from the cold end
+// once they add up to more than the budget. An evicted texture streams in again from disk
+// the next time it's asked for.
+//
+// TEXTURE_BUDGET_MB sets the budget (256 MB by default), TEXTURE_UPLOAD_KB how much is
+// uploaded per frame (4 MB by default).
+class TextureStreamer
+{
+public:
+    explicit TextureStreamer(TextureUploader& aUploader);
+    ~TextureStreamer();
+
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+    // Picks up finished decodes, starts new ones, uploads this frame's share and evicts
+    // whatever's over budget. Once a frame, before the frame's Acquire calls.
+    void Update();
+
+    // The backend texture to draw aPath with this frame, or 0 if none of it is resident yet,
+    // in which case it starts streaming in. Marks the texture as used.
+    uint64_t Acquire(const std::string& aPath);
+
+    // Whether anything is still on its way, callers should keep drawing frames until not.
+    bool Busy() const { return 0 != mStreaming; }
+
+    size_t UploadBudget() const { return mUploadBytesPerFrame; }
+
+    // Hands every texture back to the uploader and forgets them, for backends tearing down
+    // while the uploader can still destroy them. Anything asked for later streams in again.
+    void Clear();
+
+    // Fills in the texture fields of aStats.
+    void ReportStats(RendererStats& aStats) const;
+
+private:
+    enum class State
+    {
+        Unloaded,
+        Queued,
+        Decoding,
+        Decoded,
+        Uploading,
+        Resident,
+        Failed
+    };
+
+    struct Mip
+    {
+        uint32_t mWidth = 0;
+        uint32_t mHeight = 0;
+        std::vector<uint8_t> mPixels;
+    };
+
+    struct Texture
+    {
+        std::string mPath;
+
+        // Written by the decoding task, which hands the texture back by storing Decoded or
+        // Failed. Nothing else touches mMips until then.
+        std::atomic<State> mState = State::Unloaded;
+
+        // Finest first, let go of once they're all on the GPU.
+        std::vector<Mip> mMips;
+
+        uint64_t mGpuTexture = 0;
+        uint64_t mBytes = 0;
+        uint32_t mMipCount = 0;
+        uint32_t mResidentMips = 0;
+        uint64_t mLastUsedFrame = 0;
+
+        // Only valid while mGpuTexture is, the front of mLru is the most recently used.
+        std::list<Texture*>::iterator mLruPosition;
+    };
+
+    static void Decode(Texture& aTexture);
+
+    void StartDecodes();
+    void CollectDecodes();
+    void Upload();
+    void Evict();
+    void Release(Texture& aTexture);
+
+    TextureUploader& mUploader;
+    uint64_t mBudgetBytes = 0;
+    size_t mUploadBytesPerFrame = 0;
+    size_t mMaxDecodes = 0;
+
+    // Entries are never erased, so decoding tasks can hold on to theirs.
+    std::unordered_map<std::string, std::unique_ptr<Texture>> mTextures;
+    std::list<Texture*> mLru;
+    std::deque<Texture*> mDecodeQueue;
+    std::vector<Texture*> mDecoding;
+    std::vector<Texture*> mUploading;
+    TaskGroup mDecodeTasks;
+
+    uint64_t mFrame = 0;
+    size_t mStreaming = 0;
+    size_t mResident = 0;
+    uint64_t mResidentBytes = 0;
+    uint64_t mEvictions = 0;
+};
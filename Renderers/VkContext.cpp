@@ -0,0 +1,753 @@
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include "SDL3/SDL_vulkan.h"
+
+#include "Renderers/Renderer.hpp"
+
+#include "Renderers/VkContext.hpp"
+#include "Renderers/VkRenderer.hpp"
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Helpers:
+static std::mutex gContextMutex;
+static std::unique_ptr<VkContext> gContext;
+
+VkBool32
+#ifdef SYSTEM_ANDROID
+__attribute__((pcs("aapcs-vfp")))
+#endif
+DebugUtilsCallback(
+    VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity,
+    VkDebugUtilsMessageTypeFlagsEXT messageType,
+    const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData,
+    void* /*pUserData*/)
+{
+    auto severity = vkb::to_string_message_severity(messageSeverity);
+    auto type = vkb::to_string_message_type(messageType);
+
+    if ((VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT & messageSeverity)
+        || (VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT & messageSeverity))
+    {
+        printf("[%s: %s] %s\n", severity, type, pCallbackData->pMessage);
+    }
+
+    return VK_FALSE;
+}
+
+static std::string PipelineCachePath()
+{
+    std::string path;
+
+    if (char* prefPath = SDL_GetPrefPath("playmer", "SDL3_Qt_Example"))
+    {
+        path = prefPath;
+        path += "vk_pipeline_cache.bin";
+        SDL_free(prefPath);
+    }
+
+    return path;
+}
+
+void FlushVkPendingPresents()
+{
+    if (VkContext* context = VkContext::Existing())
+    {
+        context->FlushFrames();
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Creation:
+VkContext* VkContext::Acquire(SDL_Window* aWindow, VkSurfaceKHR& aSurface)
+{
+    std::lock_guard lock{ gContextMutex };
+
+    // Surfaces need the instance, and the device is picked with the first surface, so
+    // whoever gets here first builds the whole thing.
+    std::unique_ptr<VkContext> created;
+    VkContext* context = gContext.get();
+
+    if (nullptr == context)
+    {
+        created.reset(new VkContext());
+
+        if (!created->CreateInstance())
+        {
+            return nullptr;
+        }
+
+        context = created.get();
+    }
+
+    if (!SDL_Vulkan_CreateSurface(aWindow, context->mInstance.instance, nullptr, &aSurface))
+    {
+        printf("Failed to create Vulkan Surface.\n");
+        return nullptr;
+    }
+
+    if (created)
+    {
+        if (!created->CreateDevice(aSurface))
+        {
+            // Before created takes the instance down with it.
+            SDL_Vulkan_DestroySurface(context->mInstance.instance, aSurface, nullptr);
+            aSurface = VK_NULL_HANDLE;
+            return nullptr;
+        }
+
+        gContext = std::move(created);
+        return gContext.get();
+    }
+
+    if (!context->CanPresentTo(aSurface))
+    {
+        printf("The shared Vulkan device can't present to this window.\n");
+        SDL_Vulkan_DestroySurface(context->mInstance.instance, aSurface, nullptr);
+        aSurface = VK_NULL_HANDLE;
+        return nullptr;
+    }
+
+    return context;
+}
+
+VkContext* VkContext::Existing()
+{
+    std::lock_guard lock{ gContextMutex };
+    return gContext.get();
+}
+
+VkContext::~VkContext()
+{
+    if (VK_NULL_HANDLE != mDevice.device)
+    {
+        vkDeviceWaitIdle(mDevice);
+
+        for (const InFlightSubmit& submit : mInFlight)
+        {
+            vkDestroyFence(mDevice, submit.mFence, mDevice.allocation_callbacks);
+        }
+
+        for (VkFence fence : mFreeFences)
+        {
+            vkDestroyFence(mDevice, fence, mDevice.allocation_callbacks);
+        }
+
+        vkDestroySemaphore(mDevice, mFrameTimeline, mDevice.allocation_callbacks);
+        vkDestroySemaphore(mDevice, mComputeTimeline, mDevice.allocation_callbacks);
+        vkDestroyPipelineCache(mDevice, mPipelineCache, mDevice.allocation_callbacks);
+        mRenderPassCache.Destroy();
+
+        if (VK_NULL_HANDLE != mAllocator)
+        {
+            vmaDestroyAllocator(mAllocator);
+        }
+
+        vkb::destroy_device(mDevice);
+    }
+
+    // Also takes the debug messenger.
+    if (VK_NULL_HANDLE != mInstance.instance)
+    {
+        vkb::destroy_instance(mInstance);
+    }
+}
+
+bool VkContext::CreateInstance()
+{
+    // Timeline semaphores are core in 1.2, so ask for that where the loader has it. Devices
+    // are still allowed to be 1.0, they just get the fence path.
+    auto enumerateInstanceVersion = reinterpret_cast<PFN_vkEnumerateInstanceVersion>(
+        vkGetInstanceProcAddr(VK_NULL_HANDLE, "vkEnumerateInstanceVersion"));
+
+    uint32_t loaderVersion = VK_API_VERSION_1_0;
+    if ((nullptr != enumerateInstanceVersion) && (VK_SUCCESS == enumerateInstanceVersion(&loaderVersion))
+        && (loaderVersion >= VK_API_VERSION_1_2))
+    {
+        mInstanceVersion = VK_API_VERSION_1_2;
+    }
+
+    vkb::InstanceBuilder instance_builder;
+    instance_builder
+        .set_app_name("Application")
+        .set_engine_name("SOIS")
+        .require_api_version(1, VK_API_VERSION_MINOR(mInstanceVersion), 0)
+        .set_debug_callback(&DebugUtilsCallback);
+
+    auto system_info_ret = vkb::SystemInfo::get_system_info();
+    if (!system_info_ret)
+    {
+        printf("%s\n", system_info_ret.error().message().c_str());
+        return false;
+    }
+
+    auto system_info = system_info_ret.value();
+    if (system_info.validation_layers_available) {
+        instance_builder.enable_validation_layers();
+    }
+
+    // Needed by VK_EXT_memory_budget on a 1.0 instance.
+    mHasPhysicalDeviceProperties2 = system_info.is_extension_available(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+    if (mHasPhysicalDeviceProperties2)
+    {
+        instance_builder.enable_extension(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+    }
+
+    Uint32 sdl_extensions_count;
+    const char* const* sdl_extensions = SDL_Vulkan_GetInstanceExtensions(&sdl_extensions_count);
+    if (nullptr == sdl_extensions)
+    {
+        printf("Failed to get required Vulkan Instance Extensions from SDL\n");
+        return false;
+    }
+
+    const char* const* extensions_end = sdl_extensions + sdl_extensions_count;
+    for (sdl_extensions; sdl_extensions < extensions_end; ++sdl_extensions)
+    {
+        instance_builder.enable_extension(*sdl_extensions);
+    }
+
+    auto instance_builder_return = instance_builder.build();
+
+    if (!instance_builder_return) {
+        printf("Failed to create Vulkan instance. Error: %s\n", instance_builder_return.error().message().c_str());
+        return false;
+    }
+    mInstance = instance_builder_return.value();
+
+    return true;
+}
+
+bool VkContext::CreateDevice(VkSurfaceKHR aSurface)
+{
+    ///////////////////////////////////////
+    // Select Physical Device
+    vkb::PhysicalDeviceSelector phys_device_selector(mInstance);
+    phys_device_selector.set_surface(aSurface);
+    phys_device_selector.set_minimum_version(1, 0);
+
+    {
+        auto physical_device_selector_return = phys_device_selector.select();
+
+        if (!physical_device_selector_return)
+        {
+            // We return out because there's really nothing we can do at this point, there's not a
+            // single suitable GPU on this system.
+            printf("Failed to select Vulkan Physical Device. Error: %s\n", physical_device_selector_return.error().message().c_str());
+            return false;
+        }
+        else
+        {
+            mPhysicalDevice = physical_device_selector_return.value();
+        }
+    }
+
+    // Lets us hand the presentation engine just the damaged rects when a frame only
+    // partially changed.
+    mSupportsIncrementalPresent = mPhysicalDevice.enable_extension_if_present(VK_KHR_INCREMENTAL_PRESENT_EXTENSION_NAME);
+
+    // Real heap budgets from the driver for the memory panel, VMA estimates them otherwise.
+    bool supportsMemoryBudget = mHasPhysicalDeviceProperties2
+        && mPhysicalDevice.enable_extension_if_present(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
+    ///////////////////////////////////////
+    // Create Logical Device
+    vkb::DeviceBuilder device_builder{ mPhysicalDevice };
+
+    VkPhysicalDeviceTimelineSemaphoreFeatures timelineFeatures = {};
+    timelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+    timelineFeatures.timelineSemaphore = VK_TRUE;
+
+    bool useTimelines = SupportsTimelineFeature();
+    if (useTimelines)
+    {
+        device_builder.add_pNext(&timelineFeatures);
+    }
+
+    auto dev_ret = device_builder.build();
+    if (!dev_ret) {
+        printf("Failed to create Logical Device. Error: %s\n", dev_ret.error().message().c_str());
+        return false;
+    }
+    mDevice = dev_ret.value();
+
+    ///////////////////////////////////////
+    // Get Queues
+    auto graphics_ret = mDevice.get_queue(vkb::QueueType::graphics);
+    auto present_ret = mDevice.get_queue(vkb::QueueType::present);
+    if (!graphics_ret || !present_ret)
+    {
+        printf("Failed to get the Vulkan graphics and present queues.\n");
+        return false;
+    }
+    mGraphicsQueue = graphics_ret.value();
+    mPresentQueue = present_ret.value();
+    mGraphicsQueueFamily = mDevice.get_queue_index(vkb::QueueType::graphics).value();
+
+    // A compute family separate from graphics if there is one, the graphics queue otherwise,
+    // in which case compute work is still submitted separately but doesn't overlap.
+    auto compute_ret = mDevice.get_queue(vkb::QueueType::compute);
+    if (compute_ret)
+    {
+        mComputeQueue = compute_ret.value();
+        mComputeQueueFamily = mDevice.get_queue_index(vkb::QueueType::compute).value();
+    }
+    else
+    {
+        mComputeQueue = mGraphicsQueue;
+        mComputeQueueFamily = mGraphicsQueueFamily;
+    }
+
+    if (useTimelines)
+    {
+        CreateTimelines();
+    }
+
+    printf("Vulkan frame pacing with %s, compute on %s queue\n",
+        SupportsTimelineSemaphores() ? "timeline semaphores" : "fences",
+        HasAsyncComputeQueue() ? "its own" : "the graphics");
+
+    ///////////////////////////////////////
+    // Create Allocator
+    VmaAllocatorCreateInfo allocatorInfo = {};
+    allocatorInfo.vulkanApiVersion = VK_API_VERSION_1_0;
+    allocatorInfo.physicalDevice = mPhysicalDevice;
+    allocatorInfo.device = mDevice;
+    allocatorInfo.instance = mInstance;
+    if (supportsMemoryBudget)
+    {
+        allocatorInfo.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
+    }
+
+    vmaCreateAllocator(&allocatorInfo, &mAllocator);
+    printf("Create allocator %p\n", mAllocator);
+
+    CreatePipelineCache();
+    mRenderPassCache.Initialize(mDevice);
+
+    return true;
+}
+
+bool VkContext::SupportsTimelineFeature()
+{
+    if (const char* timelines = SDL_getenv("VK_TIMELINE_SEMAPHORES"))
+    {
+        if (0 == strcmp(timelines, "0"))
+        {
+            return false;
+        }
+    }
+
+    if ((mInstanceVersion < VK_API_VERSION_1_2) || (mPhysicalDevice.properties.apiVersion < VK_API_VERSION_1_2))
+    {
+        return false;
+    }
+
+    VkPhysicalDeviceTimelineSemaphoreFeatures timelineFeatures = {};
+    timelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+
+    VkPhysicalDeviceFeatures2 features = {};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features.pNext = &timelineFeatures;
+    vkGetPhysicalDeviceFeatures2(mPhysicalDevice, &features);
+
+    return VK_TRUE == timelineFeatures.timelineSemaphore;
+}
+
+void VkContext::CreateTimelines()
+{
+    VkSemaphoreTypeCreateInfo type_info = {};
+    type_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    type_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    type_info.initialValue = 0;
+
+    VkSemaphoreCreateInfo semaphore_info = {};
+    semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphore_info.pNext = &type_info;
+
+    if ((VK_SUCCESS != vkCreateSemaphore(mDevice, &semaphore_info, mDevice.allocation_callbacks, &mFrameTimeline))
+        || (VK_SUCCESS != vkCreateSemaphore(mDevice, &semaphore_info, mDevice.allocation_callbacks, &mComputeTimeline)))
+    {
+        printf("Failed to create timeline semaphores, pacing frames with fences\n");
+        mFrameTimeline = VK_NULL_HANDLE;
+        mComputeTimeline = VK_NULL_HANDLE;
+    }
+}
+
+bool VkContext::CanPresentTo(VkSurfaceKHR aSurface)
+{
+    auto present_index = mDevice.get_queue_index(vkb::QueueType::present);
+    if (!present_index)
+    {
+        return false;
+    }
+
+    VkBool32 supported = VK_FALSE;
+    vkGetPhysicalDeviceSurfaceSupportKHR(mPhysicalDevice, present_index.value(), aSurface, &supported);
+    return VK_TRUE == supported;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Pipeline Cache:
+void VkContext::CreatePipelineCache()
+{
+    // Seed it from the last run if we can, the driver ignores data that doesn't match its
+    // device or version, so a stale file just means a cold cache.
+    std::string path = PipelineCachePath();
+    size_t size = 0;
+    void* data = path.empty() ? nullptr : SDL_LoadFile(path.c_str(), &size);
+
+    VkPipelineCacheCreateInfo info = {};
+    info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    info.initialDataSize = data ? size : 0;
+    info.pInitialData = data;
+
+    if (VK_SUCCESS != vkCreatePipelineCache(mDevice, &info, mDevice.allocation_callbacks, &mPipelineCache))
+    {
+        printf("Failed to create Vulkan pipeline cache\n");
+    }
+
+    SDL_free(data);
+}
+
+void VkContext::SavePipelineCache()
+{
+    std::string path = PipelineCachePath();
+    if (path.empty() || (VK_NULL_HANDLE == mPipelineCache))
+    {
+        return;
+    }
+
+    // Every renderer saves once its pipelines are built, one writer at a time.
+    std::lock_guard lock{ mPipelineCacheMutex };
+
+    size_t size = 0;
+    vkGetPipelineCacheData(mDevice, mPipelineCache, &size, nullptr);
+    std::vector<char> data(size);
+    if ((VK_SUCCESS == vkGetPipelineCacheData(mDevice, mPipelineCache, &size, data.data())) && (0 != size))
+    {
+        SDL_SaveFile(path.c_str(), data.data(), size);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Frame Coordination:
+uint64_t VkContext::QueueFrame(const VkPendingFrame& aFrame)
+{
+    FlushQueuedFrame(aFrame.mRenderer);
+
+    std::lock_guard lock{ mFrameMutex };
+    mPendingFrames.push_back(aFrame);
+    return mSubmittedSerial + 1;
+}
+
+void VkContext::FlushQueuedFrame(const VkRenderer* aRenderer)
+{
+    bool alreadyQueued = false;
+
+    // Flushes present under the lock, so if we don't find the frame here, whoever took it
+    // is done presenting it.
+    {
+        std::lock_guard lock{ mFrameMutex };
+        alreadyQueued = std::any_of(mPendingFrames.begin(), mPendingFrames.end(), [aRenderer](const VkPendingFrame& aPending)
+        {
+            return aPending.mRenderer == aRenderer;
+        });
+    }
+
+    if (alreadyQueued)
+    {
+        FlushFrames();
+    }
+}
+
+void VkContext::FlushFrames()
+{
+    static const VkPipelineStageFlags cWaitStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+
+    // Everything, including telling the renderers how it went, happens under the lock.
+    // Renderers only record the result there and leave any swapchain recreation to their
+    // next Update, so nothing in here comes back into the context.
+    std::lock_guard lock{ mFrameMutex };
+
+    if (mPendingFrames.empty())
+    {
+        return;
+    }
+
+    // Nobody may ever wait on some of these (a renderer that stopped drawing), so whatever
+    // has already finished gets recycled here.
+    RetireFinishedSubmits();
+
+    mSubmitScratch.resize(mPendingFrames.size());
+    mSubmitInfos.clear();
+    mSwapchains.clear();
+    mImageIndices.clear();
+    mPresentWaits.clear();
+    mPresentRegions.clear();
+    mPresentResults.assign(mPendingFrames.size(), VK_SUCCESS);
+    bool partialDamage = false;
+
+    bool timelines = SupportsTimelineSemaphores();
+    uint64_t serial = mSubmittedSerial + 1;
+
+    for (size_t i = 0; i < mPendingFrames.size(); ++i)
+    {
+        const VkPendingFrame& frame = mPendingFrames[i];
+        SubmitScratch& scratch = mSubmitScratch[i];
+
+        // Binary semaphores ignore their entries in the value arrays.
+        uint32_t waitCount = 0;
+        scratch.mWaits[waitCount] = frame.mImageAvailable;
+        scratch.mWaitStages[waitCount] = cWaitStage;
+        scratch.mWaitValues[waitCount++] = 0;
+
+        if (timelines && (0 != frame.mComputeWait))
+        {
+            scratch.mWaits[waitCount] = mComputeTimeline;
+            scratch.mWaitStages[waitCount] = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+            scratch.mWaitValues[waitCount++] = frame.mComputeWait;
+        }
+
+        // Signals happen in submission order, so the last submit of the batch signalling
+        // the serial covers all of it.
+        uint32_t signalCount = 0;
+        scratch.mSignals[signalCount] = frame.mRenderFinished;
+        scratch.mSignalValues[signalCount++] = 0;
+
+        if (timelines && ((i + 1) == mPendingFrames.size()))
+        {
+            scratch.mSignals[signalCount] = mFrameTimeline;
+            scratch.mSignalValues[signalCount++] = serial;
+        }
+
+        VkSubmitInfo submit = {};
+        submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submit.waitSemaphoreCount = waitCount;
+        submit.pWaitSemaphores = scratch.mWaits.data();
+        submit.pWaitDstStageMask = scratch.mWaitStages.data();
+        submit.commandBufferCount = 1;
+        submit.pCommandBuffers = &frame.mCommandBuffer;
+        submit.signalSemaphoreCount = signalCount;
+        submit.pSignalSemaphores = scratch.mSignals.data();
+
+        if (timelines)
+        {
+            scratch.mTimelineInfo = {};
+            scratch.mTimelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+            scratch.mTimelineInfo.waitSemaphoreValueCount = waitCount;
+            scratch.mTimelineInfo.pWaitSemaphoreValues = scratch.mWaitValues.data();
+            scratch.mTimelineInfo.signalSemaphoreValueCount = signalCount;
+            scratch.mTimelineInfo.pSignalSemaphoreValues = scratch.mSignalValues.data();
+            submit.pNext = &scratch.mTimelineInfo;
+        }
+
+        mSubmitInfos.push_back(submit);
+
+        mSwapchains.push_back(frame.mSwapchain);
+        mImageIndices.push_back(frame.mImageIndex);
+        mPresentWaits.push_back(frame.mRenderFinished);
+
+        // No rectangles means the whole image changed.
+        VkPresentRegionKHR region = {};
+        if ((nullptr != frame.mPresentRects) && !frame.mPresentRects->empty())
+        {
+            region.rectangleCount = (uint32_t)frame.mPresentRects->size();
+            region.pRectangles = frame.mPresentRects->data();
+            partialDamage = true;
+        }
+        mPresentRegions.push_back(region);
+    }
+
+    VkFence fence = timelines ? VK_NULL_HANDLE : GetFreeFence();
+
+    // On failure the serial stays unsubmitted, WaitForSerial knows nothing will signal it.
+    // None of the frames went out, so their acquire semaphores are left signalled with
+    // nothing to wait on them, and their images are never presented.
+    VkResult submitResult = vkQueueSubmit(mGraphicsQueue, (uint32_t)mSubmitInfos.size(), mSubmitInfos.data(), fence);
+    if (VK_SUCCESS != submitResult)
+    {
+        printf("failed to submit draw command buffers\n");
+        if (VK_NULL_HANDLE != fence)
+        {
+            mFreeFences.push_back(fence);
+        }
+
+        for (const VkPendingFrame& frame : mPendingFrames)
+        {
+            frame.mRenderer->OnFrameDropped(frame.mImageAvailable);
+            frame.mRenderer->OnFramePresented(submitResult, mPendingFrames.size());
+        }
+
+        mPendingFrames.clear();
+        return;
+    }
+
+    mSubmittedSerial = serial;
+    if (!timelines)
+    {
+        mInFlight.push_back(InFlightSubmit{ serial, fence });
+    }
+
+    VkPresentInfoKHR present_info = {};
+    present_info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+    present_info.waitSemaphoreCount = (uint32_t)mPresentWaits.size();
+    present_info.pWaitSemaphores = mPresentWaits.data();
+    present_info.swapchainCount = (uint32_t)mSwapchains.size();
+    present_info.pSwapchains = mSwapchains.data();
+    present_info.pImageIndices = mImageIndices.data();
+    present_info.pResults = mPresentResults.data();
+
+    VkPresentRegionsKHR present_regions = {};
+    if (mSupportsIncrementalPresent && partialDamage)
+    {
+        present_regions.sType = VK_STRUCTURE_TYPE_PRESENT_REGIONS_KHR;
+        present_regions.swapchainCount = (uint32_t)mPresentRegions.size();
+        present_regions.pRegions = mPresentRegions.data();
+        present_info.pNext = &present_regions;
+    }
+
+    VkResult result = vkQueuePresentKHR(mPresentQueue, &present_info);
+    if ((VK_SUCCESS != result) && (VK_SUBOPTIMAL_KHR != result) && (VK_ERROR_OUT_OF_DATE_KHR != result))
+    {
+        printf("failed to present swapchain images\n");
+    }
+
+    for (size_t i = 0; i < mPendingFrames.size(); ++i)
+    {
+        mPendingFrames[i].mRenderer->OnFramePresented(mPresentResults[i], mPendingFrames.size());
+    }
+
+    mPendingFrames.clear();
+}
+
+void VkContext::WaitForSerial(uint64_t aSerial)
+{
+    bool queued = false;
+
+    {
+        std::lock_guard lock{ mFrameMutex };
+        queued = aSerial > mSubmittedSerial;
+    }
+
+    // A frame that's only been queued has to go out before it can finish.
+    if (queued)
+    {
+        FlushFrames();
+    }
+
+    // If the flush failed to submit, the frame never went out and nothing will ever signal
+    // its serial, so we only wait for what did.
+    uint64_t serial = 0;
+
+    {
+        std::lock_guard lock{ mFrameMutex };
+        serial = std::min(aSerial, mSubmittedSerial);
+    }
+
+    // Waiting on a timeline needs no lock, and doesn't hold up anyone else's flush.
+    if (SupportsTimelineSemaphores())
+    {
+        VkSemaphoreWaitInfo wait_info = {};
+        wait_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+        wait_info.semaphoreCount = 1;
+        wait_info.pSemaphores = &mFrameTimeline;
+        wait_info.pValues = &serial;
+
+        VkResult result = vkWaitSemaphores(mDevice, &wait_info, UINT64_MAX);
+        if (VK_SUCCESS != result)
+        {
+            printf("failed to wait for frame serial %llu, VkResult = %d\n", (unsigned long long)serial, result);
+        }
+        return;
+    }
+
+    // Fences are waited on without the lock, so a slow frame doesn't hold up every other
+    // panel's flush. Nothing is retired while anyone is waiting, so the fence we copy out
+    // can't be reset and reused under us.
+    std::unique_lock lock{ mFrameMutex };
+    for (size_t i = 0; (i < mInFlight.size()) && (mInFlight[i].mSerial <= serial); ++i)
+    {
+        VkFence fence = mInFlight[i].mFence;
+        if (VK_SUCCESS == vkGetFenceStatus(mDevice, fence))
+        {
+            continue;
+        }
+
+        ++mFenceWaiters;
+        lock.unlock();
+        vkWaitForFences(mDevice, 1, &fence, VK_TRUE, UINT64_MAX);
+        lock.lock();
+        --mFenceWaiters;
+    }
+
+    RetireFinishedSubmits();
+}
+
+uint64_t VkContext::SubmitCompute(VkCommandBuffer aCommandBuffer)
+{
+    // The compute queue may well be the graphics queue, so it's under the same lock.
+    std::lock_guard lock{ mFrameMutex };
+
+    uint64_t value = mComputeValue + 1;
+
+    VkTimelineSemaphoreSubmitInfo timeline_info = {};
+    timeline_info.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timeline_info.signalSemaphoreValueCount = 1;
+    timeline_info.pSignalSemaphoreValues = &value;
+
+    VkSubmitInfo submit = {};
+    submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit.pNext = &timeline_info;
+    submit.commandBufferCount = 1;
+    submit.pCommandBuffers = &aCommandBuffer;
+    submit.signalSemaphoreCount = 1;
+    submit.pSignalSemaphores = &mComputeTimeline;
+
+    if (VK_SUCCESS != vkQueueSubmit(mComputeQueue, 1, &submit, VK_NULL_HANDLE))
+    {
+        printf("failed to submit compute command buffer\n");
+        return 0;
+    }
+
+    mComputeValue = value;
+    return value;
+}
+
+VkFence VkContext::GetFreeFence()
+{
+    if (!mFreeFences.empty())
+    {
+        VkFence fence = mFreeFences.back();
+        mFreeFences.pop_back();
+        return fence;
+    }
+
+    VkFenceCreateInfo fence_info = {};
+    fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+    VkFence fence = VK_NULL_HANDLE;
+    if (VK_SUCCESS != vkCreateFence(mDevice, &fence_info, mDevice.allocation_callbacks, &fence))
+    {
+        printf("Failed to create synchronization objects\n");
+    }
+
+    return fence;
+}
+
+void VkContext::RetireFinishedSubmits()
+{
+    if (0 != mFenceWaiters)
+    {
+        return;
+    }
+
+    while (!mInFlight.empty() && (VK_SUCCESS == vkGetFenceStatus(mDevice, mInFlight.front().mFence)))
+    {
+        vkResetFences(mDevice, 1, &mInFlight.front().mFence);
+        mFreeFences.push_back(mInFlight.front().mFence);
+        mInFlight.erase(mInFlight.begin());
+    }
+}
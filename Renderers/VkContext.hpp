@@ -0,0 +1,168 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "vulkan/vulkan.h"
+
+#include "vk_mem_alloc.h"
+
+#include "VkBootstrap.h"
+
+#include "SDL3/SDL.h"
+
+#include "Renderers/VkRenderPassCache.hpp"
+
+class VkRenderer;
+
+// A recorded frame waiting on the coordinator to submit and present it.
+struct VkPendingFrame
+{
+    VkRenderer* mRenderer = nullptr;
+    VkCommandBuffer mCommandBuffer = VK_NULL_HANDLE;
+    VkSemaphore mImageAvailable = VK_NULL_HANDLE;
+    VkSemaphore mRenderFinished = VK_NULL_HANDLE;
+    VkSwapchainKHR mSwapchain = VK_NULL_HANDLE;
+    uint32_t mImageIndex = 0;
+
+    // Empty when the whole image changed, only looked at with incremental present.
+    const std::vector<VkRectLayerKHR>* mPresentRects = nullptr;
+
+    // Compute timeline value the frame's vertex input has to wait for, 0 for none.
+    uint64_t mComputeWait = 0;
+};
+
+// Instance, device, queues, allocator and pipeline cache shared by every VkRenderer, so
+// panels don't each pay for a device, plus the frame coordinator. Renderers record their
+// frames and queue them here, then a flush hands all of them to the GPU in one
+// vkQueueSubmit and presents every swapchain in one vkQueuePresentKHR.
+class VkContext
+{
+public:
+    // Creates aWindow's surface, and on first use the context itself, picking a device
+    // that can present to that surface. Returns nullptr if there's no usable device.
+    // Thread-safe, renderers initialize on pool threads.
+    static VkContext* Acquire(SDL_Window* aWindow, VkSurfaceKHR& aSurface);
+
+    // nullptr until a renderer has acquired the context.
+    static VkContext* Existing();
+
+    // Goes at exit, after every renderer has released what it made from the device.
+    ~VkContext();
+
+    const vkb::Instance& GetInstance() const { return mInstance; }
+    const vkb::PhysicalDevice& GetPhysicalDevice() const { return mPhysicalDevice; }
+    const vkb::Device& GetDevice() const { return mDevice; }
+    VmaAllocator GetAllocator() const { return mAllocator; }
+    VkPipelineCache GetPipelineCache() const { return mPipelineCache; }
+    bool SupportsIncrementalPresent() const { return mSupportsIncrementalPresent; }
+
+    // Vulkan 1.2 timeline semaphores, which pace frames in place of per-submit fences and
+    // are what SubmitCompute needs. VK_TIMELINE_SEMAPHORES=0 forces the 1.0 path.
+    bool SupportsTimelineSemaphores() const { return VK_NULL_HANDLE != mFrameTimeline; }
+
+    // Whether compute has a queue family of its own, and so actually overlaps rendering,
+    // rather than sharing the graphics queue.
+    bool HasAsyncComputeQueue() const { return mComputeQueueFamily != mGraphicsQueueFamily; }
+    uint32_t GetComputeQueueFamily() const { return mComputeQueueFamily; }
+    uint32_t GetGraphicsQueueFamily() const { return mGraphicsQueueFamily; }
+
+    // Submits compute work right away and returns the compute timeline value it signals,
+    // which a queued frame can wait on through VkPendingFrame::mComputeWait. Timeline
+    // semaphores only.
+    uint64_t SubmitCompute(VkCommandBuffer aCommandBuffer);
+    VkRenderPassCache& GetRenderPassCache() { return mRenderPassCache; }
+
+    // Writes the pipeline cache to the pref path for the next run.
+    void SavePipelineCache();
+
+    // Queues a recorded frame for the next flush and returns the serial that flush will
+    // submit with. A swapchain can only be presented once per call, so a second frame
+    // from the same renderer flushes the batch it would have joined first.
+    uint64_t QueueFrame(const VkPendingFrame& aFrame);
+
+    // Flushes if aRenderer has a frame queued. Once this returns nobody is presenting to
+    // its swapchain until it queues another frame, so it can acquire without our lock.
+    void FlushQueuedFrame(const VkRenderer* aRenderer);
+
+    // Submits and presents everything queued, then tells each renderer how its present went.
+    // If the submit fails, every frame in it is dropped and its renderer told so instead.
+    // Steady state flushes reuse their scratch space and don't allocate.
+    void FlushFrames();
+
+    // Blocks until the flush with the given serial has finished on the GPU.
+    void WaitForSerial(uint64_t aSerial);
+
+private:
+    struct InFlightSubmit
+    {
+        uint64_t mSerial;
+        VkFence mFence;
+    };
+
+    VkContext() = default;
+
+    bool CreateInstance();
+    bool CreateDevice(VkSurfaceKHR aSurface);
+    bool SupportsTimelineFeature();
+    void CreateTimelines();
+    bool CanPresentTo(VkSurfaceKHR aSurface);
+    void CreatePipelineCache();
+    VkFence GetFreeFence();
+    // Recycles the fences of the oldest submits that have finished, unless someone is
+    // waiting on one outside the lock.
+    void RetireFinishedSubmits();
+
+    vkb::Instance mInstance;
+    vkb::PhysicalDevice mPhysicalDevice;
+    vkb::Device mDevice;
+    VkQueue mGraphicsQueue = VK_NULL_HANDLE;
+    VkQueue mPresentQueue = VK_NULL_HANDLE;
+    VkQueue mComputeQueue = VK_NULL_HANDLE;
+    uint32_t mGraphicsQueueFamily = 0;
+    uint32_t mComputeQueueFamily = 0;
+    uint32_t mInstanceVersion = VK_API_VERSION_1_0;
+    VmaAllocator mAllocator = VK_NULL_HANDLE;
+    VkPipelineCache mPipelineCache = VK_NULL_HANDLE;
+    bool mSupportsIncrementalPresent = false;
+    bool mHasPhysicalDeviceProperties2 = false;
+    VkRenderPassCache mRenderPassCache;
+
+    std::mutex mPipelineCacheMutex;
+
+    // Everything below is guarded by mFrameMutex, which also serializes queue access.
+    std::mutex mFrameMutex;
+    std::vector<VkPendingFrame> mPendingFrames;
+    std::vector<InFlightSubmit> mInFlight; // Oldest first, only ever a handful long.
+    std::vector<VkFence> mFreeFences;
+    size_t mFenceWaiters = 0;
+    uint64_t mSubmittedSerial = 0;
+
+    // With timeline semaphores a flush signals mFrameTimeline with its serial, and nothing
+    // goes into mInFlight. Compute submits count up mComputeTimeline on their own.
+    VkSemaphore mFrameTimeline = VK_NULL_HANDLE;
+    VkSemaphore mComputeTimeline = VK_NULL_HANDLE;
+    uint64_t mComputeValue = 0;
+
+    // Scratch for building the batch. The per frame wait and signal arrays the submit infos
+    // point into live in mSubmitScratch, which is sized before any pointers are taken.
+    struct SubmitScratch
+    {
+        std::array<VkSemaphore, 2> mWaits;
+        std::array<VkPipelineStageFlags, 2> mWaitStages;
+        std::array<uint64_t, 2> mWaitValues;
+        std::array<VkSemaphore, 2> mSignals;
+        std::array<uint64_t, 2> mSignalValues;
+        VkTimelineSemaphoreSubmitInfo mTimelineInfo;
+    };
+
+    std::vector<SubmitScratch> mSubmitScratch;
+    std::vector<VkSubmitInfo> mSubmitInfos;
+    std::vector<VkSwapchainKHR> mSwapchains;
+    std::vector<uint32_t> mImageIndices;
+    std::vector<VkSemaphore> mPresentWaits;
+    std::vector<VkPresentRegionKHR> mPresentRegions;
+    std::vector<VkResult> mPresentResults;
+};
@@ -0,0 +1,278 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "Renderers/VkGlyphAtlas.hpp"
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Buffers:
+bool VkGlyphAtlas::CreateBuffer(Buffer& aBuffer, size_t aCapacity, VkBufferUsageFlags aUsage)
+{
+    VkBufferCreateInfo buffer_info = {};
+    buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buffer_info.size = aCapacity;
+    buffer_info.usage = aUsage;
+    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    VmaAllocationCreateInfo allocation_info = {};
+    allocation_info.usage = VMA_MEMORY_USAGE_AUTO;
+    allocation_info.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+    VmaAllocationInfo allocated = {};
+    if (VK_SUCCESS != vmaCreateBuffer(mAllocator, &buffer_info, &allocation_info, &aBuffer.mBuffer, &aBuffer.mAllocation, &allocated))
+    {
+        printf("failed to create glyph buffer\n");
+        aBuffer = {};
+        return false;
+    }
+
+    aBuffer.mData = static_cast<uint8_t*>(allocated.pMappedData);
+    aBuffer.mCapacity = aCapacity;
+    return true;
+}
+
+void VkGlyphAtlas::ReleaseBuffer(Buffer& aBuffer)
+{
+    if (VK_NULL_HANDLE != aBuffer.mBuffer)
+    {
+        vmaDestroyBuffer(mAllocator, aBuffer.mBuffer, aBuffer.mAllocation);
+    }
+
+    aBuffer = {};
+}
+
+uint64_t VkGlyphAtlas::BufferBytes() const
+{
+    uint64_t bytes = 0;
+    for (const Buffer& buffer : mStaging)
+    {
+        bytes += buffer.mCapacity;
+    }
+
+    for (const Buffer& buffer : mInstances)
+    {
+        bytes += buffer.mCapacity;
+    }
+
+    return bytes;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// VkGlyphAtlas:
+void VkGlyphAtlas::Initialize(vkb::Device aDevice, VmaAllocator aAllocator, VkDescriptorPool aPool, VkDescriptorSetLayout aSetLayout, size_t aSlotCount)
+{
+    mDevice = aDevice;
+    mAllocator = aAllocator;
+
+    VkImageCreateInfo image_info = {};
+    image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    image_info.imageType = VK_IMAGE_TYPE_2D;
+    image_info.format = VK_FORMAT_R8_UNORM;
+    image_info.extent = { GlyphAtlas::cSize, GlyphAtlas::cSize, 1 };
+    image_info.mipLevels = 1;
+    image_info.arrayLayers = 1;
+    image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+    image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+    image_info.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    VmaAllocationCreateInfo allocation_info = {};
+    allocation_info.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
+
+    VmaAllocationInfo allocated = {};
+    if (VK_SUCCESS != vmaCreateImage(mAllocator, &image_info, &allocation_info, &mImage, &mImageAllocation, &allocated))
+    {
+        printf("failed to create glyph atlas image\n");
+        mImage = VK_NULL_HANDLE;
+        return;
+    }
+
+    mImageBytes = allocated.size;
+
+    VkImageViewCreateInfo view_info = {};
+    view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    view_info.image = mImage;
+    view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    view_info.format = image_info.format;
+    view_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    view_info.subresourceRange.levelCount = 1;
+    view_info.subresourceRange.layerCount = 1;
+
+    VkDescriptorSetAllocateInfo set_info = {};
+    set_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    set_info.descriptorPool = aPool;
+    set_info.descriptorSetCount = 1;
+    set_info.pSetLayouts = &aSetLayout;
+
+    // Without a set there's nothing to draw with, and Prepare won't try.
+    if ((VK_SUCCESS != vkCreateImageView(mDevice, &view_info, mDevice.allocation_callbacks, &mView))
+        || (VK_SUCCESS != vkAllocateDescriptorSets(mDevice, &set_info, &mSet)))
+    {
+        printf("failed to create glyph atlas view\n");
+        mSet = VK_NULL_HANDLE;
+        return;
+    }
+
+    VkDescriptorImageInfo descriptor_image = {};
+    descriptor_image.imageView = mView;
+    descriptor_image.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    VkWriteDescriptorSet write = {};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = mSet;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.pImageInfo = &descriptor_image;
+    vkUpdateDescriptorSets(mDevice, 1, &write, 0, nullptr);
+
+    // Instance buffers start out empty and grow with the text, staging is only made once
+    // there's text to stage.
+    mStaging.resize(aSlotCount);
+    mInstances.resize(aSlotCount);
+    mCopies.reserve(64);
+}
+
+void VkGlyphAtlas::Destroy()
+{
+    for (Buffer& buffer : mStaging)
+    {
+        ReleaseBuffer(buffer);
+    }
+
+    for (Buffer& buffer : mInstances)
+    {
+        ReleaseBuffer(buffer);
+    }
+
+    if (VK_NULL_HANDLE != mView)
+    {
+        vkDestroyImageView(mDevice, mView, mDevice.allocation_callbacks);
+        mView = VK_NULL_HANDLE;
+    }
+
+    if (VK_NULL_HANDLE != mImage)
+    {
+        vmaDestroyImage(mAllocator, mImage, mImageAllocation);
+        mImage = VK_NULL_HANDLE;
+        mImageAllocation = VK_NULL_HANDLE;
+    }
+
+    mSet = VK_NULL_HANDLE;
+    mImageBytes = 0;
+    mImageReady = false;
+}
+
+void VkGlyphAtlas::Prepare(size_t aSlot, VkCommandBuffer aCommandBuffer, std::span<const TextRun> aText, VkExtent2D aExtent, RendererStats& aStats)
+{
+    mSlot = aSlot;
+    mQuadCount = 0;
+    aStats.mGlyphUploadBytes = 0;
+
+    if ((VK_NULL_HANDLE == mSet) || aText.empty() || (0 == aExtent.width) || (0 == aExtent.height))
+    {
+        return;
+    }
+
+    // The slot's last frame is done, so its buffers can be swapped for bigger ones.
+    Buffer& instances = mInstances[aSlot];
+    size_t instanceBytes = GlyphAtlas::MaxQuads(aText) * sizeof(GlyphQuad);
+    if (instances.mCapacity < instanceBytes)
+    {
+        ReleaseBuffer(instances);
+        if (!CreateBuffer(instances, std::max(instanceBytes, instances.mCapacity * 2), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT))
+        {
+            return;
+        }
+    }
+
+    Buffer& staging = mStaging[aSlot];
+    if ((VK_NULL_HANDLE == staging.mBuffer) && !CreateBuffer(staging, (size_t)GlyphAtlas::cSize * GlyphAtlas::cSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT))
+    {
+        return;
+    }
+
+    // Rects don't overlap and never cover more than the atlas, so tightly packed they
+    // always fit in staging.
+    size_t staged = 0;
+    mCopies.clear();
+    uint64_t generation = mCursor.mGeneration;
+
+    std::span<GlyphQuad> quads{ reinterpret_cast<GlyphQuad*>(instances.mData), instanceBytes / sizeof(GlyphQuad) };
+    size_t quadCount = GlyphAtlas::Shared().Prepare(aText, (float)aExtent.width, (float)aExtent.height, quads, mCursor,
+        [this, &staging, &staged](const SDL_Rect& aRect, const uint8_t* aPixels, size_t aPitch)
+        {
+            VkBufferImageCopy copy = {};
+            copy.bufferOffset = staged;
+            copy.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            copy.imageSubresource.layerCount = 1;
+            copy.imageOffset = { aRect.x, aRect.y, 0 };
+            copy.imageExtent = { (uint32_t)aRect.w, (uint32_t)aRect.h, 1 };
+            mCopies.push_back(copy);
+
+            for (int y = 0; y < aRect.h; ++y)
+            {
+                memcpy(staging.mData + staged, aPixels + (size_t)y * aPitch, (size_t)aRect.w);
+                staged += (size_t)aRect.w;
+            }
+        });
+
+    vmaFlushAllocation(mAllocator, instances.mAllocation, 0, quadCount * sizeof(GlyphQuad));
+    mQuadCount = (uint32_t)quadCount;
+
+    if (generation != mCursor.mGeneration)
+    {
+        ++aStats.mGlyphFullUploads;
+    }
+
+    aStats.mGlyphUploadBytes = staged;
+    aStats.mGlyphsCached = GlyphAtlas::Shared().GlyphCount();
+
+    if (mCopies.empty())
+    {
+        return;
+    }
+
+    vmaFlushAllocation(mAllocator, staging.mAllocation, 0, staged);
+
+    // Earlier frames may still be sampling it, the copies have to wait for them. What they
+    // don't write is kept, so only the very first transition may discard.
+    VkImageMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.oldLayout = mImageReady ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = mImage;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.layerCount = 1;
+    vkCmdPipelineBarrier(aCommandBuffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    vkCmdCopyBufferToImage(aCommandBuffer, staging.mBuffer, mImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, (uint32_t)mCopies.size(), mCopies.data());
+
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    vkCmdPipelineBarrier(aCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    mImageReady = true;
+}
+
+void VkGlyphAtlas::Record(VkCommandBuffer aCommandBuffer, VkPipeline aPipeline, VkPipelineLayout aLayout)
+{
+    // Any quad means a glyph was uploaded, so the image is never drawn before it's ready.
+    if ((VK_NULL_HANDLE == aPipeline) || (0 == mQuadCount))
+    {
+        return;
+    }
+
+    VkDeviceSize offset = 0;
+    vkCmdBindPipeline(aCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, aPipeline);
+    vkCmdBindDescriptorSets(aCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, aLayout, 0, 1, &mSet, 0, nullptr);
+    vkCmdBindVertexBuffers(aCommandBuffer, 0, 1, &mInstances[mSlot].mBuffer, &offset);
+    vkCmdDraw(aCommandBuffer, 4, mQuadCount, 0, 0);
+}
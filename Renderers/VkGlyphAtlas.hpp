@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "vulkan/vulkan.h"
+
+#include "vk_mem_alloc.h"
+
+#include "VkBootstrap.h"
+
+#include "Renderers/GlyphAtlas.hpp"
+
+// A renderer's copy of the shared GlyphAtlas, and the glyph quads it draws from it. Only
+// what the atlas says is new gets copied, recorded into the frame's command buffer ahead of
+// its render pass, and each frame slot has its own staging and instance buffers so nothing
+// a frame in flight reads is written to.
+class VkGlyphAtlas
+{
+public:
+    // The atlas is bound through a set of aSetLayout, whose only binding is a combined image
+    // sampler with an immutable sampler.
+    void Initialize(vkb::Device aDevice, VmaAllocator aAllocator, VkDescriptorPool aPool, VkDescriptorSetLayout aSetLayout, size_t aSlotCount);
+
+    // Frees the atlas image and every buffer, nothing may be in flight. The set goes with
+    // the descriptor pool.
+    void Destroy();
+
+    // Lays aText out and records the uploads it needs into aCommandBuffer, outside of any
+    // render pass. The frame last recorded for aSlot has to be done.
+    void Prepare(size_t aSlot, VkCommandBuffer aCommandBuffer, std::span<const TextRun> aText, VkExtent2D aExtent, RendererStats& aStats);
+
+    // Draws what the last Prepare laid out, with a pipeline taking GlyphQuads as instances.
+    void Record(VkCommandBuffer aCommandBuffer, VkPipeline aPipeline, VkPipelineLayout aLayout);
+
+    uint64_t ImageBytes() const { return mImageBytes; }
+    uint64_t BufferBytes() const;
+
+private:
+    struct Buffer
+    {
+        VkBuffer mBuffer = VK_NULL_HANDLE;
+        VmaAllocation mAllocation = VK_NULL_HANDLE;
+        uint8_t* mData = nullptr;
+        size_t mCapacity = 0;
+    };
+
+    bool CreateBuffer(Buffer& aBuffer, size_t aCapacity, VkBufferUsageFlags aUsage);
+    void ReleaseBuffer(Buffer& aBuffer);
+
+    vkb::Device mDevice;
+    VmaAllocator mAllocator = VK_NULL_HANDLE;
+
+    VkImage mImage = VK_NULL_HANDLE;
+    VmaAllocation mImageAllocation = VK_NULL_HANDLE;
+    VkImageView mView = VK_NULL_HANDLE;
+    VkDescriptorSet mSet = VK_NULL_HANDLE;
+    uint64_t mImageBytes = 0;
+    bool mImageReady = false;
+
+    GlyphAtlasCursor mCursor;
+
+    // Staging holds a whole atlas, which is the most a frame can need.
+    std::vector<Buffer> mStaging;
+    std::vector<Buffer> mInstances;
+    std::vector<VkBufferImageCopy> mCopies;
+
+    size_t mSlot = 0;
+    uint32_t mQuadCount = 0;
+};
@@ -0,0 +1,572 @@
+#include <algorithm>
+#include <array>
+#include <cstdio>
+
+#include "Renderers/VkRenderGraph.hpp"
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Helpers:
+namespace
+{
+    // Where and how a pass touches an image. Everything a pass does to its images is either
+    // color attachment output or fragment shader sampling.
+    struct Use
+    {
+        VkImageLayout mLayout;
+        VkPipelineStageFlags mStage;
+        VkAccessFlags mAccess;
+    };
+
+    constexpr VkAccessFlags cWriteAccess = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+    // The first use of an image in a frame has to wait for whatever touched it last frame,
+    // or last in another image placed in the same memory, and for the swapchain's acquire,
+    // which submits wait on at color attachment output.
+    constexpr VkPipelineStageFlags cFirstUseSourceStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    constexpr VkAccessFlags cFirstUseSourceAccess = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+    bool Overlaps(uint32_t aFirst, uint32_t aLast, uint32_t aOtherFirst, uint32_t aOtherLast)
+    {
+        return !((aLast < aOtherFirst) || (aOtherLast < aFirst));
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// VkRenderGraph:
+void VkRenderGraph::Initialize(vkb::Device aDevice, VmaAllocator aAllocator, VkRenderPassCache* aRenderPassCache)
+{
+    mDevice = aDevice;
+    mAllocator = aAllocator;
+    mRenderPassCache = aRenderPassCache;
+}
+
+void VkRenderGraph::Reset()
+{
+    if (0 != mGeneration)
+    {
+        mRenderPassCache->ReleaseGeneration(mGeneration);
+        mGeneration = 0;
+    }
+
+    for (Image& image : mImages)
+    {
+        if (image.mImported)
+        {
+            continue;
+        }
+
+        if (VK_NULL_HANDLE != image.mView)
+        {
+            vkDestroyImageView(mDevice, image.mView, mDevice.allocation_callbacks);
+        }
+
+        if (VK_NULL_HANDLE != image.mHandle)
+        {
+            vkDestroyImage(mDevice, image.mHandle, mDevice.allocation_callbacks);
+        }
+    }
+
+    for (Block& block : mBlocks)
+    {
+        if (VK_NULL_HANDLE != block.mAllocation)
+        {
+            vmaFreeMemory(mAllocator, block.mAllocation);
+        }
+    }
+
+    mImages.clear();
+    mPasses.clear();
+    mBlocks.clear();
+    mFinalBarriers.clear();
+    mFramebuffers.clear();
+    mCompiled = false;
+    mStats = {};
+}
+
+VkRenderGraph::Resource VkRenderGraph::ImportImage(const char* aName, VkFormat aFormat, VkExtent2D aExtent, VkImageLayout aInitialLayout, VkImageLayout aFinalLayout)
+{
+    Image& image = mImages.emplace_back();
+    image.mName = aName;
+    image.mFormat = aFormat;
+    image.mExtent = aExtent;
+    image.mImported = true;
+    image.mInitialLayout = aInitialLayout;
+    image.mFinalLayout = aFinalLayout;
+    return (Resource)(mImages.size() - 1);
+}
+
+VkRenderGraph::Resource VkRenderGraph::CreateImage(const char* aName, VkFormat aFormat, VkExtent2D aExtent)
+{
+    Image& image = mImages.emplace_back();
+    image.mName = aName;
+    image.mFormat = aFormat;
+    image.mExtent = aExtent;
+    return (Resource)(mImages.size() - 1);
+}
+
+VkRenderGraph::Pass VkRenderGraph::AddPass(const char* aName, VkSubpassContents aContents, RecordFunction aRecord)
+{
+    PassData& pass = mPasses.emplace_back();
+    pass.mName = aName;
+    pass.mContents = aContents;
+    pass.mRecord = std::move(aRecord);
+    return (Pass)(mPasses.size() - 1);
+}
+
+void VkRenderGraph::Write(Pass aPass, Resource aImage, const VkClearColorValue* aClear)
+{
+    mPasses[aPass].mWrites.push_back(Attachment{ aImage, aClear });
+    mImages[aImage].mUsage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+}
+
+void VkRenderGraph::Read(Pass aPass, Resource aImage)
+{
+    mPasses[aPass].mReads.push_back(aImage);
+    mImages[aImage].mUsage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+}
+
+bool VkRenderGraph::Compile()
+{
+    if (!Cull())
+    {
+        return false;
+    }
+
+    ComputeBarriers();
+
+    if (!CreateTransients() || !PlaceTransients())
+    {
+        return false;
+    }
+
+    mGeneration = mRenderPassCache->NewGeneration();
+    mCompiled = true;
+    return true;
+}
+
+bool VkRenderGraph::Cull()
+{
+    // Walking backwards, a pass is needed if it writes something a needed pass reads, or
+    // an imported image. Writes that load rather than clear read what was there before.
+    std::vector<bool> needed(mImages.size(), false);
+    for (size_t i = mPasses.size(); 0 < i--;)
+    {
+        PassData& pass = mPasses[i];
+        for (const Attachment& write : pass.mWrites)
+        {
+            pass.mLive = pass.mLive || mImages[write.mImage].mImported || needed[write.mImage];
+        }
+
+        if (!pass.mLive)
+        {
+            ++mStats.mPassesCulled;
+            continue;
+        }
+
+        for (const Attachment& write : pass.mWrites)
+        {
+            needed[write.mImage] = (nullptr == write.mClear);
+        }
+
+        for (Resource read : pass.mReads)
+        {
+            needed[read] = true;
+        }
+    }
+
+    // Lifetimes, in live passes, and a check that every transient is written before it's
+    // read and that passes don't sample what they're drawing to.
+    uint32_t livePass = 0;
+    for (PassData& pass : mPasses)
+    {
+        if (!pass.mLive)
+        {
+            continue;
+        }
+
+        if (pass.mWrites.empty() || (VkRenderPassKey::cMaxAttachments < pass.mWrites.size()))
+        {
+            printf("Render graph pass %s has to write 1 to %u images\n", pass.mName, VkRenderPassKey::cMaxAttachments);
+            return false;
+        }
+
+        for (Resource read : pass.mReads)
+        {
+            Image& image = mImages[read];
+            bool feedback = std::any_of(pass.mWrites.begin(), pass.mWrites.end(), [read](const Attachment& aWrite)
+            {
+                return aWrite.mImage == read;
+            });
+
+            if (feedback)
+            {
+                printf("Render graph pass %s samples %s while drawing to it\n", pass.mName, image.mName);
+                return false;
+            }
+
+            if (!image.mImported && (cNone == image.mFirstPass))
+            {
+                printf("Render graph pass %s reads %s before it's been written\n", pass.mName, image.mName);
+                return false;
+            }
+
+            image.mLastPass = livePass;
+        }
+
+        for (const Attachment& write : pass.mWrites)
+        {
+            Image& image = mImages[write.mImage];
+            const Image& first = mImages[pass.mWrites[0].mImage];
+            if ((image.mExtent.width != first.mExtent.width) || (image.mExtent.height != first.mExtent.height))
+            {
+                printf("Render graph pass %s writes images of different sizes\n", pass.mName);
+                return false;
+            }
+
+            image.mFirstPass = std::min(image.mFirstPass, livePass);
+            image.mLastPass = livePass;
+        }
+
+        ++livePass;
+    }
+
+    mStats.mPasses = livePass;
+    return true;
+}
+
+void VkRenderGraph::ComputeBarriers()
+{
+    // Where each image was left by the passes so far.
+    std::vector<Use> state(mImages.size());
+    std::vector<bool> touched(mImages.size(), false);
+    for (size_t i = 0; i < mImages.size(); ++i)
+    {
+        state[i] = Use{ mImages[i].mInitialLayout, 0, 0 };
+    }
+
+    auto transition = [&](PassData& aPass, Resource aImage, Use aUse, bool aDiscard)
+    {
+        Use& previous = state[aImage];
+        if (!touched[aImage])
+        {
+            aPass.mBarriers.push_back(Barrier{ aImage, aDiscard ? VK_IMAGE_LAYOUT_UNDEFINED : previous.mLayout, aUse.mLayout,
+                cFirstUseSourceStage, cFirstUseSourceAccess, aUse.mStage, aUse.mAccess });
+        }
+        else
+        {
+            // Reads after reads in the same layout are the only uses that need nothing.
+            bool hazard = (0 != (previous.mAccess & cWriteAccess)) || (0 != (aUse.mAccess & cWriteAccess));
+            if (hazard || (previous.mLayout != aUse.mLayout))
+            {
+                aPass.mBarriers.push_back(Barrier{ aImage, aDiscard ? VK_IMAGE_LAYOUT_UNDEFINED : previous.mLayout, aUse.mLayout,
+                    previous.mStage, previous.mAccess & cWriteAccess, aUse.mStage, aUse.mAccess });
+            }
+        }
+
+        touched[aImage] = true;
+        previous = aUse;
+    };
+
+    uint32_t livePass = 0;
+    for (PassData& pass : mPasses)
+    {
+        if (!pass.mLive)
+        {
+            continue;
+        }
+
+        for (Resource read : pass.mReads)
+        {
+            transition(pass, read, Use{ VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT }, false);
+        }
+
+        // The render pass neither transitions nor synchronizes, that's all in the barriers.
+        // A transient nobody reads after this pass doesn't need to be stored.
+        VkRenderPassKey key;
+        key.mColorCount = (uint32_t)pass.mWrites.size();
+
+        for (uint32_t i = 0; i < key.mColorCount; ++i)
+        {
+            const Attachment& write = pass.mWrites[i];
+            const Image& image = mImages[write.mImage];
+            bool clear = (nullptr != write.mClear);
+
+            VkAccessFlags access = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | (clear ? 0 : VK_ACCESS_COLOR_ATTACHMENT_READ_BIT);
+            transition(pass, write.mImage, Use{ VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, access }, clear);
+
+            key.mColor[i].mFormat = image.mFormat;
+            key.mColor[i].mLoadOp = clear ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD;
+            key.mColor[i].mStoreOp = (image.mImported || (image.mLastPass != livePass)) ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            key.mColor[i].mInitialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+            key.mColor[i].mFinalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        }
+
+        pass.mRenderPass = mRenderPassCache->GetRenderPass(key);
+        mStats.mBarriers += (uint32_t)pass.mBarriers.size();
+        ++livePass;
+    }
+
+    for (size_t i = 0; i < mImages.size(); ++i)
+    {
+        const Image& image = mImages[i];
+        if (image.mImported && touched[i] && (state[i].mLayout != image.mFinalLayout))
+        {
+            mFinalBarriers.push_back(Barrier{ (Resource)i, state[i].mLayout, image.mFinalLayout,
+                state[i].mStage, state[i].mAccess & cWriteAccess, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0 });
+        }
+    }
+
+    mStats.mBarriers += (uint32_t)mFinalBarriers.size();
+}
+
+bool VkRenderGraph::CreateTransients()
+{
+    for (Image& image : mImages)
+    {
+        // Culled along with every pass that would have used it.
+        if (image.mImported || (cNone == image.mFirstPass))
+        {
+            continue;
+        }
+
+        VkImageCreateInfo image_info = {};
+        image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        image_info.imageType = VK_IMAGE_TYPE_2D;
+        image_info.format = image.mFormat;
+        image_info.extent = { image.mExtent.width, image.mExtent.height, 1 };
+        image_info.mipLevels = 1;
+        image_info.arrayLayers = 1;
+        image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+        image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+        image_info.usage = image.mUsage;
+        image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        if (VK_SUCCESS != vkCreateImage(mDevice, &image_info, mDevice.allocation_callbacks, &image.mHandle))
+        {
+            printf("failed to create render graph image %s\n", image.mName);
+            image.mHandle = VK_NULL_HANDLE;
+            return false;
+        }
+
+        vkGetImageMemoryRequirements(mDevice, image.mHandle, &image.mRequirements);
+        mStats.mTransientBytes += image.mRequirements.size;
+    }
+
+    return true;
+}
+
+bool VkRenderGraph::PlaceTransients()
+{
+    // Biggest first, each into the first block whose images are never alive at the same
+    // time as it and that's compatible with its memory types. Blocks grow to fit.
+    std::vector<Resource> order;
+    for (size_t i = 0; i < mImages.size(); ++i)
+    {
+        if (VK_NULL_HANDLE != mImages[i].mHandle && !mImages[i].mImported)
+        {
+            order.push_back((Resource)i);
+        }
+    }
+
+    std::sort(order.begin(), order.end(), [this](Resource aLeft, Resource aRight)
+    {
+        return mImages[aLeft].mRequirements.size > mImages[aRight].mRequirements.size;
+    });
+
+    for (Resource resource : order)
+    {
+        Image& image = mImages[resource];
+
+        for (uint32_t i = 0; (i < mBlocks.size()) && (cNone == image.mBlock); ++i)
+        {
+            Block& block = mBlocks[i];
+            bool compatible = 0 != (block.mRequirements.memoryTypeBits & image.mRequirements.memoryTypeBits);
+            bool disjoint = std::none_of(block.mImages.begin(), block.mImages.end(), [this, &image](Resource aOther)
+            {
+                const Image& other = mImages[aOther];
+                return Overlaps(image.mFirstPass, image.mLastPass, other.mFirstPass, other.mLastPass);
+            });
+
+            if (compatible && disjoint)
+            {
+                block.mRequirements.size = std::max(block.mRequirements.size, image.mRequirements.size);
+                block.mRequirements.alignment = std::max(block.mRequirements.alignment, image.mRequirements.alignment);
+                block.mRequirements.memoryTypeBits &= image.mRequirements.memoryTypeBits;
+                block.mImages.push_back(resource);
+                image.mBlock = i;
+            }
+        }
+
+        if (cNone == image.mBlock)
+        {
+            Block& block = mBlocks.emplace_back();
+            block.mRequirements = image.mRequirements;
+            block.mImages.push_back(resource);
+            image.mBlock = (uint32_t)(mBlocks.size() - 1);
+        }
+    }
+
+    VmaAllocationCreateInfo allocation_info = {};
+    allocation_info.preferredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+    for (Block& block : mBlocks)
+    {
+        if (VK_SUCCESS != vmaAllocateMemory(mAllocator, &block.mRequirements, &allocation_info, &block.mAllocation, nullptr))
+        {
+            printf("failed to allocate render graph memory\n");
+            block.mAllocation = VK_NULL_HANDLE;
+            return false;
+        }
+
+        mStats.mTransientAllocatedBytes += block.mRequirements.size;
+
+        for (Resource resource : block.mImages)
+        {
+            Image& image = mImages[resource];
+            if (VK_SUCCESS != vmaBindImageMemory(mAllocator, block.mAllocation, image.mHandle))
+            {
+                printf("failed to bind render graph image %s\n", image.mName);
+                return false;
+            }
+
+            VkImageViewCreateInfo view_info = {};
+            view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            view_info.image = image.mHandle;
+            view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+            view_info.format = image.mFormat;
+            view_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            view_info.subresourceRange.levelCount = 1;
+            view_info.subresourceRange.layerCount = 1;
+
+            if (VK_SUCCESS != vkCreateImageView(mDevice, &view_info, mDevice.allocation_callbacks, &image.mView))
+            {
+                printf("failed to create render graph view %s\n", image.mName);
+                image.mView = VK_NULL_HANDLE;
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+void VkRenderGraph::SetImportedImage(Resource aImage, VkImage aHandle, VkImageView aView)
+{
+    mImages[aImage].mHandle = aHandle;
+    mImages[aImage].mView = aView;
+}
+
+VkImageView VkRenderGraph::GetView(Resource aImage) const
+{
+    return mImages[aImage].mView;
+}
+
+VkFramebuffer VkRenderGraph::GetFramebuffer(const PassData& aPass)
+{
+    VkFramebufferKey key;
+    key.mRenderPass = aPass.mRenderPass;
+    key.mWidth = mImages[aPass.mWrites[0].mImage].mExtent.width;
+    key.mHeight = mImages[aPass.mWrites[0].mImage].mExtent.height;
+    key.mViewCount = (uint32_t)aPass.mWrites.size();
+
+    for (uint32_t i = 0; i < key.mViewCount; ++i)
+    {
+        key.mViews[i] = mImages[aPass.mWrites[i].mImage].mView;
+    }
+
+    // Only as many as passes times swapchain images, and skips the cache's lock.
+    for (const Framebuffer& framebuffer : mFramebuffers)
+    {
+        if (framebuffer.mKey == key)
+        {
+            return framebuffer.mFramebuffer;
+        }
+    }
+
+    VkFramebuffer framebuffer = mRenderPassCache->GetFramebuffer(key, mGeneration);
+    mFramebuffers.push_back(Framebuffer{ key, framebuffer });
+    return framebuffer;
+}
+
+void VkRenderGraph::IssueBarriers(VkCommandBuffer aCommandBuffer, const std::vector<Barrier>& aBarriers)
+{
+    if (aBarriers.empty())
+    {
+        return;
+    }
+
+    VkPipelineStageFlags sourceStages = 0;
+    VkPipelineStageFlags destinationStages = 0;
+    mScratch.clear();
+
+    for (const Barrier& barrier : aBarriers)
+    {
+        VkImageMemoryBarrier& image_barrier = mScratch.emplace_back();
+        image_barrier = {};
+        image_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        image_barrier.srcAccessMask = barrier.mSourceAccess;
+        image_barrier.dstAccessMask = barrier.mDestinationAccess;
+        image_barrier.oldLayout = barrier.mOldLayout;
+        image_barrier.newLayout = barrier.mNewLayout;
+        image_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        image_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        image_barrier.image = mImages[barrier.mImage].mHandle;
+        image_barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        image_barrier.subresourceRange.levelCount = 1;
+        image_barrier.subresourceRange.layerCount = 1;
+
+        sourceStages |= barrier.mSourceStage;
+        destinationStages |= barrier.mDestinationStage;
+    }
+
+    vkCmdPipelineBarrier(aCommandBuffer, sourceStages, destinationStages, 0, 0, nullptr, 0, nullptr, (uint32_t)mScratch.size(), mScratch.data());
+}
+
+void VkRenderGraph::Execute(VkCommandBuffer aCommandBuffer)
+{
+    if (!mCompiled)
+    {
+        return;
+    }
+
+    for (PassData& pass : mPasses)
+    {
+        if (!pass.mLive || (VK_NULL_HANDLE == pass.mRenderPass))
+        {
+            continue;
+        }
+
+        IssueBarriers(aCommandBuffer, pass.mBarriers);
+
+        std::array<VkClearValue, VkRenderPassKey::cMaxAttachments> clearValues = {};
+        for (size_t i = 0; i < pass.mWrites.size(); ++i)
+        {
+            if (nullptr != pass.mWrites[i].mClear)
+            {
+                clearValues[i].color = *pass.mWrites[i].mClear;
+            }
+        }
+
+        VkGraphPassContext context;
+        context.mCommandBuffer = aCommandBuffer;
+        context.mRenderPass = pass.mRenderPass;
+        context.mFramebuffer = GetFramebuffer(pass);
+        context.mExtent = mImages[pass.mWrites[0].mImage].mExtent;
+        context.mContents = pass.mContents;
+
+        VkRenderPassBeginInfo info = {};
+        info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        info.renderPass = context.mRenderPass;
+        info.framebuffer = context.mFramebuffer;
+        info.renderArea.extent = context.mExtent;
+        info.clearValueCount = (uint32_t)pass.mWrites.size();
+        info.pClearValues = clearValues.data();
+
+        vkCmdBeginRenderPass(aCommandBuffer, &info, pass.mContents);
+        pass.mRecord(context);
+        vkCmdEndRenderPass(aCommandBuffer);
+    }
+
+    IssueBarriers(aCommandBuffer, mFinalBarriers);
+}
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "vulkan/vulkan.h"
+
+#include "vk_mem_alloc.h"
+
+#include "VkBootstrap.h"
+
+#include "Renderers/VkRenderPassCache.hpp"
+
+// What a pass's record function gets, the render pass is already begun on mCommandBuffer.
+// mRenderPass and mFramebuffer are there for secondary buffers to inherit.
+struct VkGraphPassContext
+{
+    VkCommandBuffer mCommandBuffer = VK_NULL_HANDLE;
+    VkRenderPass mRenderPass = VK_NULL_HANDLE;
+    VkFramebuffer mFramebuffer = VK_NULL_HANDLE;
+    VkExtent2D mExtent = {};
+    VkSubpassContents mContents = VK_SUBPASS_CONTENTS_INLINE;
+};
+
+// Passes declared up front with the images they write as color attachments and the images
+// they sample, compiled once and then executed every frame. Compiling culls every pass
+// whose writes nothing reads (passes writing an imported image always count as read),
+// works out the layout transitions and barriers between the passes that are left, and
+// places transient images whose lifetimes don't overlap in the same memory.
+//
+// Imported images, the swapchain's, are owned by the caller, who hands over this frame's
+// image before each Execute. Transient images are the graph's, and only live between the
+// first pass that writes them and the last one that reads them, every frame.
+class VkRenderGraph
+{
+public:
+    using Resource = uint32_t;
+    using Pass = uint32_t;
+    using RecordFunction = std::function<void(const VkGraphPassContext&)>;
+
+    struct Stats
+    {
+        uint32_t mPasses = 0;
+        uint32_t mPassesCulled = 0;
+        uint32_t mBarriers = 0;
+
+        // What the transients would take in memory of their own, against what they take
+        // with the ones that are never alive at the same time sharing.
+        uint64_t mTransientBytes = 0;
+        uint64_t mTransientAllocatedBytes = 0;
+    };
+
+    void Initialize(vkb::Device aDevice, VmaAllocator aAllocator, VkRenderPassCache* aRenderPassCache);
+
+    // Destroys the compiled graph and everything it made, none of it may still be in use on
+    // the GPU. Passes and resources have to be declared again before the next Compile.
+    void Reset();
+
+    // aInitialLayout is what the image is in when a frame starts, UNDEFINED if its contents
+    // don't matter. It's left in aFinalLayout when the frame's passes are done.
+    Resource ImportImage(const char* aName, VkFormat aFormat, VkExtent2D aExtent, VkImageLayout aInitialLayout, VkImageLayout aFinalLayout);
+    Resource CreateImage(const char* aName, VkFormat aFormat, VkExtent2D aExtent);
+
+    Pass AddPass(const char* aName, VkSubpassContents aContents, RecordFunction aRecord);
+
+    // A pass's color attachments are bound in the order they're written. With aClear the
+    // attachment is cleared to whatever it points at when the pass runs, without it the
+    // previous contents are loaded.
+    void Write(Pass aPass, Resource aImage, const VkClearColorValue* aClear);
+    void Read(Pass aPass, Resource aImage);
+
+    bool Compile();
+
+    // This frame's imported image, needed for every imported resource before each Execute.
+    void SetImportedImage(Resource aImage, VkImage aHandle, VkImageView aView);
+
+    // Valid once compiled, for transients only read by later passes until the next Reset.
+    VkImageView GetView(Resource aImage) const;
+
+    void Execute(VkCommandBuffer aCommandBuffer);
+
+    const Stats& GetStats() const { return mStats; }
+
+private:
+    static constexpr uint32_t cNone = UINT32_MAX;
+
+    struct Image
+    {
+        const char* mName = nullptr;
+        VkFormat mFormat = VK_FORMAT_UNDEFINED;
+        VkExtent2D mExtent = {};
+        bool mImported = false;
+        VkImageLayout mInitialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkImageLayout mFinalLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkImageUsageFlags mUsage = 0;
+
+        VkImage mHandle = VK_NULL_HANDLE;
+        VkImageView mView = VK_NULL_HANDLE;
+
+        // Live passes that first and last touch it, and the memory block it's placed in.
+        uint32_t mFirstPass = cNone;
+        uint32_t mLastPass = cNone;
+        uint32_t mBlock = cNone;
+        VkMemoryRequirements mRequirements = {};
+    };
+
+    struct Attachment
+    {
+        Resource mImage;
+        const VkClearColorValue* mClear;
+    };
+
+    struct Barrier
+    {
+        Resource mImage;
+        VkImageLayout mOldLayout;
+        VkImageLayout mNewLayout;
+        VkPipelineStageFlags mSourceStage;
+        VkAccessFlags mSourceAccess;
+        VkPipelineStageFlags mDestinationStage;
+        VkAccessFlags mDestinationAccess;
+    };
+
+    struct PassData
+    {
+        const char* mName = nullptr;
+        VkSubpassContents mContents = VK_SUBPASS_CONTENTS_INLINE;
+        RecordFunction mRecord;
+        std::vector<Attachment> mWrites;
+        std::vector<Resource> mReads;
+        bool mLive = false;
+
+        VkRenderPass mRenderPass = VK_NULL_HANDLE;
+        std::vector<Barrier> mBarriers;
+    };
+
+    struct Block
+    {
+        VkMemoryRequirements mRequirements = {};
+        VmaAllocation mAllocation = VK_NULL_HANDLE;
+        std::vector<Resource> mImages;
+    };
+
+    struct Framebuffer
+    {
+        VkFramebufferKey mKey;
+        VkFramebuffer mFramebuffer;
+    };
+
+    bool Cull();
+    void ComputeBarriers();
+    bool CreateTransients();
+    bool PlaceTransients();
+    VkFramebuffer GetFramebuffer(const PassData& aPass);
+    void IssueBarriers(VkCommandBuffer aCommandBuffer, const std::vector<Barrier>& aBarriers);
+
+    vkb::Device mDevice;
+    VmaAllocator mAllocator = VK_NULL_HANDLE;
+    VkRenderPassCache* mRenderPassCache = nullptr;
+
+    std::vector<Image> mImages;
+    std::vector<PassData> mPasses;
+    std::vector<Block> mBlocks;
+
+    // Transitions of imported images into their final layouts, after the last pass.
+    std::vector<Barrier> mFinalBarriers;
+
+    // Framebuffers are per imported image, so a few per pass, all made under mGeneration.
+    std::vector<Framebuffer> mFramebuffers;
+    uint64_t mGeneration = 0;
+
+    // Reused by Execute so it doesn't allocate.
+    std::vector<VkImageMemoryBarrier> mScratch;
+
+    bool mCompiled = false;
+    Stats mStats;
+};
@@ -0,0 +1,199 @@
+#include <cstdio>
+
+#include "Renderers/VkRenderPassCache.hpp"
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Helpers:
+// Keys have padding, so they're hashed a field at a time rather than as raw bytes.
+template <typename tType>
+static uint64_t Fnv1a(const tType& aValue, uint64_t aHash)
+{
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&aValue);
+    for (size_t i = 0; i < sizeof(tType); ++i)
+    {
+        aHash ^= bytes[i];
+        aHash *= 0x100000001b3ull;
+    }
+
+    return aHash;
+}
+
+static constexpr uint64_t cFnvOffset = 0xcbf29ce484222325ull;
+
+size_t VkRenderPassCache::RenderPassKeyHash::operator()(const VkRenderPassKey& aKey) const
+{
+    uint64_t hash = Fnv1a(aKey.mColorCount, cFnvOffset);
+    for (uint32_t i = 0; i < aKey.mColorCount; ++i)
+    {
+        const VkAttachmentKey& attachment = aKey.mColor[i];
+        hash = Fnv1a(attachment.mFormat, hash);
+        hash = Fnv1a(attachment.mSamples, hash);
+        hash = Fnv1a(attachment.mLoadOp, hash);
+        hash = Fnv1a(attachment.mStoreOp, hash);
+        hash = Fnv1a(attachment.mInitialLayout, hash);
+        hash = Fnv1a(attachment.mFinalLayout, hash);
+    }
+
+    return (size_t)hash;
+}
+
+size_t VkRenderPassCache::FramebufferKeyHash::operator()(const VkFramebufferKey& aKey) const
+{
+    uint64_t hash = Fnv1a(aKey.mRenderPass, cFnvOffset);
+    hash = Fnv1a(aKey.mWidth, hash);
+    hash = Fnv1a(aKey.mHeight, hash);
+    hash = Fnv1a(aKey.mViewCount, hash);
+    for (uint32_t i = 0; i < aKey.mViewCount; ++i)
+    {
+        hash = Fnv1a(aKey.mViews[i], hash);
+    }
+
+    return (size_t)hash;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// VkRenderPassCache:
+void VkRenderPassCache::Initialize(vkb::Device aDevice)
+{
+    mDevice = aDevice;
+}
+
+VkRenderPass VkRenderPassCache::GetRenderPass(const VkRenderPassKey& aKey)
+{
+    std::lock_guard lock{ mMutex };
+
+    if (auto it = mRenderPasses.find(aKey); it != mRenderPasses.end())
+    {
+        ++mStats.mRenderPassHits;
+        return it->second;
+    }
+
+    std::array<VkAttachmentDescription, VkRenderPassKey::cMaxAttachments> attachments = {};
+    std::array<VkAttachmentReference, VkRenderPassKey::cMaxAttachments> references = {};
+
+    for (uint32_t i = 0; i < aKey.mColorCount; ++i)
+    {
+        const VkAttachmentKey& key = aKey.mColor[i];
+        attachments[i].format = key.mFormat;
+        attachments[i].samples = key.mSamples;
+        attachments[i].loadOp = key.mLoadOp;
+        attachments[i].storeOp = key.mStoreOp;
+        attachments[i].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        attachments[i].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        attachments[i].initialLayout = key.mInitialLayout;
+        attachments[i].finalLayout = key.mFinalLayout;
+
+        references[i].attachment = i;
+        references[i].layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    }
+
+    VkSubpassDescription subpass = {};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = aKey.mColorCount;
+    subpass.pColorAttachments = references.data();
+
+    VkSubpassDependency dependency = {};
+    dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+    dependency.dstSubpass = 0;
+    dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependency.srcAccessMask = 0;
+    dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+    VkRenderPassCreateInfo render_pass_info = {};
+    render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    render_pass_info.attachmentCount = aKey.mColorCount;
+    render_pass_info.pAttachments = attachments.data();
+    render_pass_info.subpassCount = 1;
+    render_pass_info.pSubpasses = &subpass;
+    render_pass_info.dependencyCount = 1;
+    render_pass_info.pDependencies = &dependency;
+
+    VkRenderPass renderPass = VK_NULL_HANDLE;
+    if (vkCreateRenderPass(mDevice, &render_pass_info, mDevice.allocation_callbacks, &renderPass) != VK_SUCCESS)
+    {
+        printf("failed to create render pass\n");
+        return VK_NULL_HANDLE;
+    }
+
+    ++mStats.mRenderPassesCreated;
+    mRenderPasses.emplace(aKey, renderPass);
+    return renderPass;
+}
+
+VkFramebuffer VkRenderPassCache::GetFramebuffer(const VkFramebufferKey& aKey, uint64_t aGeneration)
+{
+    std::lock_guard lock{ mMutex };
+
+    if (auto it = mFramebuffers.find(aKey); it != mFramebuffers.end())
+    {
+        ++mStats.mFramebufferHits;
+        return it->second.mFramebuffer;
+    }
+
+    VkFramebufferCreateInfo framebuffer_info = {};
+    framebuffer_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    framebuffer_info.renderPass = aKey.mRenderPass;
+    framebuffer_info.attachmentCount = aKey.mViewCount;
+    framebuffer_info.pAttachments = aKey.mViews.data();
+    framebuffer_info.width = aKey.mWidth;
+    framebuffer_info.height = aKey.mHeight;
+    framebuffer_info.layers = 1;
+
+    VkFramebuffer framebuffer = VK_NULL_HANDLE;
+    if (vkCreateFramebuffer(mDevice, &framebuffer_info, mDevice.allocation_callbacks, &framebuffer) != VK_SUCCESS)
+    {
+        printf("failed to create framebuffer\n");
+        return VK_NULL_HANDLE;
+    }
+
+    ++mStats.mFramebuffersCreated;
+    mFramebuffers.emplace(aKey, CachedFramebuffer{ framebuffer, aGeneration });
+    return framebuffer;
+}
+
+uint64_t VkRenderPassCache::NewGeneration()
+{
+    std::lock_guard lock{ mMutex };
+    return mNextGeneration++;
+}
+
+void VkRenderPassCache::ReleaseGeneration(uint64_t aGeneration)
+{
+    std::lock_guard lock{ mMutex };
+
+    std::erase_if(mFramebuffers, [this, aGeneration](const auto& aEntry)
+    {
+        if (aEntry.second.mGeneration != aGeneration)
+        {
+            return false;
+        }
+
+        vkDestroyFramebuffer(mDevice, aEntry.second.mFramebuffer, mDevice.allocation_callbacks);
+        return true;
+    });
+}
+
+void VkRenderPassCache::Destroy()
+{
+    std::lock_guard lock{ mMutex };
+
+    for (auto& [key, framebuffer] : mFramebuffers)
+    {
+        vkDestroyFramebuffer(mDevice, framebuffer.mFramebuffer, mDevice.allocation_callbacks);
+    }
+
+    for (auto& [key, renderPass] : mRenderPasses)
+    {
+        vkDestroyRenderPass(mDevice, renderPass, mDevice.allocation_callbacks);
+    }
+
+    mFramebuffers.clear();
+    mRenderPasses.clear();
+}
+
+VkRenderPassCache::Stats VkRenderPassCache::GetStats()
+{
+    std::lock_guard lock{ mMutex };
+    return mStats;
+}
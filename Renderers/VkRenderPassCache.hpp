@@ -0,0 +1,105 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+#include "vulkan/vulkan.h"
+
+#include "VkBootstrap.h"
+
+// Everything about an attachment that a render pass bakes in.
+struct VkAttachmentKey
+{
+    VkFormat mFormat = VK_FORMAT_UNDEFINED;
+    VkSampleCountFlagBits mSamples = VK_SAMPLE_COUNT_1_BIT;
+    VkAttachmentLoadOp mLoadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    VkAttachmentStoreOp mStoreOp = VK_ATTACHMENT_STORE_OP_STORE;
+    VkImageLayout mInitialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    VkImageLayout mFinalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+    bool operator==(const VkAttachmentKey&) const = default;
+};
+
+// A single subpass writing every color attachment, which is all any renderer here needs.
+struct VkRenderPassKey
+{
+    static constexpr uint32_t cMaxAttachments = 4;
+
+    std::array<VkAttachmentKey, cMaxAttachments> mColor = {};
+    uint32_t mColorCount = 0;
+
+    bool operator==(const VkRenderPassKey&) const = default;
+};
+
+struct VkFramebufferKey
+{
+    VkRenderPass mRenderPass = VK_NULL_HANDLE;
+    uint32_t mWidth = 0;
+    uint32_t mHeight = 0;
+    std::array<VkImageView, VkRenderPassKey::cMaxAttachments> mViews = {};
+    uint32_t mViewCount = 0;
+
+    bool operator==(const VkFramebufferKey&) const = default;
+};
+
+// Render passes and framebuffers, hashed by what they're built from so nobody creates one
+// that already exists. Render passes live as long as the device, every panel drawing to the
+// same format shares one, and pipelines built against it stay compatible across resizes.
+// Framebuffers belong to a swapchain generation and go when it's released, since they
+// hold that swapchain's image views. Thread-safe.
+class VkRenderPassCache
+{
+public:
+    struct Stats
+    {
+        uint64_t mRenderPassesCreated = 0;
+        uint64_t mRenderPassHits = 0;
+        uint64_t mFramebuffersCreated = 0;
+        uint64_t mFramebufferHits = 0;
+    };
+
+    void Initialize(vkb::Device aDevice);
+
+    // VK_NULL_HANDLE if the driver refused.
+    VkRenderPass GetRenderPass(const VkRenderPassKey& aKey);
+    VkFramebuffer GetFramebuffer(const VkFramebufferKey& aKey, uint64_t aGeneration);
+
+    // A new id for a swapchain, to create its framebuffers under.
+    uint64_t NewGeneration();
+
+    // Destroys every framebuffer created under aGeneration. Nothing using them may still be
+    // in flight.
+    void ReleaseGeneration(uint64_t aGeneration);
+
+    // Destroys every render pass and framebuffer, for when the device goes.
+    void Destroy();
+
+    Stats GetStats();
+
+private:
+    struct RenderPassKeyHash
+    {
+        size_t operator()(const VkRenderPassKey& aKey) const;
+    };
+
+    struct FramebufferKeyHash
+    {
+        size_t operator()(const VkFramebufferKey& aKey) const;
+    };
+
+    struct CachedFramebuffer
+    {
+        VkFramebuffer mFramebuffer = VK_NULL_HANDLE;
+        uint64_t mGeneration = 0;
+    };
+
+    vkb::Device mDevice;
+
+    std::mutex mMutex;
+    std::unordered_map<VkRenderPassKey, VkRenderPass, RenderPassKeyHash> mRenderPasses;
+    std::unordered_map<VkFramebufferKey, CachedFramebuffer, FramebufferKeyHash> mFramebuffers;
+    uint64_t mNextGeneration = 1;
+    Stats mStats;
+};
@@ -2,12 +2,19 @@
 #define VMA_STATS_STRING_ENABLED 0
 #include "vk_mem_alloc.h"
 
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <string>
+
 #include "SDL3/SDL_vulkan.h"
 
 #include "Renderers/Renderer.hpp"
 
 #include "Renderers/VkRenderer.hpp"
 
+#include "Utilities/ThreadPool.hpp"
+
 std::unique_ptr<Renderer> CreateVkRenderer(SDL_Window* aWindow)
 {
     return std::unique_ptr<Renderer>(new VkRenderer(aWindow));
@@ -68,7 +75,7 @@ void VulkanQueue::Initialize(vkb::Device aDevice, vkb::QueueType aType, size_t a
     {
         printf("Failed to create Vulkan Queue. Error: %s\n", queue_ret.error().message().c_str());
 
-        if (vkb::QueueType::transfer == mType)
+        if ((vkb::QueueType::transfer == mType) || (vkb::QueueType::compute == mType))
         {
             // Okay try one more time for a graphics queue. We can use that as a fallback.
             mType = vkb::QueueType::graphics;
@@ -148,6 +155,37 @@ void VulkanQueue::Initialize(vkb::Device aDevice, vkb::QueueType aType, size_t a
     }
 }
 
+void VulkanQueue::Destroy()
+{
+    // Nothing past the pool gets created without it.
+    if (VK_NULL_HANDLE == mPool)
+    {
+        return;
+    }
+
+    for (VkFence fence : mFences)
+    {
+        vkDestroyFence(mDevice.device, fence, mDevice.allocation_callbacks);
+    }
+
+    for (VkSemaphore semaphore : mAvailableSemaphores)
+    {
+        vkDestroySemaphore(mDevice.device, semaphore, mDevice.allocation_callbacks);
+    }
+
+    for (VkSemaphore semaphore : mFinishedSemaphore)
+    {
+        vkDestroySemaphore(mDevice.device, semaphore, mDevice.allocation_callbacks);
+    }
+
+    vkDestroyCommandPool(mDevice.device, mPool, mDevice.allocation_callbacks);
+    mPool = VK_NULL_HANDLE;
+    mCommandBuffers.clear();
+    mFences.clear();
+    mAvailableSemaphores.clear();
+    mFinishedSemaphore.clear();
+    mUsed.clear();
+}
 
 uint32_t VulkanQueue::GetQueueFamily()
 {
@@ -197,6 +235,40 @@ VulkanCommandBuffer VulkanQueue::GetCurrentCommandList()
     return VulkanCommandBuffer{ mCommandBuffers[mCurrentBuffer], mFences[mCurrentBuffer], mAvailableSemaphores[mCurrentBuffer], mFinishedSemaphore[mCurrentBuffer] };
 }
 
+VulkanCommandBuffer VulkanQueue::GetCommandList(size_t aIndex)
+{
+    if (mUsed[aIndex])
+    {
+        vkResetCommandBuffer(mCommandBuffers[aIndex], VK_COMMAND_BUFFER_RESET_RELEASE_RESOURCES_BIT);
+    }
+    else
+    {
+        mUsed[aIndex] = true;
+    }
+
+    return VulkanCommandBuffer{ mCommandBuffers[aIndex], mFences[aIndex], mAvailableSemaphores[aIndex], mFinishedSemaphore[aIndex] };
+}
+
+void VulkanQueue::RecreateAvailableSemaphore(VkSemaphore aSemaphore)
+{
+    auto it = std::find(mAvailableSemaphores.begin(), mAvailableSemaphores.end(), aSemaphore);
+    if (it == mAvailableSemaphores.end())
+    {
+        return;
+    }
+
+    vkDestroySemaphore(mDevice.device, *it, mDevice.allocation_callbacks);
+    *it = VK_NULL_HANDLE;
+
+    VkSemaphoreCreateInfo semaphore_info = {};
+    semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+    if (vkCreateSemaphore(mDevice.device, &semaphore_info, nullptr, &*it) != VK_SUCCESS)
+    {
+        printf("Failed to create synchronization objects\n");
+    }
+}
+
 void VulkanQueue::Submit(VulkanCommandBuffer aCommandList)
 {
     VkSubmitInfo end_info = {};
@@ -207,160 +279,906 @@ void VulkanQueue::Submit(VulkanCommandBuffer aCommandList)
     check_vk_result(err);
 }
 
-VkBool32 
-#ifdef SYSTEM_ANDROID
-__attribute__((pcs("aapcs-vfp")))
-#endif
-DebugUtilsCallback(
-    VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity,
-    VkDebugUtilsMessageTypeFlagsEXT messageType,
-    const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData,
-    void* /*pUserData*/)
+//////////////////////////////////////////////////////////////////////////////////////////////
+// VulkanSecondaryCommandPools:
+void VulkanSecondaryCommandPools::Initialize(vkb::Device aDevice, uint32_t aQueueFamily, size_t aThreadCount, size_t aFrameCount)
 {
-    auto severity = vkb::to_string_message_severity(messageSeverity);
-    auto type = vkb::to_string_message_type(messageType);
+    mDevice = aDevice;
+    mThreadCount = aThreadCount;
+    mPools.resize(aThreadCount * aFrameCount);
+
+    // Transient since everything recorded from them lives for one frame, and without the
+    // reset flag so the whole pool is reset at once rather than buffer by buffer.
+    VkCommandPoolCreateInfo pool_info = {};
+    pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    pool_info.queueFamilyIndex = aQueueFamily;
+    pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+    for (PerThread& pools : mPools)
+    {
+        VkResult err = vkCreateCommandPool(mDevice.device, &pool_info, mDevice.allocation_callbacks, &pools.mPool);
+        check_vk_result(err);
+    }
+}
 
-    if ((VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT & messageSeverity)
-        || (VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT & messageSeverity))
+void VulkanSecondaryCommandPools::Destroy()
+{
+    for (PerThread& pools : mPools)
     {
-        printf("[%s: %s] %s\n", severity, type, pCallbackData->pMessage);
+        vkDestroyCommandPool(mDevice.device, pools.mPool, mDevice.allocation_callbacks);
     }
 
-    return VK_FALSE;
+    mPools.clear();
 }
 
-VkRenderPass VkRenderer::CreateRenderPass()
+void VulkanSecondaryCommandPools::BeginFrame(size_t aFrame)
+{
+    mFrame = aFrame;
+
+    for (size_t i = 0; i < mThreadCount; ++i)
+    {
+        PerThread& pools = mPools[(mFrame * mThreadCount) + i];
+
+        if (0 != pools.mUsed)
+        {
+            vkResetCommandPool(mDevice.device, pools.mPool, 0);
+            pools.mUsed = 0;
+        }
+    }
+}
+
+VkCommandBuffer VulkanSecondaryCommandPools::Get(size_t aThreadIndex)
+{
+    PerThread& pools = mPools[(mFrame * mThreadCount) + aThreadIndex];
+
+    if (pools.mUsed == pools.mBuffers.size())
+    {
+        VkCommandBufferAllocateInfo allocInfo = {};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = pools.mPool;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        allocInfo.commandBufferCount = 1;
+
+        VkCommandBuffer buffer = VK_NULL_HANDLE;
+        VkResult err = vkAllocateCommandBuffers(mDevice.device, &allocInfo, &buffer);
+        check_vk_result(err);
+        pools.mBuffers.push_back(buffer);
+    }
+
+    return pools.mBuffers[pools.mUsed++];
+}
+
+static VkPresentModeKHR ToVkPresentMode(PresentMode aMode)
 {
-    VkRenderPass renderPass;
-    VkAttachmentDescription color_attachment = {};
-    color_attachment.format = mSwapchain.image_format;
-    color_attachment.samples = VK_SAMPLE_COUNT_1_BIT;
-    color_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    color_attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-    color_attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-    color_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    color_attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    color_attachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    switch (aMode)
+    {
+        case PresentMode::Mailbox: return VK_PRESENT_MODE_MAILBOX_KHR;
+        case PresentMode::Immediate: return VK_PRESENT_MODE_IMMEDIATE_KHR;
+        case PresentMode::Adaptive: return VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+        default: return VK_PRESENT_MODE_FIFO_KHR;
+    }
+}
+
+static PresentMode FromVkPresentMode(VkPresentModeKHR aMode)
+{
+    switch (aMode)
+    {
+        case VK_PRESENT_MODE_MAILBOX_KHR: return PresentMode::Mailbox;
+        case VK_PRESENT_MODE_IMMEDIATE_KHR: return PresentMode::Immediate;
+        case VK_PRESENT_MODE_FIFO_RELAXED_KHR: return PresentMode::Adaptive;
+        default: return PresentMode::Fifo;
+    }
+}
+
+void VkRenderer::ConfigureSwapchain(vkb::SwapchainBuilder& aBuilder)
+{
+    aBuilder.set_desired_format(VkSurfaceFormatKHR{ VK_FORMAT_B8G8R8A8_UNORM, VK_COLORSPACE_SRGB_NONLINEAR_KHR });
 
-    VkAttachmentReference color_attachment_ref = {};
-    color_attachment_ref.attachment = 0;
-    color_attachment_ref.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    // FIFO is the only mode the spec guarantees, so it's always there to fall back on.
+    aBuilder.set_desired_present_mode(ToVkPresentMode(mSwapchainPresentMode));
+    aBuilder.add_fallback_present_mode(VK_PRESENT_MODE_FIFO_KHR);
+}
 
-    VkSubpassDescription subpass = {};
-    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-    subpass.colorAttachmentCount = 1;
-    subpass.pColorAttachments = &color_attachment_ref;
+PresentMode VkRenderer::ApplyPresentMode(PresentMode aMode)
+{
+    // Initialize failed, there's no surface to ask or swapchain to rebuild.
+    if (nullptr == mContext)
+    {
+        return mSwapchainPresentMode;
+    }
 
-    VkSubpassDependency dependency = {};
-    dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-    dependency.dstSubpass = 0;
-    dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    dependency.srcAccessMask = 0;
-    dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;// | VK_ACCESS_COLOR_ATTACHMENT_READ_BIT;
+    uint32_t count = 0;
+    vkGetPhysicalDeviceSurfacePresentModesKHR(mContext->GetPhysicalDevice(), mSurface, &count, nullptr);
+    std::vector<VkPresentModeKHR> supported(count);
+    vkGetPhysicalDeviceSurfacePresentModesKHR(mContext->GetPhysicalDevice(), mSurface, &count, supported.data());
 
-    VkRenderPassCreateInfo render_pass_info = {};
-    render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-    render_pass_info.attachmentCount = 1;
-    render_pass_info.pAttachments = &color_attachment;
-    render_pass_info.subpassCount = 1;
-    render_pass_info.pSubpasses = &subpass;
-    render_pass_info.dependencyCount = 1;
-    render_pass_info.pDependencies = &dependency;
+    VkPresentModeKHR desired = ToVkPresentMode(aMode);
+    if (std::find(supported.begin(), supported.end(), desired) == supported.end())
+    {
+        printf("Present mode %s isn't supported by this surface, using Fifo\n", PresentModeName(aMode));
+        aMode = PresentMode::Fifo;
+    }
 
-    if (vkCreateRenderPass(mDevice, &render_pass_info, nullptr, &renderPass) != VK_SUCCESS)
+    if (aMode == FromVkPresentMode(mSwapchain.present_mode))
     {
-        printf("failed to create render pass\n");
-        return VK_NULL_HANDLE;;
+        return aMode;
     }
 
-    return renderPass;
+    // Only the swapchain has to be rebuilt, everything else about the renderer stays.
+    mSwapchainPresentMode = aMode;
+    RecreateSwapchain();
+
+    return FromVkPresentMode(mSwapchain.present_mode);
 }
 
-VkRenderer::VkRenderer(SDL_Window* aWindow)
-    : Renderer{ aWindow }
+VkRenderPass VkRenderer::CreateRenderPass()
 {
-    ///////////////////////////////////////
-    // Create Instance
-    vkb::InstanceBuilder instance_builder;
-    instance_builder
-        .set_app_name("Application")
-        .set_engine_name("SOIS")
-        .require_api_version(1, 0, 0)
-        .set_debug_callback(&DebugUtilsCallback);
-
-    auto system_info_ret = vkb::SystemInfo::get_system_info();
-    if (!system_info_ret)
-    {
-        printf("%s\n", system_info_ret.error().message().c_str());
+    // Cleared every frame and handed straight to the presentation engine. Every panel with
+    // the same swapchain format gets the same render pass.
+    VkRenderPassKey key;
+    key.mColorCount = 1;
+    key.mColor[0].mFormat = mSwapchain.image_format;
+    key.mColor[0].mLoadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    key.mColor[0].mStoreOp = VK_ATTACHMENT_STORE_OP_STORE;
+    key.mColor[0].mInitialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    key.mColor[0].mFinalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+    return mContext->GetRenderPassCache().GetRenderPass(key);
+}
+
+void VkRenderer::CreateFramebuffers()
+{
+    swapchain_images = mSwapchain.get_images().value();
+    swapchain_image_views = mSwapchain.get_image_views().value();
+
+    // The graph makes its framebuffers as it meets each swapchain image.
+    BuildGraph();
+}
+
+void VkRenderer::ReleaseFramebuffers()
+{
+    if (swapchain_image_views.empty())
+    {
         return;
     }
 
-    auto system_info = system_info_ret.value();
-    if (system_info.validation_layers_available) {
-        instance_builder.enable_validation_layers();
+    // The graph's framebuffers and transients, and the views, may still be in use by our
+    // last frames.
+    mContext->WaitForSerial(*std::max_element(mFrameSerials.begin(), mFrameSerials.end()));
+
+    if (!mPostSets.empty())
+    {
+        vkFreeDescriptorSets(mDevice, mDescriptorPool, (uint32_t)mPostSets.size(), mPostSets.data());
+        mPostSets.clear();
+    }
+
+    mGraph.Reset();
+    mSwapchain.destroy_image_views(swapchain_image_views);
+    swapchain_image_views.clear();
+    swapchain_images.clear();
+}
+
+void VkRenderer::BuildGraph()
+{
+    VkExtent2D extent = mSwapchain.extent;
+    VkFormat format = mSwapchain.image_format;
+
+    // Whichever pass draws to the swapchain image first clears it, so what was there
+    // doesn't matter.
+    mGraphSwapchain = mGraph.ImportImage("Swapchain", format, extent, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+
+    VkRenderGraph::Resource target = mGraphSwapchain;
+    if (0 != mPostPassCount)
+    {
+        target = mGraph.CreateImage("Scene", format, extent);
     }
 
-    Uint32 sdl_extensions_count;
-    const char* const* sdl_extensions = SDL_Vulkan_GetInstanceExtensions(&sdl_extensions_count);
-    if (nullptr == sdl_extensions)
+    // Enough draws to be worth splitting up are recorded into secondary buffers across the
+    // pool, and the primary just executes them.
+    VkSubpassContents contents = (mDrawCount > cDrawsPerSecondary) ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE;
+    VkRenderGraph::Pass scene = mGraph.AddPass("Scene", contents, [this](const VkGraphPassContext& aPass)
     {
-        printf("Failed to get required Vulkan Instance Extensions from SDL\n");
-        return;
+        RecordScene(aPass);
+    });
+
+    mGraph.Write(scene, target, &mClearValue);
+
+    // Sets can only be written once the graph has made the images they sample.
+    std::vector<VkRenderGraph::Resource> sources;
+    for (uint32_t i = 0; i < mPostPassCount; ++i)
+    {
+        VkRenderGraph::Resource source = target;
+        target = ((i + 1) == mPostPassCount) ? mGraphSwapchain : mGraph.CreateImage("Post", format, extent);
+
+        VkRenderGraph::Pass post = mGraph.AddPass("Post", VK_SUBPASS_CONTENTS_INLINE, [this, i](const VkGraphPassContext& aPass)
+        {
+            RecordPost(aPass, mPostSets[i]);
+        });
+
+        mGraph.Read(post, source);
+        mGraph.Write(post, target, &mClearValue);
+        sources.push_back(source);
     }
 
-    const char* const* extensions_end = sdl_extensions + sdl_extensions_count;
-    for (sdl_extensions; sdl_extensions < extensions_end; ++sdl_extensions)
+    if (!mGraph.Compile())
     {
-        instance_builder.enable_extension(*sdl_extensions);
+        printf("Failed to compile the render graph.\n");
+        return;
     }
 
-    auto instance_builder_return = instance_builder.build();
+    const VkRenderGraph::Stats& stats = mGraph.GetStats();
+    mStats.mGraphPasses = stats.mPasses;
+    mStats.mGraphPassesCulled = stats.mPassesCulled;
+    mStats.mGraphBarriers = stats.mBarriers;
+    mStats.mGraphAliasingSavedBytes = stats.mTransientBytes - stats.mTransientAllocatedBytes;
 
-    if (!instance_builder_return) {
-        printf("Failed to create Vulkan instance. Error: %s\n", instance_builder_return.error().message().c_str());
+    if (sources.empty())
+    {
         return;
     }
-    mInstance = instance_builder_return.value();
 
+    std::vector<VkDescriptorSetLayout> layouts(sources.size(), mDescriptorSetLayout);
+    mPostSets.resize(sources.size());
+
+    VkDescriptorSetAllocateInfo set_info = {};
+    set_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    set_info.descriptorPool = mDescriptorPool;
+    set_info.descriptorSetCount = (uint32_t)layouts.size();
+    set_info.pSetLayouts = layouts.data();
+    VkResult err = vkAllocateDescriptorSets(mDevice, &set_info, mPostSets.data());
+    check_vk_result(err);
+
+    for (size_t i = 0; i < sources.size(); ++i)
+    {
+        VkDescriptorImageInfo descriptor_image = {};
+        descriptor_image.imageView = mGraph.GetView(sources[i]);
+        descriptor_image.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+        VkWriteDescriptorSet write = {};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = mPostSets[i];
+        write.descriptorCount = 1;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        write.pImageInfo = &descriptor_image;
+        vkUpdateDescriptorSets(mDevice, 1, &write, 0, nullptr);
+    }
+}
+
+VkShaderModule VkRenderer::CreateShaderModule(std::span<const uint32_t> aSpirv)
+{
+    VkShaderModuleCreateInfo info = {};
+    info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    info.codeSize = aSpirv.size_bytes();
+    info.pCode = aSpirv.data();
+
+    VkShaderModule module = VK_NULL_HANDLE;
+    VkResult err = vkCreateShaderModule(mDevice, &info, mDevice.allocation_callbacks, &module);
+    check_vk_result(err);
+    return module;
+}
+
+VkPipeline VkRenderer::CreateGraphicsPipeline(std::span<const uint32_t> aVertexSpirv, std::span<const uint32_t> aFragmentSpirv,
+    const VkPipelineVertexInputStateCreateInfo& aVertexInput, VkPrimitiveTopology aTopology, VkPipelineLayout aLayout, bool aBlend)
+{
+    VkShaderModule vertexModule = CreateShaderModule(aVertexSpirv);
+    VkShaderModule fragmentModule = CreateShaderModule(aFragmentSpirv);
+
+    VkPipelineShaderStageCreateInfo stages[2] = {};
+    stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+    stages[0].module = vertexModule;
+    stages[0].pName = "main";
+    stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    stages[1].module = fragmentModule;
+    stages[1].pName = "main";
+
+    VkPipelineInputAssemblyStateCreateInfo input_assembly = {};
+    input_assembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    input_assembly.topology = aTopology;
+
+    // Viewport and scissor are dynamic so resizes don't need a new pipeline.
+    VkPipelineViewportStateCreateInfo viewport_state = {};
+    viewport_state.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewport_state.viewportCount = 1;
+    viewport_state.scissorCount = 1;
+
+    VkPipelineRasterizationStateCreateInfo rasterization = {};
+    rasterization.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterization.polygonMode = VK_POLYGON_MODE_FILL;
+    rasterization.cullMode = VK_CULL_MODE_NONE;
+    rasterization.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+    rasterization.lineWidth = 1.0f;
+
+    VkPipelineMultisampleStateCreateInfo multisample = {};
+    multisample.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisample.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+    VkPipelineColorBlendAttachmentState blend_attachment = {};
+    blend_attachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+
+    // Blending is premultiplied.
+    if (aBlend)
+    {
+        blend_attachment.blendEnable = VK_TRUE;
+        blend_attachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
+        blend_attachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+        blend_attachment.colorBlendOp = VK_BLEND_OP_ADD;
+        blend_attachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+        blend_attachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+        blend_attachment.alphaBlendOp = VK_BLEND_OP_ADD;
+    }
+
+    VkPipelineColorBlendStateCreateInfo blend = {};
+    blend.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    blend.attachmentCount = 1;
+    blend.pAttachments = &blend_attachment;
+
+    VkDynamicState dynamic_states[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+    VkPipelineDynamicStateCreateInfo dynamic_state = {};
+    dynamic_state.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamic_state.dynamicStateCount = (uint32_t)std::size(dynamic_states);
+    dynamic_state.pDynamicStates = dynamic_states;
+
+    VkGraphicsPipelineCreateInfo info = {};
+    info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    info.stageCount = (uint32_t)std::size(stages);
+    info.pStages = stages;
+    info.pVertexInputState = &aVertexInput;
+    info.pInputAssemblyState = &input_assembly;
+    info.pViewportState = &viewport_state;
+    info.pRasterizationState = &rasterization;
+    info.pMultisampleState = &multisample;
+    info.pColorBlendState = &blend;
+    info.pDynamicState = &dynamic_state;
+    info.layout = aLayout;
+    info.renderPass = mRenderPass;
+    info.subpass = 0;
+
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    VkResult err = vkCreateGraphicsPipelines(mDevice, mContext->GetPipelineCache(), 1, &info, mDevice.allocation_callbacks, &pipeline);
+    check_vk_result(err);
+
+    // Modules are only needed while the pipeline is being created.
+    vkDestroyShaderModule(mDevice, vertexModule, mDevice.allocation_callbacks);
+    vkDestroyShaderModule(mDevice, fragmentModule, mDevice.allocation_callbacks);
+
+    return pipeline;
+}
+
+VkPipeline VkRenderer::CreateTrianglePipeline(std::span<const uint32_t> aVertexSpirv, std::span<const uint32_t> aFragmentSpirv)
+{
+    VkVertexInputBindingDescription binding = {};
+    binding.binding = 0;
+    binding.stride = cVertexStride;
+    binding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+    VkVertexInputAttributeDescription attribute = {};
+    attribute.location = 0;
+    attribute.binding = 0;
+    attribute.format = VK_FORMAT_R32G32B32_SFLOAT;
+    attribute.offset = cVertexOffset;
+
+    VkPipelineVertexInputStateCreateInfo vertex_input = {};
+    vertex_input.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertex_input.vertexBindingDescriptionCount = 1;
+    vertex_input.pVertexBindingDescriptions = &binding;
+    vertex_input.vertexAttributeDescriptionCount = 1;
+    vertex_input.pVertexAttributeDescriptions = &attribute;
+
+    return CreateGraphicsPipeline(aVertexSpirv, aFragmentSpirv, vertex_input, VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, mPipelineLayout, false);
+}
+
+VkPipeline VkRenderer::CreateImagePipeline()
+{
+    // The quad's corners come from the vertex index, there's nothing to fetch.
+    VkPipelineVertexInputStateCreateInfo vertex_input = {};
+    vertex_input.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+
+    return CreateGraphicsPipeline(GetSpirv<ShaderId::ImageVertex>(), GetSpirv<ShaderId::ImageFragment>(),
+        vertex_input, VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP, mImageLayout, false);
+}
+
+VkPipeline VkRenderer::CreateTextPipeline()
+{
+    // A GlyphQuad per instance, the strip's corners come from the vertex index.
+    VkVertexInputBindingDescription binding = {};
+    binding.binding = 0;
+    binding.stride = sizeof(GlyphQuad);
+    binding.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
+    VkVertexInputAttributeDescription attributes[3] = {};
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        attributes[i].location = i;
+        attributes[i].binding = 0;
+        attributes[i].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+    }
+    attributes[0].offset = offsetof(GlyphQuad, mRect);
+    attributes[1].offset = offsetof(GlyphQuad, mUv);
+    attributes[2].offset = offsetof(GlyphQuad, mColor);
+
+    VkPipelineVertexInputStateCreateInfo vertex_input = {};
+    vertex_input.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertex_input.vertexBindingDescriptionCount = 1;
+    vertex_input.pVertexBindingDescriptions = &binding;
+    vertex_input.vertexAttributeDescriptionCount = (uint32_t)std::size(attributes);
+    vertex_input.pVertexAttributeDescriptions = attributes;
+
+    // The image layout's push constants go unused, its set is what the atlas binds through.
+    return CreateGraphicsPipeline(GetSpirv<ShaderId::TextVertex>(), GetSpirv<ShaderId::TextFragment>(),
+        vertex_input, VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP, mImageLayout, true);
+}
+
+void VkRenderer::CreateVertexBuffer()
+{
+    VkBufferCreateInfo buffer_info = {};
+    buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buffer_info.size = sizeof(float) * TriangleVerts.size();
+    buffer_info.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    // The animation reads it from the compute queue, which may be another family.
+    uint32_t families[] = { mContext->GetGraphicsQueueFamily(), mContext->GetComputeQueueFamily() };
+    if (mAnimate)
+    {
+        buffer_info.usage |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+
+        if (mContext->HasAsyncComputeQueue())
+        {
+            buffer_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+            buffer_info.queueFamilyIndexCount = 2;
+            buffer_info.pQueueFamilyIndices = families;
+        }
+    }
+
+    // It's three vertices, host visible memory is fine and saves us a staging copy.
+    VmaAllocationCreateInfo allocation_info = {};
+    allocation_info.usage = VMA_MEMORY_USAGE_AUTO;
+    allocation_info.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+    VmaAllocationInfo allocated = {};
+    VkResult err = vmaCreateBuffer(mAllocator, &buffer_info, &allocation_info, &mVertexBuffer, &mVertexAllocation, &allocated);
+    check_vk_result(err);
+
+    memcpy(allocated.pMappedData, TriangleVerts.data(), sizeof(float) * TriangleVerts.size());
+    vmaFlushAllocation(mAllocator, mVertexAllocation, 0, VK_WHOLE_SIZE);
+}
+
+void VkRenderer::CreateAnimationCompute()
+{
     ///////////////////////////////////////
-    // Create Surface
+    // Descriptors: the source vertices and this slot's animated copy.
     {
-        if (!SDL_Vulkan_CreateSurface(aWindow, mInstance.instance, nullptr, &mSurface)) {
-            printf("Failed to create Vulkan Surface.\n");
-            return;
+        VkDescriptorSetLayoutBinding bindings[2] = {};
+        for (uint32_t i = 0; i < 2; ++i)
+        {
+            bindings[i].binding = i;
+            bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            bindings[i].descriptorCount = 1;
+            bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
         }
+
+        VkDescriptorSetLayoutCreateInfo info = {};
+        info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        info.bindingCount = 2;
+        info.pBindings = bindings;
+        VkResult err = vkCreateDescriptorSetLayout(mDevice.device, &info, mDevice.allocation_callbacks, &mAnimationSetLayout);
+        check_vk_result(err);
+    }
+
+    ///////////////////////////////////////
+    // Pipeline, small enough that it's built right here.
+    {
+        VkPushConstantRange push_constant = {};
+        push_constant.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        push_constant.size = sizeof(float) + sizeof(uint32_t);
+
+        VkPipelineLayoutCreateInfo layout_info = {};
+        layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        layout_info.setLayoutCount = 1;
+        layout_info.pSetLayouts = &mAnimationSetLayout;
+        layout_info.pushConstantRangeCount = 1;
+        layout_info.pPushConstantRanges = &push_constant;
+        VkResult err = vkCreatePipelineLayout(mDevice, &layout_info, mDevice.allocation_callbacks, &mAnimationLayout);
+        check_vk_result(err);
+
+        VkShaderModule module = CreateShaderModule(GetSpirv<ShaderId::TriangleAnimateCompute>());
+
+        VkComputePipelineCreateInfo info = {};
+        info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        info.stage.module = module;
+        info.stage.pName = "main";
+        info.layout = mAnimationLayout;
+        err = vkCreateComputePipelines(mDevice, mContext->GetPipelineCache(), 1, &info, mDevice.allocation_callbacks, &mAnimationPipeline);
+        check_vk_result(err);
+
+        vkDestroyShaderModule(mDevice, module, mDevice.allocation_callbacks);
     }
 
     ///////////////////////////////////////
-    // Select Physical Device
-    vkb::PhysicalDeviceSelector phys_device_selector(mInstance);
-    phys_device_selector.set_surface(mSurface);
+    // A vertex buffer and descriptor set per frame slot, so the compute queue can be
+    // writing the next frame's while the graphics queue reads the last one's.
+    uint32_t families[] = { mContext->GetGraphicsQueueFamily(), mContext->GetComputeQueueFamily() };
+
+    VkBufferCreateInfo buffer_info = {};
+    buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buffer_info.size = sizeof(float) * TriangleVerts.size();
+    buffer_info.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (mContext->HasAsyncComputeQueue())
+    {
+        buffer_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        buffer_info.queueFamilyIndexCount = 2;
+        buffer_info.pQueueFamilyIndices = families;
+    }
+
+    VmaAllocationCreateInfo allocation_info = {};
+    allocation_info.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
+
+    std::array<VkDescriptorSetLayout, cMinImageCount> layouts;
+    layouts.fill(mAnimationSetLayout);
+
+    VkDescriptorSetAllocateInfo set_info = {};
+    set_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    set_info.descriptorPool = mDescriptorPool;
+    set_info.descriptorSetCount = cMinImageCount;
+    set_info.pSetLayouts = layouts.data();
+    VkResult err = vkAllocateDescriptorSets(mDevice, &set_info, mAnimationSets.data());
+    check_vk_result(err);
+
+    for (size_t i = 0; i < cMinImageCount; ++i)
+    {
+        err = vmaCreateBuffer(mAllocator, &buffer_info, &allocation_info, &mAnimatedVertexBuffers[i], &mAnimatedVertexAllocations[i], nullptr);
+        check_vk_result(err);
+
+        VkDescriptorBufferInfo buffers[2] = {};
+        buffers[0].buffer = mVertexBuffer;
+        buffers[0].range = VK_WHOLE_SIZE;
+        buffers[1].buffer = mAnimatedVertexBuffers[i];
+        buffers[1].range = VK_WHOLE_SIZE;
+
+        VkWriteDescriptorSet write = {};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = mAnimationSets[i];
+        write.dstBinding = 0;
+        write.descriptorCount = 2;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        write.pBufferInfo = buffers;
+        vkUpdateDescriptorSets(mDevice, 1, &write, 0, nullptr);
+    }
+
+    mAnimationStartNs = SDL_GetTicksNS();
+}
 
+uint64_t VkRenderer::DispatchAnimation(size_t aSlot)
+{
+    static constexpr uint32_t cGroupSize = 64;
+
+    struct
     {
-        auto physical_device_selector_return = phys_device_selector.select();
+        float mAngle;
+        uint32_t mVertexCount;
+    } animation;
+
+    // A turn every four seconds.
+    double seconds = (double)(SDL_GetTicksNS() - mAnimationStartNs) / (double)SDL_NS_PER_SECOND;
+    animation.mAngle = (float)(seconds * 3.14159265358979 / 2.0);
+    animation.mVertexCount = cVertexCount;
+
+    // The graphics submit of this slot's last frame waited on its last dispatch, and we've
+    // waited on that, so the command buffer and the slot's vertices are free.
+    VulkanCommandBuffer commandBuffer = mComputeQueue.GetCommandList(aSlot);
+    commandBuffer.Begin();
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, mAnimationPipeline);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, mAnimationLayout, 0, 1, &mAnimationSets[aSlot], 0, nullptr);
+    vkCmdPushConstants(commandBuffer, mAnimationLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(animation), &animation);
+    vkCmdDispatch(commandBuffer, (cVertexCount + cGroupSize - 1) / cGroupSize, 1, 1);
+    commandBuffer.End();
+
+    return mContext->SubmitCompute(commandBuffer);
+}
 
-        if (!physical_device_selector_return) 
+void VkRenderer::PrepareImages(size_t aSlot, VkCommandBuffer aCommandBuffer)
+{
+    // Uploads go ahead of the render pass, and anything evicted here is freed once this
+    // slot comes around again.
+    mTextureUploader.BeginFrame(aSlot, aCommandBuffer);
+    mTextures.Update();
+
+    mImageDraws = mFrameArena.AllocateArray<ImageDraw>(mImages.size());
+    size_t drawCount = 0;
+
+    for (const ImageQuad& image : mImages)
+    {
+        uint64_t texture = mTextures.Acquire(image.mPath);
+        if (0 == texture)
         {
-            // We return out because there's really nothing we can do at this point, there's not a 
-            // single suitable GPU on this system.
-            printf("Failed to select Vulkan Physical Device. Error: %s\n", physical_device_selector_return.error().message().c_str());
-            return;
+            continue;
         }
-        else
+
+        // Clip space y points down in Vulkan, same as the normalized rect.
+        ImageDraw& draw = mImageDraws[drawCount++];
+        draw.mSet = VkTextureUploader::GetDescriptorSet(texture);
+        draw.mRect[0] = image.mRect.x * 2.0f - 1.0f;
+        draw.mRect[1] = image.mRect.y * 2.0f - 1.0f;
+        draw.mRect[2] = (image.mRect.x + image.mRect.w) * 2.0f - 1.0f;
+        draw.mRect[3] = (image.mRect.y + image.mRect.h) * 2.0f - 1.0f;
+        draw.mMinLod = VkTextureUploader::GetMinLod(texture);
+    }
+
+    mImageDraws = mImageDraws.first(drawCount);
+
+    if (mTextures.Busy())
+    {
+        RequestAnimationFrame();
+    }
+
+    mTextures.ReportStats(mStats);
+}
+
+void VkRenderer::RecordImages(VkCommandBuffer aCommandBuffer)
+{
+    VkPipeline pipeline = mImagePipeline.load(std::memory_order_acquire);
+    if ((VK_NULL_HANDLE == pipeline) || mImageDraws.empty())
+    {
+        return;
+    }
+
+    VkViewport viewport = {};
+    viewport.width = (float)mSwapchain.extent.width;
+    viewport.height = (float)mSwapchain.extent.height;
+    viewport.maxDepth = 1.0f;
+    vkCmdSetViewport(aCommandBuffer, 0, 1, &viewport);
+
+    VkRect2D scissor = {};
+    scissor.extent = mSwapchain.extent;
+    vkCmdSetScissor(aCommandBuffer, 0, 1, &scissor);
+
+    vkCmdBindPipeline(aCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+
+    for (const ImageDraw& draw : mImageDraws)
+    {
+        vkCmdBindDescriptorSets(aCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mImageLayout, 0, 1, &draw.mSet, 0, nullptr);
+        vkCmdPushConstants(aCommandBuffer, mImageLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(float) * 5, draw.mRect);
+        vkCmdDraw(aCommandBuffer, 4, 1, 0, 0);
+    }
+}
+
+void VkRenderer::RecordDraws(VkCommandBuffer aCommandBuffer, VkPipeline aPipeline, uint32_t aDrawCount)
+{
+    // Viewport and scissor are dynamic, and secondary buffers don't inherit dynamic state.
+    VkViewport viewport = {};
+    viewport.width = (float)mSwapchain.extent.width;
+    viewport.height = (float)mSwapchain.extent.height;
+    viewport.maxDepth = 1.0f;
+    vkCmdSetViewport(aCommandBuffer, 0, 1, &viewport);
+
+    VkRect2D scissor = {};
+    scissor.extent = mSwapchain.extent;
+    vkCmdSetScissor(aCommandBuffer, 0, 1, &scissor);
+
+    if (VK_NULL_HANDLE == aPipeline)
+    {
+        return;
+    }
+
+    float triangle_color[4] = {
+        mTriangleColor.r / 255.f,
+        mTriangleColor.g / 255.f,
+        mTriangleColor.b / 255.f,
+        mTriangleColor.a / 255.f,
+    };
+
+    VkDeviceSize vertex_offset = 0;
+    vkCmdBindPipeline(aCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, aPipeline);
+    vkCmdPushConstants(aCommandBuffer, mPipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(triangle_color), triangle_color);
+    vkCmdBindVertexBuffers(aCommandBuffer, 0, 1, &mFrameVertexBuffer, &vertex_offset);
+
+    for (uint32_t i = 0; i < aDrawCount; ++i)
+    {
+        vkCmdDraw(aCommandBuffer, cVertexCount, 1, 0, 0);
+    }
+}
+
+void VkRenderer::RecordSecondaryDraws(const VkGraphPassContext& aPass, VkPipeline aPipeline, size_t aFrame)
+{
+    uint32_t chunkCount = (mDrawCount + cDrawsPerSecondary - 1) / cDrawsPerSecondary;
+    std::span<VkCommandBuffer> secondaries = mFrameArena.AllocateArray<VkCommandBuffer>(chunkCount);
+
+    mSecondaryPools.BeginFrame(aFrame);
+
+    VkCommandBufferInheritanceInfo inheritance = {};
+    inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritance.renderPass = aPass.mRenderPass;
+    inheritance.subpass = 0;
+    inheritance.framebuffer = aPass.mFramebuffer;
+
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    beginInfo.pInheritanceInfo = &inheritance;
+
+    // Each chunk records into a buffer from the pools of whichever thread picked it up, the
+    // lambda only captures this so ParallelFor's std::function doesn't allocate.
+    struct Chunks
+    {
+        VkRenderer* mRenderer;
+        VkPipeline mPipeline;
+        uint32_t mChunkCount;
+        std::span<VkCommandBuffer> mBuffers;
+        const VkCommandBufferBeginInfo* mBeginInfo;
+    };
+
+    Chunks chunks{ this, aPipeline, chunkCount, secondaries, &beginInfo };
+
+    ThreadPool& pool = ThreadPool::Shared();
+    pool.ParallelFor(chunkCount, [&chunks, &pool](size_t aChunk)
+    {
+        VkRenderer* renderer = chunks.mRenderer;
+        VkCommandBuffer buffer = renderer->mSecondaryPools.Get(pool.CurrentThreadIndex());
+
+        uint32_t first = (uint32_t)aChunk * cDrawsPerSecondary;
+        uint32_t count = std::min(cDrawsPerSecondary, renderer->mDrawCount - first);
+
+        vkBeginCommandBuffer(buffer, chunks.mBeginInfo);
+
+        // Images are behind the triangles, so they go in the chunk that executes first.
+        if (0 == aChunk)
+        {
+            renderer->RecordImages(buffer);
+        }
+
+        renderer->RecordDraws(buffer, chunks.mPipeline, count);
+
+        // Text goes over everything, so in the chunk that executes last.
+        if ((chunks.mChunkCount - 1) == aChunk)
+        {
+            renderer->mGlyphs.Record(buffer, renderer->mTextPipeline.load(std::memory_order_acquire), renderer->mImageLayout);
+        }
+        vkEndCommandBuffer(buffer);
+
+        chunks.mBuffers[aChunk] = buffer;
+    });
+
+    // Chunks are executed in draw order no matter which thread recorded them.
+    vkCmdExecuteCommands(aPass.mCommandBuffer, (uint32_t)secondaries.size(), secondaries.data());
+}
+
+void VkRenderer::RecordScene(const VkGraphPassContext& aPass)
+{
+    if (VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS == aPass.mContents)
+    {
+        RecordSecondaryDraws(aPass, mFramePipeline, mFrameSlot);
+        return;
+    }
+
+    RecordImages(aPass.mCommandBuffer);
+    RecordDraws(aPass.mCommandBuffer, mFramePipeline, mDrawCount);
+    mGlyphs.Record(aPass.mCommandBuffer, mTextPipeline.load(std::memory_order_acquire), mImageLayout);
+}
+
+void VkRenderer::RecordPost(const VkGraphPassContext& aPass, VkDescriptorSet aSource)
+{
+    // Cleared to the clear color until the pipeline's built.
+    VkPipeline pipeline = mImagePipeline.load(std::memory_order_acquire);
+    if (VK_NULL_HANDLE == pipeline)
+    {
+        RequestAnimationFrame();
+        return;
+    }
+
+    VkViewport viewport = {};
+    viewport.width = (float)aPass.mExtent.width;
+    viewport.height = (float)aPass.mExtent.height;
+    viewport.maxDepth = 1.0f;
+    vkCmdSetViewport(aPass.mCommandBuffer, 0, 1, &viewport);
+
+    VkRect2D scissor = {};
+    scissor.extent = aPass.mExtent;
+    vkCmdSetScissor(aPass.mCommandBuffer, 0, 1, &scissor);
+
+    // The whole of the source over the whole target, at its only mip.
+    float push[5] = { -1.0f, -1.0f, 1.0f, 1.0f, 0.0f };
+    vkCmdBindPipeline(aPass.mCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+    vkCmdBindDescriptorSets(aPass.mCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mImageLayout, 0, 1, &aSource, 0, nullptr);
+    vkCmdPushConstants(aPass.mCommandBuffer, mImageLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(push), push);
+    vkCmdDraw(aPass.mCommandBuffer, 4, 1, 0, 0);
+}
+
+VkRenderer::VkRenderer(SDL_Window* aWindow)
+    : Renderer{ aWindow }
+{
+    // Everything here is thread-safe and expensive (loader, device selection, device and 
+    // swapchain creation), so it all happens in Initialize on a worker thread.
+}
+
+VkRenderer::~VkRenderer()
+{
+    // Pipeline tasks reference us, they have to be done before we go anywhere.
+    ThreadPool::Shared().Wait(mPipelineTasks);
+
+    if (nullptr == mContext)
+    {
+        return;
+    }
+
+    // Submits anything the context still has queued for us, and waits for our last frame,
+    // which waited on any compute it used, so nothing below is in flight anymore.
+    mContext->WaitForSerial(*std::max_element(mFrameSerials.begin(), mFrameSerials.end()));
+
+    ReleaseFramebuffers();
+    if (VK_NULL_HANDLE != mSwapchain.swapchain)
+    {
+        vkb::destroy_swapchain(mSwapchain);
+    }
+
+    mTextures.Clear();
+    mTextureUploader.Destroy();
+    mGlyphs.Destroy();
+
+    VkPipeline pipelines[] =
+    {
+        mFallbackPipeline.load(),
+        mTrianglePipeline.load(),
+        mImagePipeline.load(),
+        mTextPipeline.load(),
+        mAnimationPipeline
+    };
+
+    for (VkPipeline pipeline : pipelines)
+    {
+        vkDestroyPipeline(mDevice, pipeline, mDevice.allocation_callbacks);
+    }
+
+    vkDestroyPipelineLayout(mDevice, mPipelineLayout, mDevice.allocation_callbacks);
+    vkDestroyPipelineLayout(mDevice, mImageLayout, mDevice.allocation_callbacks);
+    vkDestroyPipelineLayout(mDevice, mAnimationLayout, mDevice.allocation_callbacks);
+    vkDestroyDescriptorSetLayout(mDevice, mDescriptorSetLayout, mDevice.allocation_callbacks);
+    vkDestroyDescriptorSetLayout(mDevice, mAnimationSetLayout, mDevice.allocation_callbacks);
+    vkDestroySampler(mDevice, mImageSampler, mDevice.allocation_callbacks);
+
+    // Takes every set allocated from it along.
+    vkDestroyDescriptorPool(mDevice, mDescriptorPool, mDevice.allocation_callbacks);
+
+    if (VK_NULL_HANDLE != mVertexBuffer)
+    {
+        vmaDestroyBuffer(mAllocator, mVertexBuffer, mVertexAllocation);
+    }
+
+    for (size_t i = 0; i < mAnimatedVertexBuffers.size(); ++i)
+    {
+        if (VK_NULL_HANDLE != mAnimatedVertexBuffers[i])
         {
-            mPhysicalDevice = physical_device_selector_return.value();
+            vmaDestroyBuffer(mAllocator, mAnimatedVertexBuffers[i], mAnimatedVertexAllocations[i]);
         }
     }
 
+    mSecondaryPools.Destroy();
+    mComputeQueue.Destroy();
+    mPresentQueue.Destroy();
+    mGraphicsQueue.Destroy();
+    mTransferQueue.Destroy();
+
+    SDL_Vulkan_DestroySurface(mContext->GetInstance().instance, mSurface, nullptr);
+}
+
+bool VkRenderer::Initialize()
+{
     ///////////////////////////////////////
-    // Create Logical Device
-    vkb::DeviceBuilder device_builder{ mPhysicalDevice };
-    auto dev_ret = device_builder.build();
-    if (!dev_ret) {
-        printf("Failed to create Logical Device. Error: %s\n", dev_ret.error().message().c_str());
+    // Get Context and Surface
+    // The instance, device and allocator are shared between panels, only the surface and
+    // everything that hangs off of it are ours.
+    mContext = VkContext::Acquire(mWindow, mSurface);
+    if (nullptr == mContext)
+    {
+        return false;
     }
-    mDevice = dev_ret.value();
+
+    mDevice = mContext->GetDevice();
+    mAllocator = mContext->GetAllocator();
 
     ///////////////////////////////////////
     // Create Queues
@@ -368,14 +1186,45 @@ VkRenderer::VkRenderer(SDL_Window* aWindow)
     mGraphicsQueue.Initialize(mDevice, vkb::QueueType::graphics, cMinImageCount);
     mPresentQueue.Initialize(mDevice, vkb::QueueType::present, cMinImageCount);
 
+    if (const char* compute = SDL_getenv("VK_RENDERER_ASYNC_COMPUTE"))
+    {
+        mAnimate = (0 != atoi(compute));
+
+        if (mAnimate && !mContext->SupportsTimelineSemaphores())
+        {
+            printf("VK_RENDERER_ASYNC_COMPUTE needs timeline semaphores, not animating\n");
+            mAnimate = false;
+        }
+    }
+
+    if (mAnimate)
+    {
+        mComputeQueue.Initialize(mDevice, vkb::QueueType::compute, cMinImageCount);
+    }
+
+    // One set per pool worker plus one for the thread that calls Update, which may not be
+    // a pool thread at all.
+    mSecondaryPools.Initialize(mDevice, mGraphicsQueue.GetQueueFamily(), ThreadPool::Shared().ThreadCount() + 1, cMinImageCount);
+
+    if (const char* draws = SDL_getenv("VK_RENDERER_DRAWS"))
+    {
+        mDrawCount = (uint32_t)std::max(1, atoi(draws));
+    }
+
+    if (const char* passes = SDL_getenv("VK_RENDERER_POST_PASSES"))
+    {
+        mPostPassCount = (uint32_t)std::max(0, atoi(passes));
+    }
+
     ///////////////////////////////////////
     // Create Swapchain
     vkb::SwapchainBuilder swapchain_builder{ mDevice, mSurface };
-    swapchain_builder.set_desired_format(VkSurfaceFormatKHR{ VK_FORMAT_B8G8R8A8_UNORM, VK_COLORSPACE_SRGB_NONLINEAR_KHR });
+    ConfigureSwapchain(swapchain_builder);
     auto swap_ret = swapchain_builder.build();
     if (!swap_ret) 
     {
         printf("Failed to create Vulkan Swapchain. Error: %s\n", swap_ret.error().message().c_str());
+        return false;
     }
     mSwapchain = swap_ret.value();
 
@@ -402,32 +1251,32 @@ VkRenderer::VkRenderer(SDL_Window* aWindow)
         pool_info.maxSets = 1000 * std::size(pool_sizes);
         pool_info.poolSizeCount = (uint32_t)std::size(pool_sizes);
         pool_info.pPoolSizes = pool_sizes;
-        VkResult err = vkCreateDescriptorPool(mDevice, &pool_info, mInstance.allocation_callbacks, &mDescriptorPool);
+        VkResult err = vkCreateDescriptorPool(mDevice, &pool_info, mDevice.allocation_callbacks, &mDescriptorPool);
         check_vk_result(err);
     }
 
     ///////////////////////////////////////
-    // Create Font Sampler:
+    // Create Image Sampler:
     {
         VkSamplerCreateInfo info = {};
         info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
         info.magFilter = VK_FILTER_LINEAR;
         info.minFilter = VK_FILTER_LINEAR;
         info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-        info.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-        info.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-        info.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
         info.minLod = -1000;
         info.maxLod = 1000;
         info.maxAnisotropy = 1.0f;
-        VkResult err = vkCreateSampler(mDevice.device, &info, NULL, &mFontSampler);
+        VkResult err = vkCreateSampler(mDevice.device, &info, NULL, &mImageSampler);
         check_vk_result(err);
     }
 
     ///////////////////////////////////////
     // Create Descriptor Set Layout:
     {
-        VkSampler sampler[1] = { mFontSampler };
+        VkSampler sampler[1] = { mImageSampler };
         VkDescriptorSetLayoutBinding binding[1] = {};
         binding[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
         binding[0].descriptorCount = 1;
@@ -441,60 +1290,140 @@ VkRenderer::VkRenderer(SDL_Window* aWindow)
         check_vk_result(err);
     }
 
-    ///////////////////////////////////////
-    // Create Allocator
-    VmaAllocatorCreateInfo allocatorInfo = {};
-    allocatorInfo.vulkanApiVersion = VK_API_VERSION_1_0;
-    allocatorInfo.physicalDevice = mPhysicalDevice;
-    allocatorInfo.device = mDevice;
-    allocatorInfo.instance = mInstance;
-
-    vmaCreateAllocator(&allocatorInfo, &mAllocator);
-    printf("Create allocator %p\n", mAllocator);
+    mTextureUploader.Initialize(mDevice, mAllocator, mDescriptorPool, mDescriptorSetLayout, cMinImageCount, mTextures.UploadBudget());
+    mGlyphs.Initialize(mDevice, mAllocator, mDescriptorPool, mDescriptorSetLayout, cMinImageCount);
 
     ///////////////////////////////////////
     // Create Render Pass
     mRenderPass = CreateRenderPass();
 
     ///////////////////////////////////////
-    // Create Framebuffers
-    int w, h;
-    SDL_GetWindowSize(aWindow, &w, &h);
+    // Create Pipeline
+    // The SPIR-V is baked into the binary at build time, so there's no file I/O or shader
+    // compiler involved here.
+    {
+        VkPushConstantRange push_constant = {};
+        push_constant.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+        push_constant.offset = 0;
+        push_constant.size = sizeof(float) * 4;
+
+        VkPipelineLayoutCreateInfo layout_info = {};
+        layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        layout_info.pushConstantRangeCount = 1;
+        layout_info.pPushConstantRanges = &push_constant;
+        VkResult err = vkCreatePipelineLayout(mDevice, &layout_info, mDevice.allocation_callbacks, &mPipelineLayout);
+        check_vk_result(err);
 
-    swapchain_images = mSwapchain.get_images().value();
-    swapchain_image_views = mSwapchain.get_image_views().value();
+        // The image's rect and the finest mip it has so far.
+        VkPushConstantRange image_push_constant = {};
+        image_push_constant.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+        image_push_constant.offset = 0;
+        image_push_constant.size = sizeof(float) * 5;
+
+        VkPipelineLayoutCreateInfo image_layout_info = {};
+        image_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        image_layout_info.setLayoutCount = 1;
+        image_layout_info.pSetLayouts = &mDescriptorSetLayout;
+        image_layout_info.pushConstantRangeCount = 1;
+        image_layout_info.pPushConstantRanges = &image_push_constant;
+        err = vkCreatePipelineLayout(mDevice, &image_layout_info, mDevice.allocation_callbacks, &mImageLayout);
+        check_vk_result(err);
 
-    mFramebuffers.resize(swapchain_image_views.size());
+        // Pipelines are built on the pool through the shared cache, the fixed color
+        // permutation goes first since it's what we draw with until the real one is done.
+        // Whichever finishes last writes the cache back out.
+        ThreadPool& pool = ThreadPool::Shared();
+        mPipelinesPending.store(4);
 
-    for (size_t i = 0; i < swapchain_image_views.size(); i++) 
-    {
-        VkImageView attachments[] = { swapchain_image_views[i] };
+        pool.Submit(mPipelineTasks, [this]()
+        {
+            mFallbackPipeline.store(CreateTrianglePipeline(
+                GetSpirv<ShaderId::TriangleVertex>(),
+                GetSpirv<ShaderId::TriangleFragment>()), std::memory_order_release);
 
-        VkFramebufferCreateInfo framebuffer_info = {};
-        framebuffer_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-        framebuffer_info.renderPass = mRenderPass;
-        framebuffer_info.attachmentCount = 1;
-        framebuffer_info.pAttachments = attachments;
-        framebuffer_info.width = mSwapchain.extent.width;
-        framebuffer_info.height = mSwapchain.extent.height;
-        framebuffer_info.layers = 1;
+            if (1 == mPipelinesPending.fetch_sub(1))
+            {
+                mContext->SavePipelineCache();
+            }
+        });
 
-        if (vkCreateFramebuffer(mDevice, &framebuffer_info, nullptr, &mFramebuffers[i]) != VK_SUCCESS)
+        pool.Submit(mPipelineTasks, [this]()
         {
-            printf("failed to create framebuffer\n");
-            return;
-        }
+            mTrianglePipeline.store(CreateTrianglePipeline(
+                GetSpirv<ShaderId::TriangleVertex>(),
+                GetSpirv<ShaderId::TriangleFragment, ShaderPermutation::PushConstantColor>()), std::memory_order_release);
+
+            if (1 == mPipelinesPending.fetch_sub(1))
+            {
+                mContext->SavePipelineCache();
+            }
+        });
+
+        pool.Submit(mPipelineTasks, [this]()
+        {
+            mImagePipeline.store(CreateImagePipeline(), std::memory_order_release);
+
+            if (1 == mPipelinesPending.fetch_sub(1))
+            {
+                mContext->SavePipelineCache();
+            }
+        });
+
+        pool.Submit(mPipelineTasks, [this]()
+        {
+            mTextPipeline.store(CreateTextPipeline(), std::memory_order_release);
+
+            if (1 == mPipelinesPending.fetch_sub(1))
+            {
+                mContext->SavePipelineCache();
+            }
+        });
     }
-}
 
-void VkRenderer::Initialize()
-{
+    CreateVertexBuffer();
+    mFrameVertexBuffer = mVertexBuffer;
 
+    if (mAnimate)
+    {
+        CreateAnimationCompute();
+    }
+
+    ///////////////////////////////////////
+    // Create Framebuffers
+    mGraph.Initialize(mDevice, mAllocator, &mContext->GetRenderPassCache());
+    CreateFramebuffers();
+    return true;
 }
 
 void VkRenderer::Update()
 {
-    auto vulkanCommandBuffer = mGraphicsQueue.WaitOnNextCommandList();
+    if (nullptr == mContext)
+    {
+        return;
+    }
+
+    // The swapchain is externally synchronized, and flushes present it from whichever
+    // thread they run on, so our last frame has to be out before we acquire again.
+    mContext->FlushQueuedFrame(this);
+
+    if (mSwapchainOutOfDate)
+    {
+        RecreateSwapchain();
+    }
+
+    // The old swapchain is gone by now, and with it the acquire that signalled this.
+    if (VK_NULL_HANDLE != mDroppedImageAvailable)
+    {
+        mGraphicsQueue.RecreateAvailableSemaphore(mDroppedImageAvailable);
+        mDroppedImageAvailable = VK_NULL_HANDLE;
+    }
+
+    // Command buffers go out in the context's batched submits, so their fences aren't
+    // ours to wait on, the serial of the submit they went out with is.
+    size_t slot = mGraphicsQueue.GetNextIndex();
+    mContext->WaitForSerial(mFrameSerials[slot]);
+
+    auto vulkanCommandBuffer = mGraphicsQueue.GetNextCommandList();
     auto [commandBuffer, fence, waitSemaphore, signalSemphore] = vulkanCommandBuffer;
 
     // Wait on last frame/get next frame now, just in case we need to load the font textures.
@@ -507,7 +1436,7 @@ void VkRenderer::Update()
 
     if (result == VK_ERROR_OUT_OF_DATE_KHR) 
     {
-        return Resize(0, 0);
+        return RecreateSwapchain();
     }
     else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
     {
@@ -515,109 +1444,199 @@ void VkRenderer::Update()
         return;
     }
 
+    // Only once we know this frame will be queued, so every dispatch has a frame waiting
+    // on it, and the slot's serial covers it.
+    uint64_t computeWait = 0;
+    mFrameVertexBuffer = mVertexBuffer;
+    if (mAnimate)
+    {
+        computeWait = DispatchAnimation(slot);
+        if (0 != computeWait)
+        {
+            mFrameVertexBuffer = mAnimatedVertexBuffers[slot];
+        }
+
+        RequestAnimationFrame();
+    }
+
     VkCommandBufferBeginInfo beginInfo = {};
     beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
     beginInfo.flags |= VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
     vkBeginCommandBuffer(commandBuffer, &beginInfo);
 
+    PrepareImages(slot, commandBuffer);
+    mGlyphs.Prepare(slot, commandBuffer, mText, mSwapchain.extent, mStats);
 
-    mClearColor;
-
-    VkClearColorValue color;
-    color.float32[0] = mClearColor.r / 255.f;
-    color.float32[1] = mClearColor.g / 255.f;
-    color.float32[2] = mClearColor.b / 255.f;
-    color.float32[3] = mClearColor.a / 255.f;
-
-    VkClearValue clearColor{ { color } };
-    VkRenderPassBeginInfo info = {};
-    info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-    info.renderPass = mRenderPass;
-    info.framebuffer = mFramebuffers[mImageIndex];
-    info.renderArea.extent = mSwapchain.extent;
-    info.clearValueCount = 1;
-    info.pClearValues = &clearColor;
-    vkCmdBeginRenderPass(commandBuffer, &info, VK_SUBPASS_CONTENTS_INLINE);
-
-
-
-
-
-
-
-
+    // The graph's passes clear to this.
+    mClearValue.float32[0] = mClearColor.r / 255.f;
+    mClearValue.float32[1] = mClearColor.g / 255.f;
+    mClearValue.float32[2] = mClearColor.b / 255.f;
+    mClearValue.float32[3] = mClearColor.a / 255.f;
 
+    // Never wait on a pipeline that's still being built, draw with the fallback or not at
+    // all, and keep frames coming until the real one shows up.
+    VkPipeline pipeline = mTrianglePipeline.load(std::memory_order_acquire);
+    if (VK_NULL_HANDLE == pipeline)
+    {
+        pipeline = mFallbackPipeline.load(std::memory_order_acquire);
 
+        if (VK_NULL_HANDLE == pipeline)
+        {
+            ++mStats.mFramesWithSkippedDraws;
+        }
+        else
+        {
+            ++mStats.mFramesWithFallbackPipeline;
+        }
 
+        RequestAnimationFrame();
+    }
 
+    mFramePipeline = pipeline;
+    mFrameSlot = slot;
 
+    // Every pass, barrier and layout transition, ending with the swapchain image ready to
+    // present.
+    mGraph.SetImportedImage(mGraphSwapchain, swapchain_images[mImageIndex], swapchain_image_views[mImageIndex]);
+    mGraph.Execute(commandBuffer);
 
+    vkEndCommandBuffer(commandBuffer);
 
+    // We always redraw the whole image, but if only part of it changed the compositor
+    // doesn't need to know about the rest.
+    std::vector<VkRectLayerKHR>& presentRects = mPresentRects[slot];
+    presentRects.clear();
+    if (mContext->SupportsIncrementalPresent() && !HasFullDamage())
+    {
+        for (const SDL_Rect& damage : GetDamageRects())
+        {
+            VkRectLayerKHR rect = {};
+            rect.offset = { damage.x, damage.y };
+            rect.extent = { (uint32_t)damage.w, (uint32_t)damage.h };
+            rect.layer = 0;
+            presentRects.push_back(rect);
+        }
+    }
 
+    VkPendingFrame frame;
+    frame.mRenderer = this;
+    frame.mCommandBuffer = commandBuffer;
+    frame.mImageAvailable = waitSemaphore;
+    frame.mRenderFinished = signalSemphore;
+    frame.mSwapchain = mSwapchain;
+    frame.mImageIndex = mImageIndex;
+    frame.mPresentRects = &presentRects;
+    frame.mComputeWait = computeWait;
 
+    // Submit and present happen when the host flushes, together with every other panel.
+    BeginSubmit();
+    mFrameSerials[slot] = mContext->QueueFrame(frame);
 
+    mCurrentFrame = (mCurrentFrame + 1) % cMinImageCount;
+}
 
+void VkRenderer::OnFramePresented(VkResult aResult, size_t aBatchSize)
+{
+    // This runs on whichever thread flushed, which with a RenderScheduler needn't be ours,
+    // so only thread safe state is touched and the swapchain is recreated in our next Update.
+    if ((aResult == VK_SUCCESS) || (aResult == VK_SUBOPTIMAL_KHR))
+    {
+        EndPresent(aBatchSize);
+    }
 
+    if (aResult == VK_ERROR_OUT_OF_DATE_KHR || aResult == VK_SUBOPTIMAL_KHR)
+    {
+        mSwapchainOutOfDate = true;
+        Invalidate();
+    }
+    else if (aResult != VK_SUCCESS)
+    {
+        printf("failed to present swapchain image\n");
+    }
+}
 
+void VkRenderer::OnFrameDropped(VkSemaphore aImageAvailable)
+{
+    // The image we acquired is never coming back from the presentation engine, so we
+    // start over with a new swapchain.
+    mDroppedImageAvailable = aImageAvailable;
+    mSwapchainOutOfDate = true;
+    Invalidate();
+}
 
+MemoryReport VkRenderer::GetMemoryReport()
+{
+    MemoryReport report;
 
-    vkCmdEndRenderPass(commandBuffer);
-    vkEndCommandBuffer(commandBuffer);
+    if (nullptr == mContext)
+    {
+        return report;
+    }
 
-    VkSubmitInfo submitInfo = {};
-    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    if (VK_NULL_HANDLE != mVertexAllocation)
+    {
+        VmaAllocationInfo info = {};
+        vmaGetAllocationInfo(mAllocator, mVertexAllocation, &info);
+        report.mEntries.push_back(MemoryEntry{ "Vertex buffer", info.size });
+    }
 
-    VkSemaphore wait_semaphores[] = { waitSemaphore };
-    VkPipelineStageFlags wait_stages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-    submitInfo.waitSemaphoreCount = 1;
-    submitInfo.pWaitSemaphores = wait_semaphores;
-    submitInfo.pWaitDstStageMask = wait_stages;
+    report.mEntries.push_back(MemoryEntry{ "Textures", mTextureUploader.TextureBytes() });
+    report.mEntries.push_back(MemoryEntry{ "Texture staging", mTextureUploader.StagingBytes() });
+    report.mEntries.push_back(MemoryEntry{ "Glyph atlas", mGlyphs.ImageBytes() });
+    report.mEntries.push_back(MemoryEntry{ "Glyph buffers", mGlyphs.BufferBytes() });
+    report.mEntries.push_back(MemoryEntry{ "Render graph transients", mGraph.GetStats().mTransientAllocatedBytes });
 
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &commandBuffer;
+    // Swapchain images belong to the driver, all we know is their count, size and format.
+    uint64_t swapchainBytes = (uint64_t)mSwapchain.extent.width * mSwapchain.extent.height * 4 * mSwapchain.image_count;
+    report.mEntries.push_back(MemoryEntry{ "Swapchain images", swapchainBytes, true });
 
-    VkSemaphore signal_semaphores[] = { signalSemphore };
-    submitInfo.signalSemaphoreCount = 1;
-    submitInfo.pSignalSemaphores = signal_semaphores;
+    // The allocator is shared with every other Vulkan panel, so these are too.
+    const VkPhysicalDeviceMemoryProperties* properties = nullptr;
+    vmaGetMemoryProperties(mAllocator, &properties);
 
-    vkResetFences(mDevice, 1, &fence);
+    VmaBudget budgets[VK_MAX_MEMORY_HEAPS] = {};
+    vmaGetHeapBudgets(mAllocator, budgets);
 
-    if (vkQueueSubmit(mGraphicsQueue, 1, &submitInfo, fence) != VK_SUCCESS)
+    for (uint32_t i = 0; i < properties->memoryHeapCount; ++i)
     {
-        printf("failed to submit draw command buffer\n");
-        return;
+        MemoryHeapReport heap;
+        heap.mDeviceLocal = 0 != (properties->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT);
+        heap.mBudgetBytes = budgets[i].budget;
+        heap.mUsageBytes = budgets[i].usage;
+        heap.mBlockBytes = budgets[i].statistics.blockBytes;
+        heap.mAllocationBytes = budgets[i].statistics.allocationBytes;
+        heap.mAllocationCount = budgets[i].statistics.allocationCount;
+        report.mHeaps.push_back(heap);
     }
 
-    VkPresentInfoKHR present_info = {};
-    present_info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
-
-    present_info.waitSemaphoreCount = 1;
-    present_info.pWaitSemaphores = signal_semaphores;
+    return report;
+}
 
-    VkSwapchainKHR swapChains[] = { mSwapchain };
-    present_info.swapchainCount = 1;
-    present_info.pSwapchains = swapChains;
+void VkRenderer::Resize(unsigned int aWidth, unsigned int aHeight)
+{
+    Renderer::Resize(aWidth, aHeight);
+    RecreateSwapchain();
+}
 
-    present_info.pImageIndices = &mImageIndex;
+void VkRenderer::RecreateSwapchain()
+{
+    // Whatever was in the old swapchain is gone, make sure we draw into the new one.
+    Invalidate();
 
-    result = vkQueuePresentKHR(mPresentQueue, &present_info);
-    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
+    if (nullptr == mContext)
     {
-        return Resize(0, 0);
-    }
-    else if (result != VK_SUCCESS)
-    {
-        printf("failed to present swapchain image\n");
         return;
     }
 
-    mCurrentFrame = (mCurrentFrame + 1) % cMinImageCount;
-}
+    // A queued frame still points at the old swapchain, it has to be presented first.
+    mContext->FlushFrames();
+    mSwapchainOutOfDate = false;
 
-void VkRenderer::Resize(unsigned int aWidth, unsigned int aHeight)
-{
-    vkb::SwapchainBuilder swapchain_builder{ mDevice };
-    swapchain_builder.set_desired_format(VkSurfaceFormatKHR{ VK_FORMAT_B8G8R8A8_UNORM, VK_COLORSPACE_SRGB_NONLINEAR_KHR });
+    // Framebuffers hold the old swapchain's image views, so they go with it.
+    ReleaseFramebuffers();
+
+    vkb::SwapchainBuilder swapchain_builder{ mDevice, mSurface };
+    ConfigureSwapchain(swapchain_builder);
     auto swap_ret = swapchain_builder.set_old_swapchain(mSwapchain).build();
     if (!swap_ret)
     {
@@ -638,34 +1657,5 @@ void VkRenderer::Resize(unsigned int aWidth, unsigned int aHeight)
     // Get the new swapchain and place it in our variable
     mSwapchain = swap_ret.value();
 
-
-    for (auto framebuffer : mFramebuffers)
-    {
-        vkDestroyFramebuffer(mDevice.device, framebuffer, mDevice.allocation_callbacks);
-    }
-
-    swapchain_images = mSwapchain.get_images().value();
-    swapchain_image_views = mSwapchain.get_image_views().value();
-
-    mFramebuffers.resize(swapchain_image_views.size());
-
-    for (size_t i = 0; i < swapchain_image_views.size(); i++)
-    {
-        VkImageView attachments[] = { swapchain_image_views[i] };
-
-        VkFramebufferCreateInfo framebuffer_info = {};
-        framebuffer_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-        framebuffer_info.renderPass = mRenderPass;
-        framebuffer_info.attachmentCount = 1;
-        framebuffer_info.pAttachments = attachments;
-        framebuffer_info.width = mSwapchain.extent.width;
-        framebuffer_info.height = mSwapchain.extent.height;
-        framebuffer_info.layers = 1;
-
-        if (vkCreateFramebuffer(mDevice, &framebuffer_info, nullptr, &mFramebuffers[i]) != VK_SUCCESS)
-        {
-            printf("failed to create framebuffer\n");
-            return;
-        }
-    }
+    CreateFramebuffers();
 }
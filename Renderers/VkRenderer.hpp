@@ -9,6 +9,14 @@
 #include "SDL3/SDL.h"
 
 #include "Renderers/Renderer.hpp"
+#include "Renderers/TextureStreamer.hpp"
+#include "Renderers/VkContext.hpp"
+#include "Renderers/VkGlyphAtlas.hpp"
+#include "Renderers/VkRenderGraph.hpp"
+#include "Renderers/VkShaders.hpp"
+#include "Renderers/VkTextureUploader.hpp"
+
+#include "Utilities/ThreadPool.hpp"
 
 
 struct VulkanCommandBuffer
@@ -49,10 +57,21 @@ public:
 	
 	void Initialize(vkb::Device aDevice, vkb::QueueType aType, size_t aNumberOfBuffers);
 
+	// Frees the pool, its buffers and the sync objects. None of them may be in flight.
+	void Destroy();
+
 	VulkanCommandBuffer WaitOnNextCommandList();
 	VulkanCommandBuffer GetNextCommandList();
 	VulkanCommandBuffer GetCurrentCommandList();
 
+	// A specific command list, for work that's paced by someone else's index. The caller
+	// has to know its last submit has finished.
+	VulkanCommandBuffer GetCommandList(size_t aIndex);
+
+	// Replaces one of our acquire semaphores that was signalled but will never be
+	// waited on, which is the only way to make it usable again.
+	void RecreateAvailableSemaphore(VkSemaphore aSemaphore);
+
 	auto* operator&()
 	{
 		return &mQueue;
@@ -79,6 +98,12 @@ public:
 
 	uint32_t GetQueueFamily();
 
+	// Index the next GetNextCommandList/WaitOnNextCommandList call will hand out.
+	size_t GetNextIndex() const
+	{
+		return (1 + mCurrentBuffer) % mCommandBuffers.size();
+	}
+
 	void Submit(VulkanCommandBuffer aCommandList);
 
 private:
@@ -94,46 +119,205 @@ private:
 	vkb::QueueType mType;
 };
 
+// Command pools for recording secondary command buffers on the thread pool, one per pool
+// thread (plus one for whoever isn't a pool thread) per frame in flight. A command pool can
+// only be used by one thread at a time, so giving each thread its own means recording
+// takes no locks, and a frame's pools are only reset once that frame is done on the GPU.
+class VulkanSecondaryCommandPools
+{
+public:
+    void Initialize(vkb::Device aDevice, uint32_t aQueueFamily, size_t aThreadCount, size_t aFrameCount);
+
+    // Frees every pool, along with the buffers from them. None of them may be in flight.
+    void Destroy();
+
+    // Makes every buffer handed out for aFrame reusable. Its last submit must have finished.
+    void BeginFrame(size_t aFrame);
+
+    // A secondary buffer from aThreadIndex's pool for the frame BeginFrame last started.
+    // Buffers are kept for reuse, so only the first frames allocate.
+    VkCommandBuffer Get(size_t aThreadIndex);
+
+private:
+    struct PerThread
+    {
+        VkCommandPool mPool = VK_NULL_HANDLE;
+        std::vector<VkCommandBuffer> mBuffers;
+        size_t mUsed = 0;
+    };
+
+    vkb::Device mDevice;
+    size_t mThreadCount = 0;
+    size_t mFrame = 0;
+    std::vector<PerThread> mPools; // mThreadCount per frame, frame major.
+};
+
 class VkRenderer : public Renderer
 {
 public:
 	VkRenderer(SDL_Window* aWindow);
+    ~VkRenderer() override;
 
-	void Initialize() override;
+	bool Initialize() override;
 	void Update() override;
 	void Resize(unsigned int aWidth, unsigned int aHeight) override;
     virtual const char* Name() override { return "VkRenderer"; };
+    MemoryReport GetMemoryReport() override;
+
+protected:
+    PresentMode ApplyPresentMode(PresentMode aMode) override;
 
 private:
+    friend class VkContext;
+
+    // Called by the context once the frame we queued has been presented, with the
+    // number of frames that went out in the same submit. The context is locked, so
+    // this can't call back into it.
+    void OnFramePresented(VkResult aResult, size_t aBatchSize);
+
+    // Called by the context, also locked, before OnFramePresented when the frame's submit
+    // failed, so it was never rendered or presented.
+    void OnFrameDropped(VkSemaphore aImageAvailable);
+
+    void ConfigureSwapchain(vkb::SwapchainBuilder& aBuilder);
+
+    // Builds a new swapchain at the surface's current size, from our own thread too.
+    void RecreateSwapchain();
 	VkRenderPass CreateRenderPass();
+    void CreateFramebuffers();
+    void ReleaseFramebuffers();
+    void BuildGraph();
+    VkShaderModule CreateShaderModule(std::span<const uint32_t> aSpirv);
+    VkPipeline CreateGraphicsPipeline(std::span<const uint32_t> aVertexSpirv, std::span<const uint32_t> aFragmentSpirv,
+        const VkPipelineVertexInputStateCreateInfo& aVertexInput, VkPrimitiveTopology aTopology, VkPipelineLayout aLayout, bool aBlend);
+    VkPipeline CreateTrianglePipeline(std::span<const uint32_t> aVertexSpirv, std::span<const uint32_t> aFragmentSpirv);
+    VkPipeline CreateImagePipeline();
+    VkPipeline CreateTextPipeline();
+    void CreateVertexBuffer();
+    void CreateAnimationCompute();
+    uint64_t DispatchAnimation(size_t aSlot);
+    void PrepareImages(size_t aSlot, VkCommandBuffer aCommandBuffer);
+    void RecordImages(VkCommandBuffer aCommandBuffer);
+    void RecordDraws(VkCommandBuffer aCommandBuffer, VkPipeline aPipeline, uint32_t aDrawCount);
+    void RecordSecondaryDraws(const VkGraphPassContext& aPass, VkPipeline aPipeline, size_t aFrame);
+    void RecordScene(const VkGraphPassContext& aPass);
+    void RecordPost(const VkGraphPassContext& aPass, VkDescriptorSet aSource);
 
     static constexpr uint32_t cMinImageCount = 3;
 
-    vkb::Instance mInstance;
-    VkSurfaceKHR mSurface;
-    vkb::PhysicalDevice mPhysicalDevice;
+    // Draws per secondary command buffer. Below this it's cheaper to record inline than to
+    // hand the work to the pool.
+    static constexpr uint32_t cDrawsPerSecondary = 256;
+
+    // Shared with every other VkRenderer, mDevice and mAllocator are copies of its handles.
+    VkContext* mContext = nullptr;
     vkb::Device mDevice;
-    VkPipelineCache mPipelineCache = VK_NULL_HANDLE;
+    VmaAllocator mAllocator = VK_NULL_HANDLE;
+
+    VkSurfaceKHR mSurface = VK_NULL_HANDLE;
     VulkanQueue mTransferQueue;
     VulkanQueue mGraphicsQueue;
     VulkanQueue mPresentQueue;
+    VulkanQueue mComputeQueue;
+    VulkanSecondaryCommandPools mSecondaryPools;
+
+    // How many times the triangle is drawn each frame, VK_RENDERER_DRAWS sets it so there's
+    // enough recording work to measure scaling across cores.
+    uint32_t mDrawCount = 1;
     vkb::Swapchain mSwapchain;
-    VkDescriptorPool mDescriptorPool;
 
-    VmaAllocator mAllocator;
+    // What swapchains get built with. Renderer::mPresentMode is SetPresentMode's to write,
+    // it compares against it to notice the mode changing.
+    PresentMode mSwapchainPresentMode = PresentMode::Fifo;
+    VkDescriptorPool mDescriptorPool = VK_NULL_HANDLE;
 
-    VkSampler mFontSampler;
-    VkDescriptorSetLayout mDescriptorSetLayout;
+    // Images are bound through sets of this layout, which bakes in the sampler.
+    VkSampler mImageSampler = VK_NULL_HANDLE;
+    VkDescriptorSetLayout mDescriptorSetLayout = VK_NULL_HANDLE;
 
     std::vector<VkImage> swapchain_images;
     std::vector<VkImageView> swapchain_image_views;
-    std::vector<VkFramebuffer> mFramebuffers;
 
-    VkRenderPass mRenderPass;
+    // Owned by the context's render pass cache. Pipelines are built against it, and stay
+    // compatible with the graph's passes since they only differ in load ops and layouts.
+    VkRenderPass mRenderPass = VK_NULL_HANDLE;
+
+    // Rebuilt with the swapchain. The scene is drawn straight into the swapchain image, or
+    // with VK_RENDERER_POST_PASSES=n into a transient that n full screen copies carry to
+    // it, each sampling the last, which gives the graph transients to alias.
+    VkRenderGraph mGraph;
+    VkRenderGraph::Resource mGraphSwapchain = 0;
+    uint32_t mPostPassCount = 0;
+    std::vector<VkDescriptorSet> mPostSets;
+    VkClearColorValue mClearValue = {};
+
+    // What the scene pass draws the triangle with this frame, and the slot it's recorded for.
+    VkPipeline mFramePipeline = VK_NULL_HANDLE;
+    size_t mFrameSlot = 0;
+
+    // Both built asynchronously, readers have to go through the atomics.
+    VkPipelineLayout mPipelineLayout = VK_NULL_HANDLE;
+    std::atomic<VkPipeline> mTrianglePipeline = VK_NULL_HANDLE;
+    std::atomic<VkPipeline> mFallbackPipeline = VK_NULL_HANDLE;
+    VkPipelineLayout mImageLayout = VK_NULL_HANDLE;
+    std::atomic<VkPipeline> mImagePipeline = VK_NULL_HANDLE;
+    std::atomic<VkPipeline> mTextPipeline = VK_NULL_HANDLE;
+    TaskGroup mPipelineTasks;
+    std::atomic<int> mPipelinesPending = 0;
+
+    VkBuffer mVertexBuffer = VK_NULL_HANDLE;
+    VmaAllocation mVertexAllocation = VK_NULL_HANDLE;
+
+    // VK_RENDERER_ASYNC_COMPUTE=1 spins the triangle in a compute shader on the compute
+    // queue, into a vertex buffer per frame slot that the frame's draws wait on through the
+    // compute timeline. Needs timeline semaphores, without them the triangle stays put.
+    bool mAnimate = false;
+    VkDescriptorSetLayout mAnimationSetLayout = VK_NULL_HANDLE;
+    VkPipelineLayout mAnimationLayout = VK_NULL_HANDLE;
+    VkPipeline mAnimationPipeline = VK_NULL_HANDLE;
+    std::array<VkBuffer, cMinImageCount> mAnimatedVertexBuffers = {};
+    std::array<VmaAllocation, cMinImageCount> mAnimatedVertexAllocations = {};
+    std::array<VkDescriptorSet, cMinImageCount> mAnimationSets = {};
+    Uint64 mAnimationStartNs = 0;
+
+    // Uploads are recorded into the frame's command buffer, so the uploader's staging and
+    // garbage are paced by the same slots as everything else.
+    struct ImageDraw
+    {
+        VkDescriptorSet mSet;
+
+        // Laid out like Image.vert's push constants, they're pushed straight from here.
+        float mRect[4];
+        float mMinLod;
+    };
+
+    VkTextureUploader mTextureUploader;
+    TextureStreamer mTextures{ mTextureUploader };
+    std::span<ImageDraw> mImageDraws;
+
+    VkGlyphAtlas mGlyphs;
+
+    // What this frame's draws read their vertices from.
+    VkBuffer mFrameVertexBuffer = VK_NULL_HANDLE;
 
     size_t mCurrentFrame = 0;
     uint32_t mImageIndex = 0;
 
+    // Context submit serial each graphics command buffer was last submitted with, a slot
+    // can't be reused until that submit has finished.
+    std::array<uint64_t, cMinImageCount> mFrameSerials = {};
+
+    // Damage of each queued frame, read by the context when it presents. Per slot, since the
+    // flush may be running on another thread while we record the next frame.
+    std::array<std::vector<VkRectLayerKHR>, cMinImageCount> mPresentRects;
+
+    // Set when a present reports the swapchain no longer matches the surface, it gets
+    // recreated at the start of the next Update.
+    std::atomic<bool> mSwapchainOutOfDate = false;
+
+    // Acquire semaphore of a frame the context dropped, replaced in the next Update. Only
+    // written with the context locked, and only read after FlushQueuedFrame.
+    VkSemaphore mDroppedImageAvailable = VK_NULL_HANDLE;
 
     bool mLoadedFontTexture = false;
 };
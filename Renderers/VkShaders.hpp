@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+#include "Utilities/AssetPack.hpp"
+
+// Compile-time keys for the SPIR-V embedded by cmake/SpirvShaders.cmake. Each shader and
+// permutation pair that's listed in CMakeLists.txt gets a SpirvShader specialization in
+// the generated header, asking for one that wasn't built is a compile error.
+enum class ShaderId
+{
+    TriangleVertex,
+    TriangleFragment,
+    TriangleAnimateCompute,
+    ImageVertex,
+    ImageFragment,
+    TextVertex,
+    TextFragment,
+};
+
+enum class ShaderPermutation
+{
+    None,
+    PushConstantColor,
+};
+
+template <ShaderId tId, ShaderPermutation tPermutation>
+struct SpirvShader;
+
+#include "SpirvShaders.hpp"
+
+// The mounted asset pack's copy when it has one, so shaders are read straight out of the
+// mapping and can be swapped without relinking, the embedded one otherwise. Packed payloads
+// are aligned well past what SPIR-V words need.
+template <ShaderId tId, ShaderPermutation tPermutation = ShaderPermutation::None>
+std::span<const uint32_t> GetSpirv()
+{
+    using Shader = SpirvShader<tId, tPermutation>;
+
+    std::span<const uint8_t> packed = AssetPack::Mounted().Find(Shader::cName);
+    if (!packed.empty() && (0 == (packed.size() % sizeof(uint32_t))))
+    {
+        return { (const uint32_t*)packed.data(), packed.size() / sizeof(uint32_t) };
+    }
+
+    return Shader::cCode;
+}
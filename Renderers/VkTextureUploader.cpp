@@ -0,0 +1,283 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "Renderers/VkTextureUploader.hpp"
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Staging:
+bool VkTextureUploader::CreateStaging(Staging& aStaging, size_t aCapacity)
+{
+    VkBufferCreateInfo buffer_info = {};
+    buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buffer_info.size = aCapacity;
+    buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    VmaAllocationCreateInfo allocation_info = {};
+    allocation_info.usage = VMA_MEMORY_USAGE_AUTO;
+    allocation_info.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+    VmaAllocationInfo allocated = {};
+    if (VK_SUCCESS != vmaCreateBuffer(mAllocator, &buffer_info, &allocation_info, &aStaging.mBuffer, &aStaging.mAllocation, &allocated))
+    {
+        printf("failed to create texture staging buffer\n");
+        aStaging = {};
+        return false;
+    }
+
+    aStaging.mData = static_cast<uint8_t*>(allocated.pMappedData);
+    aStaging.mCapacity = aCapacity;
+    aStaging.mUsed = 0;
+    return true;
+}
+
+void VkTextureUploader::ReleaseStaging(Staging& aStaging)
+{
+    if (VK_NULL_HANDLE != aStaging.mBuffer)
+    {
+        vmaDestroyBuffer(mAllocator, aStaging.mBuffer, aStaging.mAllocation);
+    }
+
+    aStaging = {};
+}
+
+uint64_t VkTextureUploader::StagingBytes() const
+{
+    uint64_t bytes = 0;
+    for (const Staging& staging : mStaging)
+    {
+        bytes += staging.mCapacity;
+    }
+
+    return bytes;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// VkTextureUploader:
+void VkTextureUploader::Initialize(vkb::Device aDevice, VmaAllocator aAllocator, VkDescriptorPool aPool, VkDescriptorSetLayout aSetLayout, size_t aSlotCount, size_t aStagingBytes)
+{
+    mDevice = aDevice;
+    mAllocator = aAllocator;
+    mPool = aPool;
+    mSetLayout = aSetLayout;
+
+    mStaging.resize(aSlotCount);
+    mGarbage.resize(aSlotCount);
+
+    for (Staging& staging : mStaging)
+    {
+        CreateStaging(staging, aStagingBytes);
+    }
+}
+
+void VkTextureUploader::Destroy()
+{
+    for (std::vector<Texture*>& garbage : mGarbage)
+    {
+        for (Texture* texture : garbage)
+        {
+            Release(texture);
+        }
+
+        garbage.clear();
+    }
+
+    for (Staging& staging : mStaging)
+    {
+        ReleaseStaging(staging);
+    }
+}
+
+void VkTextureUploader::BeginFrame(size_t aSlot, VkCommandBuffer aCommandBuffer)
+{
+    mSlot = aSlot;
+    mCommandBuffer = aCommandBuffer;
+    mStaging[aSlot].mUsed = 0;
+
+    for (Texture* texture : mGarbage[aSlot])
+    {
+        Release(texture);
+    }
+
+    mGarbage[aSlot].clear();
+}
+
+void VkTextureUploader::TransitionMips(VkImage aImage, uint32_t aBaseMip, uint32_t aMipCount, VkImageLayout aOldLayout, VkImageLayout aNewLayout,
+    VkPipelineStageFlags aSourceStage, VkAccessFlags aSourceAccess, VkPipelineStageFlags aDestinationStage, VkAccessFlags aDestinationAccess)
+{
+    VkImageMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask = aSourceAccess;
+    barrier.dstAccessMask = aDestinationAccess;
+    barrier.oldLayout = aOldLayout;
+    barrier.newLayout = aNewLayout;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = aImage;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = aBaseMip;
+    barrier.subresourceRange.levelCount = aMipCount;
+    barrier.subresourceRange.layerCount = 1;
+
+    vkCmdPipelineBarrier(mCommandBuffer, aSourceStage, aDestinationStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+uint64_t VkTextureUploader::CreateTexture(uint32_t aWidth, uint32_t aHeight, uint32_t aMipCount)
+{
+    Texture* texture = new Texture{};
+
+    VkImageCreateInfo image_info = {};
+    image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    image_info.imageType = VK_IMAGE_TYPE_2D;
+    image_info.format = VK_FORMAT_R8G8B8A8_UNORM;
+    image_info.extent = { aWidth, aHeight, 1 };
+    image_info.mipLevels = aMipCount;
+    image_info.arrayLayers = 1;
+    image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+    image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+    image_info.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    VmaAllocationCreateInfo allocation_info = {};
+    allocation_info.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
+
+    VmaAllocationInfo allocated = {};
+    if (VK_SUCCESS != vmaCreateImage(mAllocator, &image_info, &allocation_info, &texture->mImage, &texture->mAllocation, &allocated))
+    {
+        delete texture;
+        return 0;
+    }
+
+    texture->mBytes = allocated.size;
+    texture->mFinestMip = aMipCount;
+
+    VkImageViewCreateInfo view_info = {};
+    view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    view_info.image = texture->mImage;
+    view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    view_info.format = image_info.format;
+    view_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    view_info.subresourceRange.levelCount = aMipCount;
+    view_info.subresourceRange.layerCount = 1;
+
+    VkDescriptorSetAllocateInfo set_info = {};
+    set_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    set_info.descriptorPool = mPool;
+    set_info.descriptorSetCount = 1;
+    set_info.pSetLayouts = &mSetLayout;
+
+    if ((VK_SUCCESS != vkCreateImageView(mDevice, &view_info, mDevice.allocation_callbacks, &texture->mView))
+        || (VK_SUCCESS != vkAllocateDescriptorSets(mDevice, &set_info, &texture->mSet)))
+    {
+        // Never recorded into anything, so it can go right away.
+        Release(texture);
+        return 0;
+    }
+
+    VkDescriptorImageInfo descriptor_image = {};
+    descriptor_image.imageView = texture->mView;
+    descriptor_image.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    VkWriteDescriptorSet write = {};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = texture->mSet;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.pImageInfo = &descriptor_image;
+    vkUpdateDescriptorSets(mDevice, 1, &write, 0, nullptr);
+
+    // Every mip is in the layout the descriptor says from the start, mips that haven't
+    // arrived are undefined but never sampled.
+    TransitionMips(texture->mImage, 0, aMipCount, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0);
+
+    mTextureBytes += texture->mBytes;
+    return (uint64_t)(uintptr_t)texture;
+}
+
+bool VkTextureUploader::UploadMip(uint64_t aTexture, uint32_t aLevel, uint32_t aWidth, uint32_t aHeight, const uint8_t* aPixels)
+{
+    Texture* texture = (Texture*)(uintptr_t)aTexture;
+    Staging& staging = mStaging[mSlot];
+    size_t bytes = (size_t)aWidth * aHeight * 4;
+
+    // Copies need offsets that are a multiple of the texel size, 16 covers any format.
+    size_t offset = (staging.mUsed + 15) & ~(size_t)15;
+    if ((offset + bytes) > staging.mCapacity)
+    {
+        if (0 != staging.mUsed)
+        {
+            return false;
+        }
+
+        // Nothing in it yet and the mip still doesn't fit. The slot's last frame is done,
+        // so the buffer can be swapped for a big enough one right away.
+        ReleaseStaging(staging);
+        if (!CreateStaging(staging, bytes))
+        {
+            return false;
+        }
+
+        offset = 0;
+    }
+
+    memcpy(staging.mData + offset, aPixels, bytes);
+    vmaFlushAllocation(mAllocator, staging.mAllocation, offset, bytes);
+    staging.mUsed = offset + bytes;
+
+    // The old contents of the mip are thrown away, but reads of it from earlier frames still
+    // have to be done before the copy writes to it.
+    TransitionMips(texture->mImage, aLevel, 1, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+
+    VkBufferImageCopy region = {};
+    region.bufferOffset = offset;
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = aLevel;
+    region.imageSubresource.layerCount = 1;
+    region.imageExtent = { aWidth, aHeight, 1 };
+    vkCmdCopyBufferToImage(mCommandBuffer, staging.mBuffer, texture->mImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+    TransitionMips(texture->mImage, aLevel, 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+
+    texture->mFinestMip = aLevel;
+    return true;
+}
+
+void VkTextureUploader::DestroyTexture(uint64_t aTexture)
+{
+    Texture* texture = (Texture*)(uintptr_t)aTexture;
+    mTextureBytes -= texture->mBytes;
+
+    // Frames in flight may still be drawing it.
+    mGarbage[mSlot].push_back(texture);
+}
+
+void VkTextureUploader::Release(Texture* aTexture)
+{
+    if (VK_NULL_HANDLE != aTexture->mSet)
+    {
+        vkFreeDescriptorSets(mDevice, mPool, 1, &aTexture->mSet);
+    }
+
+    if (VK_NULL_HANDLE != aTexture->mView)
+    {
+        vkDestroyImageView(mDevice, aTexture->mView, mDevice.allocation_callbacks);
+    }
+
+    vmaDestroyImage(mAllocator, aTexture->mImage, aTexture->mAllocation);
+    delete aTexture;
+}
+
+VkDescriptorSet VkTextureUploader::GetDescriptorSet(uint64_t aTexture)
+{
+    return ((Texture*)(uintptr_t)aTexture)->mSet;
+}
+
+float VkTextureUploader::GetMinLod(uint64_t aTexture)
+{
+    return (float)((Texture*)(uintptr_t)aTexture)->mFinestMip;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "vulkan/vulkan.h"
+
+#include "vk_mem_alloc.h"
+
+#include "VkBootstrap.h"
+
+#include "Renderers/TextureStreamer.hpp"
+
+// Uploads into device local images through a host visible staging buffer per frame slot,
+// with the copies recorded into the frame's own command buffer ahead of its render pass.
+// Images are created with their whole mip chain, and each draw is told the finest mip that's
+// arrived so it never samples one that hasn't. Everything a slot's frame used, staging and
+// destroyed textures alike, is only reused or freed once that slot comes around again,
+// by which point the renderer has waited for the frame.
+class VkTextureUploader : public TextureUploader
+{
+public:
+    // Textures are bound through a set of aSetLayout, whose only binding is a combined image
+    // sampler with an immutable sampler.
+    void Initialize(vkb::Device aDevice, VmaAllocator aAllocator, VkDescriptorPool aPool, VkDescriptorSetLayout aSetLayout, size_t aSlotCount, size_t aStagingBytes);
+
+    // Frees the staging and every destroyed texture. Nothing may be in flight, and the
+    // streamer has to have given its textures back already.
+    void Destroy();
+
+    // Uploads until the next BeginFrame are recorded into aCommandBuffer, outside of any
+    // render pass. The frame last recorded for aSlot has to be done.
+    void BeginFrame(size_t aSlot, VkCommandBuffer aCommandBuffer);
+
+    uint64_t CreateTexture(uint32_t aWidth, uint32_t aHeight, uint32_t aMipCount) override;
+    bool UploadMip(uint64_t aTexture, uint32_t aLevel, uint32_t aWidth, uint32_t aHeight, const uint8_t* aPixels) override;
+    void DestroyTexture(uint64_t aTexture) override;
+
+    static VkDescriptorSet GetDescriptorSet(uint64_t aTexture);
+
+    // The finest mip level that's been uploaded, the least level of detail to sample at.
+    static float GetMinLod(uint64_t aTexture);
+
+    uint64_t TextureBytes() const { return mTextureBytes; }
+    uint64_t StagingBytes() const;
+
+private:
+    struct Texture
+    {
+        VkImage mImage = VK_NULL_HANDLE;
+        VmaAllocation mAllocation = VK_NULL_HANDLE;
+        VkImageView mView = VK_NULL_HANDLE;
+        VkDescriptorSet mSet = VK_NULL_HANDLE;
+        uint32_t mFinestMip = 0;
+        uint64_t mBytes = 0;
+    };
+
+    struct Staging
+    {
+        VkBuffer mBuffer = VK_NULL_HANDLE;
+        VmaAllocation mAllocation = VK_NULL_HANDLE;
+        uint8_t* mData = nullptr;
+        size_t mCapacity = 0;
+        size_t mUsed = 0;
+    };
+
+    bool CreateStaging(Staging& aStaging, size_t aCapacity);
+    void ReleaseStaging(Staging& aStaging);
+    void Release(Texture* aTexture);
+    void TransitionMips(VkImage aImage, uint32_t aBaseMip, uint32_t aMipCount, VkImageLayout aOldLayout, VkImageLayout aNewLayout,
+        VkPipelineStageFlags aSourceStage, VkAccessFlags aSourceAccess, VkPipelineStageFlags aDestinationStage, VkAccessFlags aDestinationAccess);
+
+    vkb::Device mDevice;
+    VmaAllocator mAllocator = VK_NULL_HANDLE;
+    VkDescriptorPool mPool = VK_NULL_HANDLE;
+    VkDescriptorSetLayout mSetLayout = VK_NULL_HANDLE;
+
+    std::vector<Staging> mStaging;
+    std::vector<std::vector<Texture*>> mGarbage;
+    size_t mSlot = 0;
+    VkCommandBuffer mCommandBuffer = VK_NULL_HANDLE;
+
+    uint64_t mTextureBytes = 0;
+};
@@ -0,0 +1,19 @@
+#version 450
+
+layout(push_constant) uniform Push
+{
+    vec4 uRect;
+    float uMinLod;
+} pc;
+
+layout(set = 0, binding = 0) uniform sampler2D uImage;
+
+layout(location = 0) in vec2 vUv;
+layout(location = 0) out vec4 oColor;
+
+void main()
+{
+    // Mips finer than uMinLod haven't been uploaded yet, clamp to what's there.
+    float lod = max(textureQueryLod(uImage, vUv).y, pc.uMinLod);
+    oColor = textureLod(uImage, vUv, lod);
+}
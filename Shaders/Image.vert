@@ -0,0 +1,18 @@
+#version 450
+
+layout(push_constant) uniform Push
+{
+    // Left, top, right and bottom in clip space.
+    vec4 uRect;
+    float uMinLod;
+} pc;
+
+layout(location = 0) out vec2 vUv;
+
+void main()
+{
+    // A four vertex strip, corners in the order (0, 0), (1, 0), (0, 1), (1, 1).
+    vec2 corner = vec2(gl_VertexIndex & 1, gl_VertexIndex >> 1);
+    vUv = corner;
+    gl_Position = vec4(mix(pc.uRect.xy, pc.uRect.zw, corner), 0.0, 1.0);
+}
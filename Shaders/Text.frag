@@ -0,0 +1,14 @@
+#version 450
+
+layout(set = 0, binding = 0) uniform sampler2D uAtlas;
+
+layout(location = 0) in vec2 vUv;
+layout(location = 1) in vec4 vColor;
+layout(location = 0) out vec4 oColor;
+
+void main()
+{
+    // Premultiplied, the atlas only holds coverage.
+    float alpha = vColor.a * texture(uAtlas, vUv).r;
+    oColor = vec4(vColor.rgb * alpha, alpha);
+}
@@ -0,0 +1,17 @@
+#version 450
+
+// One GlyphQuad per instance, normalized with y down, which is how Vulkan's clip space is.
+layout(location = 0) in vec4 aRect;
+layout(location = 1) in vec4 aUv;
+layout(location = 2) in vec4 aColor;
+
+layout(location = 0) out vec2 vUv;
+layout(location = 1) out vec4 vColor;
+
+void main()
+{
+    vec2 corner = vec2(gl_VertexIndex & 1, gl_VertexIndex >> 1);
+    vUv = mix(aUv.xy, aUv.zw, corner);
+    vColor = aColor;
+    gl_Position = vec4(mix(aRect.xy, aRect.zw, corner) * 2.0 - 1.0, 0.0, 1.0);
+}
@@ -0,0 +1,19 @@
+#version 450
+
+layout(location = 0) out vec4 FragColor;
+
+#ifdef PUSH_CONSTANT_COLOR
+layout(push_constant) uniform PushConstants
+{
+    vec4 uColor;
+} pc;
+#endif
+
+void main()
+{
+#ifdef PUSH_CONSTANT_COLOR
+    FragColor = pc.uColor;
+#else
+    FragColor = vec4(1.0f, 0.5f, 0.2f, 1.0f);
+#endif
+}
@@ -0,0 +1,9 @@
+#version 450
+
+layout(location = 0) in vec3 aPos;
+
+void main()
+{
+    // Vulkan's clip space has y pointing down, flip it so we match the GL and D3D panels.
+    gl_Position = vec4(aPos.x, -aPos.y, aPos.z, 1.0);
+}
@@ -0,0 +1,141 @@
+// Builds an asset pack, see Utilities/AssetPack.hpp for the format. Run by the build as:
+//   AssetPacker <output> <name>=<file> [<name>=<file>...]
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "Utilities/AssetPack.hpp"
+
+struct Input
+{
+    std::string mName;
+    std::vector<uint8_t> mBytes;
+};
+
+static bool readFile(const char* aPath, std::vector<uint8_t>& aBytes)
+{
+    FILE* file = fopen(aPath, "rb");
+    if (nullptr == file)
+    {
+        return false;
+    }
+
+    uint8_t buffer[64 * 1024];
+    size_t read = 0;
+    while (0 != (read = fread(buffer, 1, sizeof(buffer), file)))
+    {
+        aBytes.insert(aBytes.end(), buffer, buffer + read);
+    }
+
+    bool failed = ferror(file);
+    fclose(file);
+    return !failed;
+}
+
+static uint64_t alignUp(uint64_t aOffset, uint64_t aAlignment)
+{
+    return (aOffset + aAlignment - 1) / aAlignment * aAlignment;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        printf("Usage: %s <output> <name>=<file> [<name>=<file>...]\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<Input> inputs;
+    for (int i = 2; i < argc; ++i)
+    {
+        const char* separator = strchr(argv[i], '=');
+        if (nullptr == separator)
+        {
+            printf("Expected <name>=<file>, got %s\n", argv[i]);
+            return 1;
+        }
+
+        Input input;
+        input.mName.assign(argv[i], (size_t)(separator - argv[i]));
+        if (input.mName.empty() || (AssetPackEntry::cMaxName < input.mName.size()))
+        {
+            printf("Asset names have to be 1 to %zu characters, got \"%s\"\n", AssetPackEntry::cMaxName, input.mName.c_str());
+            return 1;
+        }
+
+        if (!readFile(separator + 1, input.mBytes))
+        {
+            printf("Couldn't read %s\n", separator + 1);
+            return 1;
+        }
+
+        inputs.push_back(std::move(input));
+    }
+
+    // The index is binary searched, so it has to be sorted and names have to be unique.
+    std::sort(inputs.begin(), inputs.end(), [](const Input& aLeft, const Input& aRight)
+    {
+        return aLeft.mName < aRight.mName;
+    });
+
+    for (size_t i = 1; i < inputs.size(); ++i)
+    {
+        if (inputs[i - 1].mName == inputs[i].mName)
+        {
+            printf("%s is packed twice\n", inputs[i].mName.c_str());
+            return 1;
+        }
+    }
+
+    std::vector<AssetPackEntry> entries(inputs.size());
+    uint64_t offset = sizeof(AssetPackHeader);
+    for (size_t i = 0; i < inputs.size(); ++i)
+    {
+        AssetPackEntry& entry = entries[i];
+        memset(&entry, 0, sizeof(entry));
+        memcpy(entry.mName, inputs[i].mName.data(), inputs[i].mName.size());
+
+        offset = alignUp(offset, AssetPack::cAlignment);
+        entry.mOffset = offset;
+        entry.mSize = inputs[i].mBytes.size();
+        entry.mHash = AssetPack::Hash(inputs[i].mBytes);
+        offset += entry.mSize;
+    }
+
+    AssetPackHeader header = {};
+    memcpy(header.mMagic, AssetPackHeader::cMagic, sizeof(header.mMagic));
+    header.mVersion = AssetPackHeader::cVersion;
+    header.mEntryCount = (uint32_t)entries.size();
+    header.mIndexOffset = alignUp(offset, alignof(AssetPackEntry));
+
+    std::vector<uint8_t> pack(header.mIndexOffset + entries.size() * sizeof(AssetPackEntry), 0);
+    memcpy(pack.data(), &header, sizeof(header));
+    for (size_t i = 0; i < inputs.size(); ++i)
+    {
+        memcpy(pack.data() + entries[i].mOffset, inputs[i].mBytes.data(), inputs[i].mBytes.size());
+    }
+
+    memcpy(pack.data() + header.mIndexOffset, entries.data(), entries.size() * sizeof(AssetPackEntry));
+
+    FILE* output = fopen(argv[1], "wb");
+    if (nullptr == output)
+    {
+        printf("Couldn't create %s\n", argv[1]);
+        return 1;
+    }
+
+    bool written = (pack.size() == fwrite(pack.data(), 1, pack.size(), output));
+    written = (0 == fclose(output)) && written;
+    if (!written)
+    {
+        printf("Couldn't write %s\n", argv[1]);
+        remove(argv[1]);
+        return 1;
+    }
+
+    return 0;
+}
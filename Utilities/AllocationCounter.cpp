@@ -0,0 +1,151 @@
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#include "SDL3/SDL.h"
+
+#include "Utilities/AllocationCounter.hpp"
+
+static thread_local AllocationCounts tCounts;
+
+static void Count(size_t aBytes)
+{
+    ++tCounts.mAllocations;
+    tCounts.mBytes += aBytes;
+}
+
+AllocationCounts GetThreadAllocationCounts()
+{
+    return tCounts;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// SDL:
+static SDL_malloc_func gSdlMalloc = nullptr;
+static SDL_calloc_func gSdlCalloc = nullptr;
+static SDL_realloc_func gSdlRealloc = nullptr;
+static SDL_free_func gSdlFree = nullptr;
+
+static void* SDLCALL CountingMalloc(size_t aBytes)
+{
+    Count(aBytes);
+    return gSdlMalloc(aBytes);
+}
+
+static void* SDLCALL CountingCalloc(size_t aCount, size_t aSize)
+{
+    Count(aCount * aSize);
+    return gSdlCalloc(aCount, aSize);
+}
+
+static void* SDLCALL CountingRealloc(void* aMemory, size_t aBytes)
+{
+    Count(aBytes);
+    return gSdlRealloc(aMemory, aBytes);
+}
+
+void InstallSdlAllocationHooks()
+{
+    SDL_GetOriginalMemoryFunctions(&gSdlMalloc, &gSdlCalloc, &gSdlRealloc, &gSdlFree);
+
+    if (!SDL_SetMemoryFunctions(CountingMalloc, CountingCalloc, CountingRealloc, gSdlFree))
+    {
+        printf("SDL Error: %s\n", SDL_GetError());
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////
+// Global operator new/delete:
+static void* Allocate(size_t aBytes)
+{
+    Count(aBytes);
+    return std::malloc((0 == aBytes) ? 1 : aBytes);
+}
+
+static void* AllocateAligned(size_t aBytes, std::align_val_t aAlignment)
+{
+    Count(aBytes);
+
+    size_t alignment = (size_t)aAlignment;
+    size_t bytes = (0 == aBytes) ? 1 : aBytes;
+
+#if defined(_WIN32)
+    return _aligned_malloc(bytes, alignment);
+#else
+    // aligned_alloc wants a size that's a multiple of the alignment.
+    return std::aligned_alloc(alignment, (bytes + alignment - 1) & ~(alignment - 1));
+#endif
+}
+
+static void FreeAligned(void* aMemory)
+{
+#if defined(_WIN32)
+    _aligned_free(aMemory);
+#else
+    std::free(aMemory);
+#endif
+}
+
+void* operator new(size_t aBytes)
+{
+    if (void* memory = Allocate(aBytes))
+    {
+        return memory;
+    }
+
+    throw std::bad_alloc{};
+}
+
+void* operator new[](size_t aBytes)
+{
+    return operator new(aBytes);
+}
+
+void* operator new(size_t aBytes, const std::nothrow_t&) noexcept
+{
+    return Allocate(aBytes);
+}
+
+void* operator new[](size_t aBytes, const std::nothrow_t&) noexcept
+{
+    return Allocate(aBytes);
+}
+
+void* operator new(size_t aBytes, std::align_val_t aAlignment)
+{
+    if (void* memory = AllocateAligned(aBytes, aAlignment))
+    {
+        return memory;
+    }
+
+    throw std::bad_alloc{};
+}
+
+void* operator new[](size_t aBytes, std::align_val_t aAlignment)
+{
+    return operator new(aBytes, aAlignment);
+}
+
+void* operator new(size_t aBytes, std::align_val_t aAlignment, const std::nothrow_t&) noexcept
+{
+    return AllocateAligned(aBytes, aAlignment);
+}
+
+void* operator new[](size_t aBytes, std::align_val_t aAlignment, const std::nothrow_t&) noexcept
+{
+    return AllocateAligned(aBytes, aAlignment);
+}
+
+void operator delete(void* aMemory) noexcept { std::free(aMemory); }
+void operator delete[](void* aMemory) noexcept { std::free(aMemory); }
+void operator delete(void* aMemory, size_t) noexcept { std::free(aMemory); }
+void operator delete[](void* aMemory, size_t) noexcept { std::free(aMemory); }
+void operator delete(void* aMemory, const std::nothrow_t&) noexcept { std::free(aMemory); }
+void operator delete[](void* aMemory, const std::nothrow_t&) noexcept { std::free(aMemory); }
+
+void operator delete(void* aMemory, std::align_val_t) noexcept { FreeAligned(aMemory); }
+void operator delete[](void* aMemory, std::align_val_t) noexcept { FreeAligned(aMemory); }
+void operator delete(void* aMemory, size_t, std::align_val_t) noexcept { FreeAligned(aMemory); }
+void operator delete[](void* aMemory, size_t, std::align_val_t) noexcept { FreeAligned(aMemory); }
+void operator delete(void* aMemory, std::align_val_t, const std::nothrow_t&) noexcept { FreeAligned(aMemory); }
+void operator delete[](void* aMemory, std::align_val_t, const std::nothrow_t&) noexcept { FreeAligned(aMemory); }
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+
+struct AllocationCounts
+{
+    uint64_t mAllocations = 0;
+    uint64_t mBytes = 0;
+};
+
+// Heap allocations made so far on the calling thread, through global operator new or, once
+// InstallSdlAllocationHooks has run, SDL's allocator. Take a reading before and after
+// something to see what it allocated. Only covers this module, libraries with their own
+// allocator (Qt, drivers) aren't seen. Pool tasks run on other threads aren't seen either,
+// the ones a ThreadPool::Wait runs on this thread are, and those are always from the
+// group being waited on.
+AllocationCounts GetThreadAllocationCounts();
+
+// Routes SDL_malloc, SDL_calloc and SDL_realloc through the counters. Has to run before SDL
+// allocates anything, so before SDL_Init.
+void InstallSdlAllocationHooks();
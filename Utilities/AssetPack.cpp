@@ -0,0 +1,232 @@
+#include "Utilities/AssetPack.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+uint64_t AssetPack::Hash(std::span<const uint8_t> aBytes)
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (uint8_t byte : aBytes)
+    {
+        hash ^= byte;
+        hash *= 0x100000001b3ull;
+    }
+
+    return hash;
+}
+
+AssetPack& AssetPack::Mounted()
+{
+    static AssetPack pack;
+    return pack;
+}
+
+AssetPack::~AssetPack()
+{
+    Close();
+}
+
+bool AssetPack::Open(const char* aPath)
+{
+    Close();
+
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(aPath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (INVALID_HANDLE_VALUE == file)
+    {
+        printf("Couldn't open asset pack %s\n", aPath);
+        return false;
+    }
+
+    LARGE_INTEGER size = {};
+    HANDLE mapping = nullptr;
+    if (GetFileSizeEx(file, &size) && (0 != size.QuadPart))
+    {
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    }
+
+    if (nullptr == mapping)
+    {
+        printf("Couldn't map asset pack %s\n", aPath);
+        CloseHandle(file);
+        return false;
+    }
+
+    mFile = file;
+    mMapping = mapping;
+    mData = (const uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    mSize = (size_t)size.QuadPart;
+#else
+    int file = open(aPath, O_RDONLY);
+    if (-1 == file)
+    {
+        printf("Couldn't open asset pack %s\n", aPath);
+        return false;
+    }
+
+    // The mapping keeps the file alive, the descriptor isn't needed past this.
+    struct stat status = {};
+    void* data = MAP_FAILED;
+    if ((0 == fstat(file, &status)) && (0 != status.st_size))
+    {
+        data = mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    }
+
+    close(file);
+
+    if (MAP_FAILED != data)
+    {
+        mData = (const uint8_t*)data;
+        mSize = (size_t)status.st_size;
+    }
+#endif
+
+    if (nullptr == mData)
+    {
+        printf("Couldn't map asset pack %s\n", aPath);
+        Close();
+        return false;
+    }
+
+    // Everything below only reads the header and index, so a bad pack costs a page or two.
+    AssetPackHeader header = {};
+    if (mSize < sizeof(header))
+    {
+        printf("Asset pack %s is truncated\n", aPath);
+        Close();
+        return false;
+    }
+
+    memcpy(&header, mData, sizeof(header));
+    if ((0 != memcmp(header.mMagic, AssetPackHeader::cMagic, sizeof(header.mMagic))) || (AssetPackHeader::cVersion != header.mVersion))
+    {
+        printf("%s isn't a version %u asset pack\n", aPath, AssetPackHeader::cVersion);
+        Close();
+        return false;
+    }
+
+    uint64_t indexBytes = (uint64_t)header.mEntryCount * sizeof(AssetPackEntry);
+    if ((header.mIndexOffset > mSize) || (indexBytes > (mSize - header.mIndexOffset)) || (0 != (header.mIndexOffset % alignof(AssetPackEntry))))
+    {
+        printf("Asset pack %s has a bad index\n", aPath);
+        Close();
+        return false;
+    }
+
+    mEntries = { (const AssetPackEntry*)(mData + header.mIndexOffset), header.mEntryCount };
+
+    for (size_t i = 0; i < mEntries.size(); ++i)
+    {
+        const AssetPackEntry& entry = mEntries[i];
+        bool inBounds = (entry.mOffset <= header.mIndexOffset) && (entry.mSize <= (header.mIndexOffset - entry.mOffset));
+        bool sorted = (0 == i) || (Name(mEntries[i - 1]) < Name(entry));
+
+        if (!inBounds || !sorted || (0 != (entry.mOffset % cAlignment)))
+        {
+            printf("Asset pack %s has a bad index entry %zu\n", aPath, i);
+            Close();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void AssetPack::Close()
+{
+#if defined(_WIN32)
+    if (nullptr != mData)
+    {
+        UnmapViewOfFile(mData);
+    }
+
+    if (nullptr != mMapping)
+    {
+        CloseHandle(mMapping);
+    }
+
+    if (nullptr != mFile)
+    {
+        CloseHandle(mFile);
+    }
+
+    mFile = nullptr;
+    mMapping = nullptr;
+#else
+    if (nullptr != mData)
+    {
+        munmap((void*)mData, mSize);
+    }
+#endif
+
+    mData = nullptr;
+    mSize = 0;
+    mEntries = {};
+}
+
+std::string_view AssetPack::Name(const AssetPackEntry& aEntry) const
+{
+    const char* end = (const char*)memchr(aEntry.mName, '\0', AssetPackEntry::cMaxName);
+    return { aEntry.mName, end ? (size_t)(end - aEntry.mName) : AssetPackEntry::cMaxName };
+}
+
+std::span<const uint8_t> AssetPack::Find(std::string_view aName) const
+{
+    auto it = std::lower_bound(mEntries.begin(), mEntries.end(), aName, [this](const AssetPackEntry& aEntry, std::string_view aName)
+    {
+        return Name(aEntry) < aName;
+    });
+
+    if ((it == mEntries.end()) || (Name(*it) != aName))
+    {
+        return {};
+    }
+
+    return { mData + it->mOffset, (size_t)it->mSize };
+}
+
+bool AssetPack::Verify() const
+{
+    bool matches = true;
+    for (const AssetPackEntry& entry : mEntries)
+    {
+        if (entry.mHash != Hash({ mData + entry.mOffset, (size_t)entry.mSize }))
+        {
+            std::string_view name = Name(entry);
+            printf("Asset %.*s doesn't match its hash\n", (int)name.size(), name.data());
+            matches = false;
+        }
+    }
+
+    return matches;
+}
+
+bool AssetPack::EvictFromPageCache(const char* aPath)
+{
+#if defined(__linux__)
+    int file = open(aPath, O_RDONLY);
+    if (-1 == file)
+    {
+        return false;
+    }
+
+    bool evicted = (0 == posix_fadvise(file, 0, 0, POSIX_FADV_DONTNEED));
+    close(file);
+    return evicted;
+#else
+    (void)aPath;
+    return false;
+#endif
+}
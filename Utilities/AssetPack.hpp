@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+// A read only pack of assets that's mapped rather than read, so looking an asset up hands
+// back a view of the mapping and nothing's copied until the asset is actually used.
+//
+// The file is a header, then every payload at a cAlignment boundary, then the index sorted
+// by name. Each entry carries a 64-bit FNV-1a hash of its payload, written by the packer
+// (Tools/AssetPacker.cpp) and checked by Verify. Integers are little endian.
+
+struct AssetPackHeader
+{
+    static constexpr char cMagic[8] = { 'S', 'Q', 'A', 'P', 'A', 'C', 'K', '\0' };
+    static constexpr uint32_t cVersion = 1;
+
+    char mMagic[8];
+    uint32_t mVersion;
+    uint32_t mEntryCount;
+    uint64_t mIndexOffset;
+};
+
+struct AssetPackEntry
+{
+    static constexpr size_t cMaxName = 64;
+
+    // Null terminated unless it's exactly cMaxName long.
+    char mName[cMaxName];
+    uint64_t mOffset;
+    uint64_t mSize;
+    uint64_t mHash;
+};
+
+class AssetPack
+{
+public:
+    // Enough for SPIR-V words and any vertex format, and keeps payloads off each other's
+    // cache lines.
+    static constexpr size_t cAlignment = 64;
+
+    static uint64_t Hash(std::span<const uint8_t> aBytes);
+
+    // The pack renderers look their assets up in, opened by the host before any renderer is.
+    static AssetPack& Mounted();
+
+    AssetPack() = default;
+    ~AssetPack();
+
+    AssetPack(const AssetPack&) = delete;
+    AssetPack& operator=(const AssetPack&) = delete;
+
+    // Maps aPath and checks the header and index, payloads aren't touched.
+    bool Open(const char* aPath);
+    void Close();
+
+    bool IsOpen() const { return nullptr != mData; }
+    size_t Size() const { return mSize; }
+
+    std::span<const AssetPackEntry> Entries() const { return mEntries; }
+    std::string_view Name(const AssetPackEntry& aEntry) const;
+
+    // A view of the asset's payload in the mapping, empty if there's no such asset. Valid
+    // until the pack is closed.
+    std::span<const uint8_t> Find(std::string_view aName) const;
+
+    // Hashes every payload, which faults the whole pack in, and prints the ones that don't
+    // match their index entry.
+    bool Verify() const;
+
+    // Asks the OS to drop the file's cached pages so the next open is a cold one. Only
+    // Linux can be asked, elsewhere this returns false and the next open is likely warm.
+    static bool EvictFromPageCache(const char* aPath);
+
+private:
+    const uint8_t* mData = nullptr;
+    size_t mSize = 0;
+    std::span<const AssetPackEntry> mEntries;
+
+#if defined(_WIN32)
+    void* mFile = nullptr;
+    void* mMapping = nullptr;
+#endif
+};
@@ -0,0 +1,52 @@
+#include <algorithm>
+#include <cstdint>
+
+#include "Utilities/FrameArena.hpp"
+
+void* FrameArena::Allocate(size_t aBytes, size_t aAlignment)
+{
+    if (!mBlocks.empty())
+    {
+        Block& block = mBlocks.back();
+        uintptr_t base = reinterpret_cast<uintptr_t>(block.mData.get());
+        uintptr_t aligned = (base + mOffset + (aAlignment - 1)) & ~(uintptr_t)(aAlignment - 1);
+        size_t offset = (size_t)(aligned - base);
+
+        if ((offset + aBytes) <= block.mSize)
+        {
+            mOffset = offset + aBytes;
+            return block.mData.get() + offset;
+        }
+    }
+
+    // Doubling keeps the number of blocks in a growing frame small.
+    AddBlock(std::max({ cMinimumBlockSize, mCapacity, aBytes + aAlignment }));
+    return Allocate(aBytes, aAlignment);
+}
+
+void FrameArena::Reset()
+{
+    // Everything last frame needed, in one block, so this frame fits without growing.
+    if (mBlocks.size() > 1)
+    {
+        size_t capacity = mCapacity;
+        mBlocks.clear();
+        mCapacity = 0;
+        AddBlock(capacity);
+    }
+
+    mOffset = 0;
+    mUsedInFullBlocks = 0;
+}
+
+void FrameArena::AddBlock(size_t aSize)
+{
+    if (!mBlocks.empty())
+    {
+        mUsedInFullBlocks += mOffset;
+    }
+
+    mBlocks.push_back(Block{ std::make_unique<std::byte[]>(aSize), aSize });
+    mOffset = 0;
+    mCapacity += aSize;
+}
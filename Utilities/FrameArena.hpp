@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+// Linear allocator for data that only lives for one frame. Allocating bumps a pointer and
+// Reset throws everything away at once. Running out adds another block, and the next Reset
+// folds the blocks into one big enough for the whole frame, so once frames stop growing
+// the arena stops touching the heap.
+class FrameArena
+{
+public:
+    FrameArena() = default;
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    void* Allocate(size_t aBytes, size_t aAlignment = alignof(std::max_align_t));
+
+    // Uninitialized storage for aCount objects. Nothing allocated here is ever destroyed,
+    // so only types that don't need to be are allowed.
+    template <typename tType>
+    std::span<tType> AllocateArray(size_t aCount)
+    {
+        static_assert(std::is_trivially_destructible_v<tType>, "FrameArena never runs destructors.");
+        return { static_cast<tType*>(Allocate(sizeof(tType) * aCount, alignof(tType))), aCount };
+    }
+
+    // Invalidates everything allocated since the last Reset.
+    void Reset();
+
+    size_t BytesUsed() const { return mUsedInFullBlocks + mOffset; }
+    size_t Capacity() const { return mCapacity; }
+
+private:
+    struct Block
+    {
+        std::unique_ptr<std::byte[]> mData;
+        size_t mSize;
+    };
+
+    static constexpr size_t cMinimumBlockSize = 64 * 1024;
+
+    void AddBlock(size_t aSize);
+
+    std::vector<Block> mBlocks;
+    size_t mOffset = 0; // Into the last block.
+    size_t mUsedInFullBlocks = 0;
+    size_t mCapacity = 0;
+};
@@ -0,0 +1,70 @@
+#include "Utilities/ProcessMemory.hpp"
+
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+    #include <psapi.h>
+#elif defined(__APPLE__)
+    #include <mach/mach.h>
+    #include <sys/resource.h>
+#elif defined(__linux__)
+    #include <cstdio>
+    #include <sys/resource.h>
+    #include <unistd.h>
+#endif
+
+uint64_t GetProcessResidentBytes()
+{
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters = {};
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+        return counters.WorkingSetSize;
+    }
+#elif defined(__APPLE__)
+    mach_task_basic_info_data_t info = {};
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (KERN_SUCCESS == task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count))
+    {
+        return info.resident_size;
+    }
+#elif defined(__linux__)
+    // The second field of statm is the resident page count.
+    if (FILE* file = fopen("/proc/self/statm", "r"))
+    {
+        unsigned long long size = 0, resident = 0;
+        int read = fscanf(file, "%llu %llu", &size, &resident);
+        fclose(file);
+
+        if (2 == read)
+        {
+            return resident * (uint64_t)sysconf(_SC_PAGESIZE);
+        }
+    }
+#endif
+
+    return 0;
+}
+
+PageFaultCounts GetProcessPageFaults()
+{
+    PageFaultCounts faults;
+
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters = {};
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+        faults.mMinor = counters.PageFaultCount;
+    }
+#elif defined(__APPLE__) || defined(__linux__)
+    rusage usage = {};
+    if (0 == getrusage(RUSAGE_SELF, &usage))
+    {
+        faults.mMinor = (uint64_t)usage.ru_minflt;
+        faults.mMajor = (uint64_t)usage.ru_majflt;
+    }
+#endif
+
+    return faults;
+}
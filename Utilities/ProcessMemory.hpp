@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+
+// Resident set size of this process in bytes (working set on Windows), or 0 where we don't
+// know how to ask.
+uint64_t GetProcessResidentBytes();
+
+// Page faults this process has taken so far. Minor ones were satisfied from memory, major
+// ones had to go to disk. Windows doesn't tell them apart, so everything counts as minor
+// there, and both are 0 where we don't know how to ask.
+struct PageFaultCounts
+{
+    uint64_t mMinor = 0;
+    uint64_t mMajor = 0;
+};
+
+PageFaultCounts GetProcessPageFaults();
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Fixed capacity, lock-free, single-producer/single-consumer ring buffer. One thread may
+// Push, one (possibly different) thread may Pop/Drain, nothing else is safe.
+template <typename tType, size_t tCapacity>
+class SpscQueue
+{
+    static_assert((tCapacity & (tCapacity - 1)) == 0, "SpscQueue capacity must be a power of two.");
+
+public:
+    // Returns false and counts the drop when the queue is full.
+    bool Push(const tType& aValue)
+    {
+        size_t head = mHead.load(std::memory_order_relaxed);
+        size_t tail = mTail.load(std::memory_order_acquire);
+
+        if ((head - tail) == tCapacity)
+        {
+            mDropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        mItems[head & cMask] = aValue;
+        mHead.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Hands every item currently in the queue to aFunction in FIFO order, only touching
+    // the shared indices once for the whole batch. Returns how many items were drained.
+    template <typename tFunction>
+    size_t Drain(tFunction&& aFunction)
+    {
+        size_t tail = mTail.load(std::memory_order_relaxed);
+        size_t head = mHead.load(std::memory_order_acquire);
+
+        for (size_t i = tail; i != head; ++i)
+        {
+            aFunction(mItems[i & cMask]);
+        }
+
+        mTail.store(head, std::memory_order_release);
+        return head - tail;
+    }
+
+    bool Empty() const
+    {
+        return mHead.load(std::memory_order_acquire) == mTail.load(std::memory_order_acquire);
+    }
+
+    uint64_t Dropped() const
+    {
+        return mDropped.load(std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr size_t cMask = tCapacity - 1;
+
+    std::array<tType, tCapacity> mItems = {};
+
+    // Kept on separate cache lines so the producer and consumer don't fight over them.
+    alignas(64) std::atomic<size_t> mHead = 0;
+    alignas(64) std::atomic<size_t> mTail = 0;
+    std::atomic<uint64_t> mDropped = 0;
+};
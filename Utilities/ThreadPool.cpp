@@ -0,0 +1,317 @@
+#include <algorithm>
+
+#include "Utilities/ThreadPool.hpp"
+
+// Which pool, and which worker of it, the current thread is.
+static thread_local const ThreadPool* tCurrentPool = nullptr;
+static thread_local size_t tCurrentIndex = 0;
+
+ThreadPool::ThreadPool(size_t aThreadCount)
+{
+    if (0 == aThreadCount)
+    {
+        size_t hardwareThreads = std::thread::hardware_concurrency();
+        aThreadCount = std::max<size_t>(1, (hardwareThreads > 1) ? (hardwareThreads - 1) : 1);
+    }
+
+    mWorkers.reserve(aThreadCount);
+    for (size_t i = 0; i < aThreadCount; ++i)
+    {
+        mWorkers.push_back(std::make_unique<Worker>());
+    }
+
+    // Only start them once every queue exists, they steal from each other right away.
+    for (size_t i = 0; i < aThreadCount; ++i)
+    {
+        mWorkers[i]->mThread = std::thread([this, i]()
+        {
+            WorkerMain(i);
+        });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard lock{ mSleepMutex };
+        mStopping = true;
+    }
+    mSleepCondition.notify_all();
+
+    for (auto& worker : mWorkers)
+    {
+        worker->mThread.join();
+    }
+}
+
+ThreadPool& ThreadPool::Shared()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+size_t ThreadPool::CurrentThreadIndex() const
+{
+    return (this == tCurrentPool) ? tCurrentIndex : mWorkers.size();
+}
+
+void ThreadPool::Submit(TaskGroup& aGroup, std::function<void()> aTask)
+{
+    aGroup.mPending.fetch_add(1, std::memory_order_relaxed);
+
+    // Workers keep their own work local, everyone else spreads it around.
+    size_t index = CurrentThreadIndex();
+    if (index == mWorkers.size())
+    {
+        index = mNextQueue.fetch_add(1, std::memory_order_relaxed) % mWorkers.size();
+    }
+
+    {
+        std::lock_guard lock{ mSleepMutex };
+        mQueuedTasks.fetch_add(1, std::memory_order_release);
+        aGroup.mQueued.fetch_add(1, std::memory_order_release);
+    }
+
+    {
+        std::lock_guard lock{ mWorkers[index]->mMutex };
+        mWorkers[index]->mTasks.PushBack(Task{ std::move(aTask), &aGroup });
+    }
+
+    // Threads blocked in Wait can help too, so they get woken alongside a worker.
+    mSleepCondition.notify_one();
+    mGroupCondition.notify_all();
+}
+
+void ThreadPool::Wait(TaskGroup& aGroup)
+{
+    size_t index = CurrentThreadIndex();
+
+    while (!aGroup.Done())
+    {
+        if (TryRunOneOf(index, aGroup))
+        {
+            continue;
+        }
+
+        // Nothing to help with, the remaining tasks are running elsewhere.
+        std::unique_lock lock{ mSleepMutex };
+        mGroupCondition.wait(lock, [&aGroup]()
+        {
+            return aGroup.Done() || (0 != aGroup.mQueued.load(std::memory_order_acquire));
+        });
+    }
+}
+
+void ThreadPool::ParallelFor(size_t aCount, const std::function<void(size_t)>& aFunction)
+{
+    if (0 == aCount)
+    {
+        return;
+    }
+
+    // One task per participating thread, pulling indices off a shared counter, keeps the
+    // overhead independent of aCount and balances uneven work on its own.
+    struct Shared
+    {
+        std::atomic<size_t> mNext = 0;
+        size_t mCount;
+        const std::function<void(size_t)>& mFunction;
+    };
+
+    // Captures a single pointer, small enough for std::function to store without allocating.
+    Shared shared{ 0, aCount, aFunction };
+    auto body = [&shared]()
+    {
+        for (size_t i = shared.mNext.fetch_add(1, std::memory_order_relaxed); i < shared.mCount; i = shared.mNext.fetch_add(1, std::memory_order_relaxed))
+        {
+            shared.mFunction(i);
+        }
+    };
+
+    TaskGroup group;
+    size_t tasks = std::min(aCount, mWorkers.size() + 1) - 1;
+    for (size_t i = 0; i < tasks; ++i)
+    {
+        Submit(group, body);
+    }
+
+    body();
+    Wait(group);
+}
+
+void ThreadPool::WorkerMain(size_t aIndex)
+{
+    tCurrentPool = this;
+    tCurrentIndex = aIndex;
+
+    while (true)
+    {
+        if (TryRunOne(aIndex))
+        {
+            continue;
+        }
+
+        std::unique_lock lock{ mSleepMutex };
+        mSleepCondition.wait(lock, [this]()
+        {
+            return mStopping || (0 != mQueuedTasks.load(std::memory_order_acquire));
+        });
+
+        if (mStopping)
+        {
+            return;
+        }
+    }
+}
+
+bool ThreadPool::TryRunOne(size_t aThreadIndex)
+{
+    Task task;
+
+    bool found = ((aThreadIndex < mWorkers.size()) && PopLocal(aThreadIndex, task))
+        || Steal(aThreadIndex, task);
+
+    if (!found)
+    {
+        return false;
+    }
+
+    Run(task);
+    return true;
+}
+
+bool ThreadPool::TryRunOneOf(size_t aThreadIndex, TaskGroup& aGroup)
+{
+    // Our own queue first, where a worker's ParallelFor put its tasks, then everyone's.
+    size_t count = mWorkers.size();
+    size_t start = (aThreadIndex < count) ? aThreadIndex : 0;
+
+    for (size_t offset = 0; offset < count; ++offset)
+    {
+        Worker& worker = *mWorkers[(start + offset) % count];
+        Task task;
+
+        {
+            std::lock_guard lock{ worker.mMutex };
+            if (!worker.mTasks.TakeNewest(&aGroup, task))
+            {
+                continue;
+            }
+        }
+
+        mQueuedTasks.fetch_sub(1, std::memory_order_relaxed);
+        aGroup.mQueued.fetch_sub(1, std::memory_order_relaxed);
+        Run(task);
+        return true;
+    }
+
+    return false;
+}
+
+bool ThreadPool::PopLocal(size_t aIndex, Task& aTask)
+{
+    Worker& worker = *mWorkers[aIndex];
+    std::lock_guard lock{ worker.mMutex };
+
+    if (worker.mTasks.Empty())
+    {
+        return false;
+    }
+
+    aTask = worker.mTasks.PopBack();
+    mQueuedTasks.fetch_sub(1, std::memory_order_relaxed);
+    aTask.mGroup->mQueued.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool ThreadPool::Steal(size_t aThiefIndex, Task& aTask)
+{
+    size_t count = mWorkers.size();
+
+    for (size_t offset = 1; offset <= count; ++offset)
+    {
+        size_t victim = (aThiefIndex + offset) % count;
+        Worker& worker = *mWorkers[victim];
+        std::lock_guard lock{ worker.mMutex };
+
+        if (!worker.mTasks.Empty())
+        {
+            aTask = worker.mTasks.PopFront();
+            mQueuedTasks.fetch_sub(1, std::memory_order_relaxed);
+            aTask.mGroup->mQueued.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ThreadPool::TaskRing::PushBack(Task&& aTask)
+{
+    if (mCount == mTasks.size())
+    {
+        // Unroll into a ring twice the size, oldest first.
+        std::vector<Task> grown(std::max<size_t>(16, mTasks.size() * 2));
+        for (size_t i = 0; i < mCount; ++i)
+        {
+            grown[i] = std::move(mTasks[(mHead + i) % mTasks.size()]);
+        }
+
+        mTasks = std::move(grown);
+        mHead = 0;
+    }
+
+    mTasks[(mHead + mCount) % mTasks.size()] = std::move(aTask);
+    ++mCount;
+}
+
+ThreadPool::Task ThreadPool::TaskRing::PopBack()
+{
+    --mCount;
+    return std::move(mTasks[(mHead + mCount) % mTasks.size()]);
+}
+
+ThreadPool::Task ThreadPool::TaskRing::PopFront()
+{
+    Task task = std::move(mTasks[mHead]);
+    mHead = (mHead + 1) % mTasks.size();
+    --mCount;
+    return task;
+}
+
+bool ThreadPool::TaskRing::TakeNewest(const TaskGroup* aGroup, Task& aTask)
+{
+    for (size_t i = mCount; i-- > 0;)
+    {
+        Task& task = mTasks[(mHead + i) % mTasks.size()];
+        if (task.mGroup != aGroup)
+        {
+            continue;
+        }
+
+        aTask = std::move(task);
+
+        // Close the gap, everything newer moves down one.
+        for (size_t j = i + 1; j < mCount; ++j)
+        {
+            mTasks[(mHead + j - 1) % mTasks.size()] = std::move(mTasks[(mHead + j) % mTasks.size()]);
+        }
+
+        --mCount;
+        return true;
+    }
+
+    return false;
+}
+
+void ThreadPool::Run(Task& aTask)
+{
+    aTask.mFunction();
+
+    if (1 == aTask.mGroup->mPending.fetch_sub(1, std::memory_order_acq_rel))
+    {
+        // Take the lock so a waiter can't miss this between its check and its wait.
+        std::lock_guard lock{ mSleepMutex };
+        mGroupCondition.notify_all();
+    }
+}
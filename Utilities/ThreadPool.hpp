@@ -0,0 +1,109 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Tracks a batch of tasks so the submitter can wait on just those.
+class TaskGroup
+{
+public:
+    bool Done() const
+    {
+        return 0 == mPending.load(std::memory_order_acquire);
+    }
+
+private:
+    friend class ThreadPool;
+
+    std::atomic<size_t> mPending = 0;
+
+    // Submitted and not yet picked up by anyone, what a waiter can still help with.
+    std::atomic<size_t> mQueued = 0;
+};
+
+// Work-stealing pool. Every worker owns a deque it pushes to and pops from the back of,
+// idle workers steal from the front of everyone else's. Threads waiting on a TaskGroup
+// run that group's tasks instead of blocking, so waiting from inside a task doesn't
+// deadlock, and a waiter never ends up inside unrelated work (like another panel's frame,
+// which may want a lock the waiter holds).
+class ThreadPool
+{
+public:
+    // A thread count of 0 means one worker per hardware thread, minus the caller's.
+    explicit ThreadPool(size_t aThreadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Process wide pool shared by everything that doesn't need its own.
+    static ThreadPool& Shared();
+
+    size_t ThreadCount() const { return mWorkers.size(); }
+
+    // Index of the calling worker in [0, ThreadCount()), or ThreadCount() for any thread
+    // that isn't one of this pool's workers. Handy for per-thread resources.
+    size_t CurrentThreadIndex() const;
+
+    void Submit(TaskGroup& aGroup, std::function<void()> aTask);
+
+    // Runs aGroup's tasks until everything submitted to it has finished.
+    void Wait(TaskGroup& aGroup);
+
+    // Calls aFunction(i) for i in [0, aCount) across the pool and the calling thread.
+    void ParallelFor(size_t aCount, const std::function<void(size_t)>& aFunction);
+
+private:
+    struct Task
+    {
+        std::function<void()> mFunction;
+        TaskGroup* mGroup;
+    };
+
+    // Double ended queue on a ring buffer that only ever grows, so a steady stream of tasks
+    // doesn't keep allocating and freeing blocks the way std::deque does.
+    class TaskRing
+    {
+    public:
+        bool Empty() const { return 0 == mCount; }
+        void PushBack(Task&& aTask);
+        Task PopBack();
+        Task PopFront();
+
+        // Takes out the newest of aGroup's tasks, wherever it is in the ring.
+        bool TakeNewest(const TaskGroup* aGroup, Task& aTask);
+
+    private:
+        std::vector<Task> mTasks;
+        size_t mHead = 0;
+        size_t mCount = 0;
+    };
+
+    struct Worker
+    {
+        std::mutex mMutex;
+        TaskRing mTasks;
+        std::thread mThread;
+    };
+
+    void WorkerMain(size_t aIndex);
+    bool TryRunOne(size_t aThreadIndex);
+    bool TryRunOneOf(size_t aThreadIndex, TaskGroup& aGroup);
+    bool PopLocal(size_t aIndex, Task& aTask);
+    bool Steal(size_t aThiefIndex, Task& aTask);
+    void Run(Task& aTask);
+
+    std::vector<std::unique_ptr<Worker>> mWorkers;
+    std::atomic<size_t> mNextQueue = 0;
+    std::atomic<size_t> mQueuedTasks = 0;
+    std::mutex mSleepMutex;
+    std::condition_variable mSleepCondition;
+    std::condition_variable mGroupCondition;
+    bool mStopping = false;
+};
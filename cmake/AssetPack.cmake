@@ -0,0 +1,36 @@
+# Packs files into an asset pack with the AssetPacker tool at build time, and copies the pack
+# next to the target's executable where it's mounted from at startup.
+#
+#   add_packed_asset(<target> <name> <file>)
+#   pack_assets(<target>)
+#
+# <name> is what the asset is looked up by at runtime, see Utilities/AssetPack.hpp. Files
+# can be outputs of other custom commands, the pack is rebuilt whenever one changes.
+
+function(add_packed_asset target name file)
+    set_property(TARGET ${target} APPEND PROPERTY ASSET_PACK_FILES ${file})
+    set_property(TARGET ${target} APPEND PROPERTY ASSET_PACK_ENTRIES "${name}=${file}")
+endfunction()
+
+function(pack_assets target)
+    set(output "${CMAKE_CURRENT_BINARY_DIR}/Assets.pack")
+
+    get_property(files TARGET ${target} PROPERTY ASSET_PACK_FILES)
+    get_property(entries TARGET ${target} PROPERTY ASSET_PACK_ENTRIES)
+
+    add_custom_command(
+        OUTPUT ${output}
+        COMMAND AssetPacker ${output} ${entries}
+        DEPENDS AssetPacker ${files}
+        COMMENT "Packing assets for ${target}"
+        VERBATIM
+    )
+
+    add_custom_target(${target}_AssetPack DEPENDS ${output})
+    add_dependencies(${target} ${target}_AssetPack)
+
+    add_custom_command(TARGET ${target} POST_BUILD
+        COMMAND ${CMAKE_COMMAND} -E copy_if_different ${output} $<TARGET_FILE_DIR:${target}>
+        VERBATIM
+    )
+endfunction()
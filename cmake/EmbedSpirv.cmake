@@ -0,0 +1,42 @@
+# Script mode helper, run as:
+#   cmake -DLIST=<entries file> -DOUTPUT=<header> -P EmbedSpirv.cmake
+#
+# Each line of the entries file is "<ShaderId>|<ShaderPermutation>|<path to .spv>", and
+# every entry becomes a SpirvShader specialization holding the words as a constexpr array,
+# and the name it's packed under in the asset pack.
+
+file(STRINGS "${LIST}" entries)
+
+set(contents "// Generated by cmake/EmbedSpirv.cmake, do not edit.\n#pragma once\n\n")
+
+foreach(entry IN LISTS entries)
+    string(REPLACE "|" ";" fields "${entry}")
+    list(GET fields 0 shader_id)
+    list(GET fields 1 permutation)
+    list(GET fields 2 spirv_path)
+
+    file(READ "${spirv_path}" hex HEX)
+
+    # SPIR-V is a stream of little endian 32-bit words.
+    string(REGEX REPLACE "([0-9a-f][0-9a-f])([0-9a-f][0-9a-f])([0-9a-f][0-9a-f])([0-9a-f][0-9a-f])" "0x\\4\\3\\2\\1u, " words "${hex}")
+    string(REGEX REPLACE "((0x[0-9a-f]+u, ){8})" "\\1\n        " words "${words}")
+
+    string(APPEND contents
+        "template <>\n"
+        "struct SpirvShader<ShaderId::${shader_id}, ShaderPermutation::${permutation}>\n"
+        "{\n"
+        "    static constexpr const char* cName = \"spirv/${shader_id}.${permutation}\";\n"
+        "    static constexpr uint32_t cCode[] = {\n"
+        "        ${words}\n"
+        "    };\n"
+        "};\n\n")
+endforeach()
+
+# Only touch the header when something changed, everything including it rebuilds otherwise.
+if(EXISTS "${OUTPUT}")
+    file(READ "${OUTPUT}" existing)
+endif()
+
+if(NOT "${existing}" STREQUAL "${contents}")
+    file(WRITE "${OUTPUT}" "${contents}")
+endif()
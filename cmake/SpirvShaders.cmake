@@ -0,0 +1,63 @@
+# Compiles GLSL to SPIR-V at build time and embeds the results into a generated header, so
+# the Vulkan backend never touches a shader compiler or the filesystem at runtime.
+#
+#   add_spirv_shader(<target> <source> <ShaderId> <ShaderPermutation> [DEFINES...])
+#   embed_spirv_shaders(<target>)
+#
+# ShaderId and ShaderPermutation name enumerators in Renderers/VkShaders.hpp, each
+# permutation is compiled with its DEFINES set. Every shader is also added to the target's
+# asset pack as spirv/<ShaderId>.<ShaderPermutation>, see cmake/AssetPack.cmake.
+#
+# Needs glslc or glslangValidator, the top level only includes this once it's found one.
+
+function(add_spirv_shader target source shader_id permutation)
+    set(input "${CMAKE_CURRENT_SOURCE_DIR}/${source}")
+    get_filename_component(name "${source}" NAME)
+    set(output "${CMAKE_CURRENT_BINARY_DIR}/spirv/${name}.${permutation}.spv")
+
+    set(defines)
+    foreach(define IN LISTS ARGN)
+        list(APPEND defines "-D${define}")
+    endforeach()
+
+    if(Vulkan_GLSLC_EXECUTABLE)
+        set(command ${Vulkan_GLSLC_EXECUTABLE} ${defines} -o ${output} ${input})
+    else()
+        set(command ${Vulkan_GLSLANG_VALIDATOR_EXECUTABLE} -V ${defines} -o ${output} ${input})
+    endif()
+
+    add_custom_command(
+        OUTPUT ${output}
+        COMMAND ${CMAKE_COMMAND} -E make_directory "${CMAKE_CURRENT_BINARY_DIR}/spirv"
+        COMMAND ${command}
+        DEPENDS ${input}
+        COMMENT "Compiling ${source} (${permutation}) to SPIR-V"
+        VERBATIM
+    )
+
+    set_property(TARGET ${target} APPEND PROPERTY SPIRV_SHADER_OUTPUTS ${output})
+    set_property(TARGET ${target} APPEND PROPERTY SPIRV_SHADER_ENTRIES "${shader_id}|${permutation}|${output}")
+    add_packed_asset(${target} "spirv/${shader_id}.${permutation}" ${output})
+endfunction()
+
+function(embed_spirv_shaders target)
+    set(generated_dir "${CMAKE_CURRENT_BINARY_DIR}/generated")
+    set(list_file "${generated_dir}/SpirvShaders.list")
+    set(header "${generated_dir}/SpirvShaders.hpp")
+
+    get_property(outputs TARGET ${target} PROPERTY SPIRV_SHADER_OUTPUTS)
+    get_property(entries TARGET ${target} PROPERTY SPIRV_SHADER_ENTRIES)
+    list(JOIN entries "\n" entries)
+    file(GENERATE OUTPUT "${list_file}" CONTENT "${entries}\n")
+
+    add_custom_command(
+        OUTPUT ${header}
+        COMMAND ${CMAKE_COMMAND} -DLIST=${list_file} -DOUTPUT=${header} -P "${PROJECT_SOURCE_DIR}/cmake/EmbedSpirv.cmake"
+        DEPENDS ${outputs} ${list_file} "${PROJECT_SOURCE_DIR}/cmake/EmbedSpirv.cmake"
+        COMMENT "Embedding SPIR-V shaders"
+        VERBATIM
+    )
+
+    target_sources(${target} PRIVATE ${header})
+    target_include_directories(${target} PRIVATE ${generated_dir})
+endfunction()
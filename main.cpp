@@ -13,13 +13,55 @@
 #include "QWindow"
 #include "QTimer"
 #include "QResizeEvent"
+#include "QKeyEvent"
+#include "QMouseEvent"
+#include "QWheelEvent"
+#include "QThreadPool"
+#include "QStackedWidget"
+#include "QElapsedTimer"
+#include "QComboBox"
+#include "QCheckBox"
+#include "QTreeWidget"
+#include "QFileDialog"
+#include "QFile"
+#include "QJsonDocument"
+#include "QJsonObject"
+#include "QJsonArray"
+#include "QLocale"
+#include "QCommandLineParser"
+#include "QDir"
+#include "QFontDatabase"
+#include "QImage"
+#include "QImageReader"
+#include "QPainter"
+#include "QScreen"
+#include "QRawFont"
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "SDL3/SDL.h"
 
+#include "Renderers/GlyphAtlas.hpp"
 #include "Renderers/Renderer.hpp"
+#include "Renderers/RenderScheduler.hpp"
+#include "Renderers/TextureStreamer.hpp"
+
+#include "Utilities/AllocationCounter.hpp"
+#include "Utilities/AssetPack.hpp"
+#include "Utilities/ProcessMemory.hpp"
 
 #include "DockManager.h"
 
+#include "PanelLayout.hpp"
+
 class DockOwningMainWindow : public QMainWindow
 {
 public:
@@ -68,27 +110,253 @@ private:
 };
 
 
-    
-class QSdlWindow : public QWindow
+// Tracks how long it takes from the first panel being created to the last renderer 
+// finishing its Initialize, so we can see how close we are to the slowest backend.
+static QElapsedTimer gStartupTimer;
+static int gPendingRendererInitializations = 0;
+
+// Renders panels off the GUI thread, unless we were told to keep everything on it.
+static ThreadingModel gThreadingModel = ThreadingModel::GuiThread;
+static std::unique_ptr<RenderScheduler> gRenderScheduler;
+
+// What --images lays out, every panel draws the same grid.
+static std::vector<ImageQuad> gImages;
+
+// What --text reads, drawn over every panel.
+static std::vector<TextRun> gText;
+
+// Set by --software-widgets, SDL software renderer panels are plain widgets rather than
+// native SDL windows.
+static bool gSoftwareWidgets = false;
+
+// Routes SDL events to the panel owning the window they were sent to.
+class QSdlWindow;
+static std::unordered_map<SDL_WindowID, QSdlWindow*> gSdlWindows;
+
+// Every panel in the order they were created, whatever they're hosted in.
+class SdlPanel;
+static std::vector<SdlPanel*> gPanels;
+
+// Backends that batch frames across panels only queue them in Render, the flush is posted
+// so every panel updated in this pass of the event loop lands in the same batch.
+static void ScheduleFlushPendingPresents()
+{
+    static bool scheduled = false;
+
+    if (scheduled)
+    {
+        return;
+    }
+
+    scheduled = true;
+    QTimer::singleShot(0, []()
+    {
+        scheduled = false;
+        FlushPendingPresents();
+    });
+}
+
+static SDL_Keycode ToSdlKeycode(int aQtKey)
+{
+    if ((aQtKey >= Qt::Key_A) && (aQtKey <= Qt::Key_Z))
+    {
+        return SDLK_A + (aQtKey - Qt::Key_A);
+    }
+
+    if ((aQtKey >= Qt::Key_0) && (aQtKey <= Qt::Key_9))
+    {
+        return SDLK_0 + (aQtKey - Qt::Key_0);
+    }
+
+    if ((aQtKey >= Qt::Key_F1) && (aQtKey <= Qt::Key_F12))
+    {
+        return SDLK_F1 + (aQtKey - Qt::Key_F1);
+    }
+
+    switch (aQtKey)
+    {
+        case Qt::Key_Escape: return SDLK_ESCAPE;
+        case Qt::Key_Return:
+        case Qt::Key_Enter: return SDLK_RETURN;
+        case Qt::Key_Space: return SDLK_SPACE;
+        case Qt::Key_Tab: return SDLK_TAB;
+        case Qt::Key_Backspace: return SDLK_BACKSPACE;
+        case Qt::Key_Delete: return SDLK_DELETE;
+        case Qt::Key_Left: return SDLK_LEFT;
+        case Qt::Key_Right: return SDLK_RIGHT;
+        case Qt::Key_Up: return SDLK_UP;
+        case Qt::Key_Down: return SDLK_DOWN;
+        default: return SDLK_UNKNOWN;
+    }
+}
+
+static Uint8 ToSdlButton(Qt::MouseButton aButton)
+{
+    switch (aButton)
+    {
+        case Qt::LeftButton: return SDL_BUTTON_LEFT;
+        case Qt::MiddleButton: return SDL_BUTTON_MIDDLE;
+        case Qt::RightButton: return SDL_BUTTON_RIGHT;
+        case Qt::BackButton: return SDL_BUTTON_X1;
+        case Qt::ForwardButton: return SDL_BUTTON_X2;
+        default: return 0;
+    }
+}
+
+// One renderer shown in a dock panel. The panel's toolbar, the memory panel and the scaling
+// benchmark only go through this, so they don't care what the renderer is hosted in.
+class SdlPanel
+{
+public:
+    SdlPanel()
+    {
+        gPanels.push_back(this);
+    }
+
+    virtual ~SdlPanel()
+    {
+        gPanels.erase(std::find(gPanels.begin(), gPanels.end(), this));
+    }
+
+    // Creates the renderer, nullptr from GetRenderer afterwards means it failed.
+    virtual void Initialize() = 0;
+
+    // Keeps rendering every frame even when nothing changed, mostly so the present
+    // mode stats have something to measure.
+    virtual void SetContinuous(bool aContinuous) = 0;
+
+    // 0 when there's no SDL window.
+    virtual SDL_WindowID GetWindowId() const { return 0; }
+
+    // Called with whether the renderer's Initialize succeeded, a failed one is never drawn.
+    void SetOnInitialized(std::function<void(bool)> aCallback)
+    {
+        mOnInitialized = std::move(aCallback);
+    }
+
+    Renderer* GetRenderer()
+    {
+        return mRenderer.get();
+    }
+
+    bool IsInitialized() const
+    {
+        return mInitialized;
+    }
+
+    uint64_t GetFramesRendered()
+    {
+        auto lock = mRenderer->Lock();
+        return mRenderer->GetStats().mFramesRendered;
+    }
+
+    // Input from either Qt or the SDL event loop for this panel. Everything runs on the
+    // GUI thread, so it's the single producer for the renderer's queue.
+    void PushInput(const InputEvent& aEvent)
+    {
+        if (mRenderer)
+        {
+            mRenderer->PushInput(aEvent);
+        }
+    }
+
+protected:
+    // Qt's timestamps are on their own clock, so we stamp on arrival instead.
+    void PushKey(InputEventType aType, QKeyEvent* aEvent)
+    {
+        InputEvent event{ aType, SDL_GetTicksNS() };
+        event.mKey = ToSdlKeycode(aEvent->key());
+        PushInput(event);
+        aEvent->accept();
+    }
+
+    void PushMouse(InputEventType aType, QMouseEvent* aEvent)
+    {
+        InputEvent event{ aType, SDL_GetTicksNS() };
+        event.mButton = ToSdlButton(aEvent->button());
+        event.mX = (float)aEvent->position().x();
+        event.mY = (float)aEvent->position().y();
+        PushInput(event);
+        aEvent->accept();
+    }
+
+    void PushWheel(QWheelEvent* aEvent)
+    {
+        InputEvent event{ InputEventType::MouseWheel, SDL_GetTicksNS() };
+        event.mX = aEvent->angleDelta().x() / 120.0f;
+        event.mY = aEvent->angleDelta().y() / 120.0f;
+        PushInput(event);
+        aEvent->accept();
+    }
+
+    // Counts toward the startup timing and calls back the panel's owner.
+    void FinishInitialization(qint64 aInitializationMs, bool aSucceeded)
+    {
+        if (aSucceeded)
+        {
+            printf("%s initialized in %lld ms\n", mRenderer->Name(), aInitializationMs);
+        }
+        else
+        {
+            printf("%s failed to initialize after %lld ms\n", mRenderer->Name(), aInitializationMs);
+        }
+
+        if (0 == --gPendingRendererInitializations)
+        {
+            printf("All renderers initialized %lld ms after startup\n", gStartupTimer.elapsed());
+        }
+
+        mInitialized = aSucceeded;
+
+        if (mOnInitialized)
+        {
+            mOnInitialized(aSucceeded);
+        }
+    }
+
+    std::unique_ptr<Renderer> mRenderer;
+    std::function<void(bool)> mOnInitialized;
+    bool mInitialized = false;
+    bool mContinuous = false;
+};
+
+class QSdlWindow : public QWindow, public SdlPanel
 {
 public:
-    QSdlWindow(RendererType aType, const char* aRendererBackend)
+    QSdlWindow(RendererType aType, std::string aRendererBackend)
         : mType{ aType }
-        , mRendererBackend{ aRendererBackend }
+        , mRendererBackend{ std::move(aRendererBackend) }
     {
     }
 
-    ~QSdlWindow() override = default;
+    ~QSdlWindow() override
+    {
+        // The pool may still be initializing the renderer, which can't go away under it.
+        {
+            std::unique_lock lock{ mInitializationMutex };
+            mInitializationDone.wait(lock, [this]() { return !mInitializing; });
+        }
+
+        if (mScheduled)
+        {
+            gRenderScheduler->Remove(mRenderer.get());
+        }
+
+        if (mWindow)
+        {
+            gSdlWindows.erase(SDL_GetWindowID(mWindow));
+        }
+    }
     
 
     // GL Stuff, needs to be factored out.
 
-    void Initialize()
+    void Initialize() override
     {
         SDL_PropertiesID window_props = SDL_CreateProperties();
 
         if ((RendererType::VkRenderer == mType) || 
-            ((RendererType::SdlRenderRenderer == mType) && (strcmp(mRendererBackend, "vulkan") == 0)))
+            ((RendererType::SdlRenderRenderer == mType) && (mRendererBackend == "vulkan")))
         {
 #ifdef HAVE_VULKAN
             SDL_SetBooleanProperty(window_props, SDL_PROP_WINDOW_CREATE_VULKAN_BOOLEAN, true);
@@ -98,8 +366,8 @@ public:
         }
         else if ((RendererType::OpenGL3_3Renderer == mType)
             || (RendererType::SdlRenderRenderer == mType) && (
-            (strcmp(mRendererBackend, "opengles2") == 0)
-            || (strcmp(mRendererBackend, "opengl") == 0)))
+            (mRendererBackend == "opengles2")
+            || (mRendererBackend == "opengl")))
         {
             SDL_SetBooleanProperty(window_props, SDL_PROP_WINDOW_CREATE_OPENGL_BOOLEAN, true);
 
@@ -118,15 +386,111 @@ public:
 
         SDL_SetPointerProperty(window_props, SDL_PROP_WINDOW_CREATE_WIN32_HWND_POINTER, mWindowId);
         mWindow = SDL_CreateWindowWithProperties(window_props);
-        mRenderer = CreateRenderer(mWindow, mType, mRendererBackend);
+
+        if (mWindow)
+        {
+            gSdlWindows[SDL_GetWindowID(mWindow)] = this;
+        }
+
+        mRenderer = CreateRenderer(mWindow, mType, mRendererBackend.empty() ? nullptr : mRendererBackend.c_str());
+
+        if (!mRenderer)
+        {
+            return;
+        }
+
+        if (!gStartupTimer.isValid())
+        {
+            gStartupTimer.start();
+        }
+
+        ++gPendingRendererInitializations;
+
+        // The heavy part of renderer creation goes to the pool, the dock layout keeps showing
+        // the placeholder until we hear back on the GUI thread.
+        // The destructor waits for the task, so both pointers stay good until it's done,
+        // and Qt drops the queued call if we're gone by the time it would run.
+        Renderer* renderer = mRenderer.get();
+        mInitializing = true;
+        QThreadPool::globalInstance()->start([this, renderer]()
+        {
+            QElapsedTimer timer;
+            timer.start();
+            bool succeeded = renderer->Initialize();
+            qint64 elapsed = timer.elapsed();
+
+            QMetaObject::invokeMethod(this, [this, elapsed, succeeded]()
+            {
+                OnRendererInitialized(elapsed, succeeded);
+            }, Qt::QueuedConnection);
+
+            std::lock_guard lock{ mInitializationMutex };
+            mInitializing = false;
+            mInitializationDone.notify_all();
+        });
+    }
+
+    void OnRendererInitialized(qint64 aInitializationMs, bool aSucceeded)
+    {
+        FinishInitialization(aInitializationMs, aSucceeded);
+
+        // Never handed to the scheduler, so nothing draws it, the owner shows why.
+        if (!aSucceeded)
+        {
+            return;
+        }
+
+        // We may have been resized while the renderer was still initializing.
+        mRenderer->Resize(width(), height());
+        mRenderer->Invalidate();
+
+        // From here on the scheduler's threads draw it, we only forward window changes.
+        if (gRenderScheduler && !mRenderer->RequiresGuiThread())
+        {
+            mScheduled = true;
+            gRenderScheduler->Add(mRenderer.get());
+            gRenderScheduler->SetContinuous(mRenderer.get(), mContinuous);
+            return;
+        }
+
+        // Renderers only draw when something changed, so they tell us when that happens
+        // rather than us polling them every vsync.
+        mRenderer->SetInvalidatedCallback([this]()
+        {
+            requestUpdate();
+        });
 
         requestUpdate();
     }
 
+    SDL_WindowID GetWindowId() const override
+    {
+        return mWindow ? SDL_GetWindowID(mWindow) : 0;
+    }
+
     void Update()
     {
-        mRenderer->Update();
-        requestUpdate();
+        if (!mInitialized || mScheduled)
+        {
+            return;
+        }
+
+        if (mRenderer->Render())
+        {
+            ScheduleFlushPendingPresents();
+        }
+
+        if (mContinuous)
+        {
+            mRenderer->RequestAnimationFrame();
+        }
+
+        // Keep the frames coming only while the renderer has something left to draw,
+        // otherwise static panels sit idle until they're invalidated again.
+        if (mRenderer->NeedsRedraw())
+        {
+            requestUpdate();
+        }
     }
 
 
@@ -145,7 +509,10 @@ public:
 
     void exposeEvent(QExposeEvent*) override
     {
-        requestUpdate();
+        if (mInitialized)
+        {
+            mRenderer->Invalidate();
+        }
     }
 
     void resizeEvent(QResizeEvent* aEvent) override
@@ -153,111 +520,1335 @@ public:
         printf("ResizeEvent: {%d, %d}\n",aEvent->size().width(), aEvent->size().height());
         aEvent->accept();
 
-        if (mRenderer)
+        if (mInitialized)
         {
+            auto lock = mRenderer->Lock();
             mRenderer->Resize(aEvent->size().width(), aEvent->size().height());
+            mRenderer->Invalidate();
         }
     }
 
     void keyPressEvent(QKeyEvent* aEvent) override
     {
+        PushKey(InputEventType::KeyDown, aEvent);
+    }
 
+    void keyReleaseEvent(QKeyEvent* aEvent) override
+    {
+        PushKey(InputEventType::KeyUp, aEvent);
     }
 
-    void focusInEvent(QFocusEvent*) override
+    void mouseMoveEvent(QMouseEvent* aEvent) override
+    {
+        PushMouse(InputEventType::MouseMove, aEvent);
+    }
+
+    void mousePressEvent(QMouseEvent* aEvent) override
+    {
+        PushMouse(InputEventType::MouseButtonDown, aEvent);
+    }
+
+    void mouseReleaseEvent(QMouseEvent* aEvent) override
     {
+        PushMouse(InputEventType::MouseButtonUp, aEvent);
+    }
 
+    void wheelEvent(QWheelEvent* aEvent) override
+    {
+        PushWheel(aEvent);
     }
 
-    void focusOutEvent(QFocusEvent*) override
+    void focusInEvent(QFocusEvent*) override
     {
+        PushInput(InputEvent{ InputEventType::FocusIn, SDL_GetTicksNS() });
+    }
 
+    void focusOutEvent(QFocusEvent*) override
+    {
+        PushInput(InputEvent{ InputEventType::FocusOut, SDL_GetTicksNS() });
     }
 
-    Renderer* GetRenderer()
+    void SetContinuous(bool aContinuous) override
     {
-        return mRenderer.get();
+        mContinuous = aContinuous;
+
+        if (mScheduled)
+        {
+            gRenderScheduler->SetContinuous(mRenderer.get(), mContinuous);
+        }
+        else if (mInitialized && mContinuous)
+        {
+            mRenderer->RequestAnimationFrame();
+        }
     }
 
 private:
     SDL_Window* mWindow = nullptr;
     void* mWindowId = nullptr;
-    std::unique_ptr<Renderer> mRenderer;
+    bool mScheduled = false;
+
+    // Set while the pool runs the renderer's Initialize.
+    std::mutex mInitializationMutex;
+    std::condition_variable mInitializationDone;
+    bool mInitializing = false;
     RendererType mType;
-    const char* mRendererBackend;
+    std::string mRendererBackend;
 };
 
-
-void sdl_event_loop()
+// SDL's software renderer in a plain widget, with no native window of its own. The renderer
+// draws straight into the pixels of a QImage we keep, through an SDL_Surface wrapping them,
+// and paintEvent draws that into the top level window's backing store. That's the only copy
+// on the way to the screen, the same one every other widget costs, where a native SDL
+// window has a window surface of its own to flush and a child window for the windowing
+// system to compose, which is what hurts over remote and headless displays.
+//
+// The software renderer can't change surfaces, so ours is as big as the biggest screen and
+// the panel only ever uses its top left.
+class QSdlRasterWidget : public QWidget, public SdlPanel
 {
-    SDL_Event event;
-    while (SDL_PollEvent(&event))
+public:
+    QSdlRasterWidget()
     {
+        // Every pixel is ours, there's nothing under us Qt needs to paint first.
+        setAttribute(Qt::WA_OpaquePaintEvent);
+        setFocusPolicy(Qt::StrongFocus);
+        setMouseTracking(true);
+    }
 
+    ~QSdlRasterWidget() override
+    {
+        // The renderer draws into the surface, which points into mPixels.
+        mRenderer.reset();
+        SDL_DestroySurface(mSurface);
     }
-    
-    QTimer::singleShot(0, []()
+
+    void Initialize() override
     {
-        sdl_event_loop();
-    });
-}
+        QSize capacity;
+        for (QScreen* screen : QGuiApplication::screens())
+        {
+            capacity = capacity.expandedTo(screen->size() * screen->devicePixelRatio());
+        }
 
-void createSdlWindow(DockOwningMainWindow* aMainWindow, RendererType aType, const char* aRendererBackend, ads::DockWidgetArea aArea, color aClearColor)
-{
-    auto sdlWindow = new QSdlWindow(aType, aRendererBackend);
-    auto dockWidget = new ads::CDockWidget("", aMainWindow);
-    dockWidget->setMinimumSizeHintMode(ads::CDockWidget::MinimumSizeHintFromContent);
-    //dockWidget->setAllowedAreas(Qt::BottomDockWidgetArea | Qt::TopDockWidgetArea | Qt::LeftDockWidgetArea | Qt::RightDockWidgetArea);
-    auto sdlWidget = QWidget::createWindowContainer(sdlWindow);
-    dockWidget->setWidget(sdlWidget);
+        // Qt's RGB32 is SDL's XRGB8888, both a native endian 32 bit word per pixel.
+        mPixels = QImage(capacity.expandedTo(QSize(1, 1)), QImage::Format_RGB32);
+        mSurface = SDL_CreateSurfaceFrom(mPixels.width(), mPixels.height(), SDL_PIXELFORMAT_XRGB8888, mPixels.bits(), (int)mPixels.bytesPerLine());
+        if (nullptr == mSurface)
+        {
+            printf("SDL Error: %s\n", SDL_GetError());
+            return;
+        }
 
-    aMainWindow->GetDockManager()->addDockWidget(aArea, dockWidget);
-    sdlWidget->setMinimumSize(10, 10);
-    sdlWidget->setBaseSize(480, 320);
-    sdlWidget->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
-    sdlWindow->Initialize();
-    sdlWindow->GetRenderer()->mClearColor = aClearColor;
-    sdlWindow->GetRenderer()->mTriangleColor = { 0x00, 0x00, 0xFF, 0xFF };
-    sdlWidget->setWindowTitle(sdlWindow->GetRenderer()->Name());
-    dockWidget->setWindowTitle(sdlWindow->GetRenderer()->Name());
-}
+        mRenderer = CreateSdlSurfaceRenderer(mSurface);
 
-int main(int argc, char *argv[])
-{
-    if (!SDL_Init(SDL_INIT_VIDEO))
+        if (!gStartupTimer.isValid())
+        {
+            gStartupTimer.start();
+        }
+
+        ++gPendingRendererInitializations;
+
+        // Nothing to do off the GUI thread, but our owner only sets us up once we return.
+        QTimer::singleShot(0, this, [this]()
+        {
+            QElapsedTimer timer;
+            timer.start();
+            bool succeeded = mRenderer->Initialize();
+            FinishInitialization(timer.elapsed(), succeeded);
+
+            if (!succeeded)
+            {
+                return;
+            }
+
+            ResizeRenderer();
+            mRenderer->SetInvalidatedCallback([this]()
+            {
+                update();
+            });
+            update();
+        });
+    }
+
+    void SetContinuous(bool aContinuous) override
     {
-        printf( "SDL could not initialize! SDL_Error: %s\n", SDL_GetError() );
+        mContinuous = aContinuous;
+
+        if (mInitialized && mContinuous)
+        {
+            mRenderer->RequestAnimationFrame();
+        }
     }
 
-    QApplication app(argc, argv);
+protected:
+    void paintEvent(QPaintEvent*) override
+    {
+        QPainter painter(this);
+        if (!mInitialized)
+        {
+            painter.fillRect(rect(), Qt::black);
+            return;
+        }
 
-    // Make a window. This type has support for docking and gives a 
-    // central window in the middle of the docking panels that doesn't move.
-    auto window = new DockOwningMainWindow;
-    //window->setCentralWidget(nullptr);
-    //auto centralWidget = new QWidget();
-    //window->setCentralWidget(centralWidget);
-    //window->centralWidget()->setBaseSize(0, 0);
-    //window->centralWidget()->setMinimumSize(0, 0);
-    //window->centralWidget()->setMaximumSize(0,0);
-    //window->centralWidget()->hide();
+        mRenderer->Render();
 
-    // Enables "infinite docking".
-    window->setDockNestingEnabled(true);
+        if (mContinuous)
+        {
+            mRenderer->RequestAnimationFrame();
+        }
 
-    // Sets the default window size.
-    window->resize(850, 700);
+        // Wraps the part of mPixels that's the panel, without copying.
+        QImage frame(mPixels.constBits(), mFrameSize.width(), mFrameSize.height(), mPixels.bytesPerLine(), QImage::Format_RGB32);
+        qreal ratio = devicePixelRatioF();
+        QRectF target(0.0, 0.0, mFrameSize.width() / ratio, mFrameSize.height() / ratio);
+        painter.drawImage(target, frame);
 
-    //// Used to store widgets in the central widget.
-    //auto centralTabs = new QTabWidget;
-    //window->setCentralWidget(centralTabs);
-    //
-    //// Adding a menuTab layer for menu options.
-    //auto menuTabs = new QMenuBar(centralTabs);
-    //window->setMenuBar(menuTabs);
-    //
-    //// Adding a toolTab layer for tools options.
-    //auto toolTabs = new QToolBar(centralTabs);
+        // Only when we're bigger than any screen.
+        QRegion uncovered = QRegion(rect()) - QRegion(target.toAlignedRect());
+        for (const QRect& area : uncovered)
+        {
+            painter.fillRect(area, Qt::black);
+        }
+
+        // Asking for a repaint from inside one isn't reliable, so the next frame is queued.
+        if (mRenderer->NeedsRedraw())
+        {
+            QMetaObject::invokeMethod(this, [this]()
+            {
+                update();
+            }, Qt::QueuedConnection);
+        }
+    }
+
+    void resizeEvent(QResizeEvent* aEvent) override
+    {
+        aEvent->accept();
+
+        if (mInitialized)
+        {
+            ResizeRenderer();
+        }
+    }
+
+    void keyPressEvent(QKeyEvent* aEvent) override
+    {
+        PushKey(InputEventType::KeyDown, aEvent);
+    }
+
+    void keyReleaseEvent(QKeyEvent* aEvent) override
+    {
+        PushKey(InputEventType::KeyUp, aEvent);
+    }
+
+    void mouseMoveEvent(QMouseEvent* aEvent) override
+    {
+        PushMouse(InputEventType::MouseMove, aEvent);
+    }
+
+    void mousePressEvent(QMouseEvent* aEvent) override
+    {
+        PushMouse(InputEventType::MouseButtonDown, aEvent);
+    }
+
+    void mouseReleaseEvent(QMouseEvent* aEvent) override
+    {
+        PushMouse(InputEventType::MouseButtonUp, aEvent);
+    }
+
+    void wheelEvent(QWheelEvent* aEvent) override
+    {
+        PushWheel(aEvent);
+    }
+
+    void focusInEvent(QFocusEvent*) override
+    {
+        PushInput(InputEvent{ InputEventType::FocusIn, SDL_GetTicksNS() });
+    }
+
+    void focusOutEvent(QFocusEvent*) override
+    {
+        PushInput(InputEvent{ InputEventType::FocusOut, SDL_GetTicksNS() });
+    }
+
+private:
+    // The renderer works in device pixels, there's no window for it to ask the size of.
+    void ResizeRenderer()
+    {
+        QSize size = (QSizeF(this->size()) * devicePixelRatioF()).toSize();
+        mFrameSize = size.boundedTo(mPixels.size());
+        mRenderer->Resize((unsigned int)mFrameSize.width(), (unsigned int)mFrameSize.height());
+        mRenderer->Invalidate();
+    }
+
+    QImage mPixels;
+    SDL_Surface* mSurface = nullptr;
+    QSize mFrameSize;
+};
+
+
+static bool translate_sdl_event(const SDL_Event& aEvent, SDL_WindowID& aWindowId, InputEvent& aInput)
+{
+    aInput.mTimestampNs = aEvent.common.timestamp;
+
+    switch (aEvent.type)
+    {
+        case SDL_EVENT_KEY_DOWN:
+        case SDL_EVENT_KEY_UP:
+            aWindowId = aEvent.key.windowID;
+            aInput.mType = aEvent.key.down ? InputEventType::KeyDown : InputEventType::KeyUp;
+            aInput.mKey = aEvent.key.key;
+            return true;
+        case SDL_EVENT_MOUSE_MOTION:
+            aWindowId = aEvent.motion.windowID;
+            aInput.mType = InputEventType::MouseMove;
+            aInput.mX = aEvent.motion.x;
+            aInput.mY = aEvent.motion.y;
+            return true;
+        case SDL_EVENT_MOUSE_BUTTON_DOWN:
+        case SDL_EVENT_MOUSE_BUTTON_UP:
+            aWindowId = aEvent.button.windowID;
+            aInput.mType = aEvent.button.down ? InputEventType::MouseButtonDown : InputEventType::MouseButtonUp;
+            aInput.mButton = aEvent.button.button;
+            aInput.mX = aEvent.button.x;
+            aInput.mY = aEvent.button.y;
+            return true;
+        case SDL_EVENT_MOUSE_WHEEL:
+            aWindowId = aEvent.wheel.windowID;
+            aInput.mType = InputEventType::MouseWheel;
+            aInput.mX = aEvent.wheel.x;
+            aInput.mY = aEvent.wheel.y;
+            return true;
+        case SDL_EVENT_WINDOW_FOCUS_GAINED:
+        case SDL_EVENT_WINDOW_FOCUS_LOST:
+            aWindowId = aEvent.window.windowID;
+            aInput.mType = (SDL_EVENT_WINDOW_FOCUS_GAINED == aEvent.type) ? InputEventType::FocusIn : InputEventType::FocusOut;
+            return true;
+        default:
+            return false;
+    }
+}
+
+void sdl_event_loop()
+{
+    SDL_Event event;
+    while (SDL_PollEvent(&event))
+    {
+        SDL_WindowID windowId = 0;
+        InputEvent input{};
+
+        if (!translate_sdl_event(event, windowId, input))
+        {
+            continue;
+        }
+
+        if (auto it = gSdlWindows.find(windowId); it != gSdlWindows.end())
+        {
+            it->second->PushInput(input);
+        }
+    }
+    
+    QTimer::singleShot(0, []()
+    {
+        sdl_event_loop();
+    });
+}
+
+// Decodes on the streamer's workers, so anything QImage can read can be drawn, not just BMPs.
+static bool decodeWithQImage(const char* aPath, DecodedImage& aImage)
+{
+    QImage image;
+    if (!image.load(QString::fromUtf8(aPath)))
+    {
+        return false;
+    }
+
+    image = image.convertToFormat(QImage::Format_RGBA8888);
+    aImage.mWidth = (uint32_t)image.width();
+    aImage.mHeight = (uint32_t)image.height();
+    aImage.mPixels.resize((size_t)aImage.mWidth * aImage.mHeight * 4);
+
+    size_t rowBytes = (size_t)aImage.mWidth * 4;
+    for (uint32_t y = 0; y < aImage.mHeight; ++y)
+    {
+        memcpy(aImage.mPixels.data() + y * rowBytes, image.constScanLine((int)y), rowBytes);
+    }
+
+    return true;
+}
+
+// Lays every image in aDirectory out in a square grid, in the normalized space ImageQuad uses.
+static void loadImageGrid(const QString& aDirectory)
+{
+    QStringList filters;
+    for (const QByteArray& format : QImageReader::supportedImageFormats())
+    {
+        filters << QString("*.%1").arg(QString::fromLatin1(format));
+    }
+
+    QFileInfoList files = QDir(aDirectory).entryInfoList(filters, QDir::Files, QDir::Name);
+    if (files.isEmpty())
+    {
+        printf("No images found in %s\n", qPrintable(aDirectory));
+        return;
+    }
+
+    SetImageDecoder(decodeWithQImage);
+
+    int columns = (int)std::ceil(std::sqrt((double)files.size()));
+    int rows = (files.size() + columns - 1) / columns;
+    float cellWidth = 1.0f / columns;
+    float cellHeight = 1.0f / rows;
+    float margin = 0.05f;
+
+    for (int i = 0; i < files.size(); ++i)
+    {
+        ImageQuad quad;
+        quad.mPath = files[i].absoluteFilePath().toStdString();
+        quad.mRect.x = (i % columns + margin) * cellWidth;
+        quad.mRect.y = (i / columns + margin) * cellHeight;
+        quad.mRect.w = (1.0f - 2.0f * margin) * cellWidth;
+        quad.mRect.h = (1.0f - 2.0f * margin) * cellHeight;
+        gImages.push_back(std::move(quad));
+    }
+}
+
+// Rasterizes on whichever thread renders the panel that first draws the glyph. QRawFont
+// isn't meant to be shared across threads, so each thread keeps its own per pixel size.
+static bool rasterizeWithQRawFont(char32_t aCodepoint, float aPixelSize, GlyphBitmap& aGlyph)
+{
+    thread_local std::unordered_map<int, QRawFont> fonts;
+
+    int key = (int)std::lround(aPixelSize * 64.0f);
+    auto it = fonts.find(key);
+    if (it == fonts.end())
+    {
+        QRawFont font = QRawFont::fromFont(QFontDatabase::systemFont(QFontDatabase::GeneralFont));
+        font.setPixelSize(aPixelSize);
+        it = fonts.emplace(key, font).first;
+    }
+
+    const QRawFont& font = it->second;
+    QList<quint32> indexes = font.glyphIndexesForString(QString::fromUcs4(&aCodepoint, 1));
+    if (indexes.isEmpty() || !font.isValid())
+    {
+        return false;
+    }
+
+    QList<QPointF> advances = font.advancesForGlyphIndexes(indexes);
+    aGlyph.mAdvance = advances.isEmpty() ? 0.0f : (float)advances[0].x();
+
+    QImage coverage = font.alphaMapForGlyph(indexes[0], QRawFont::PixelAntialiasing);
+    if (coverage.isNull())
+    {
+        // Whitespace, nothing to draw but it still moves the pen.
+        return true;
+    }
+
+    // Older Qts hand back an indexed gray ramp, newer ones plain alpha.
+    if (QImage::Format_Alpha8 != coverage.format())
+    {
+        coverage = coverage.convertToFormat(QImage::Format_Grayscale8);
+    }
+
+    QRectF bounds = font.boundingRect(indexes[0]);
+    aGlyph.mLeft = (int32_t)std::floor(bounds.left());
+    aGlyph.mTop = (int32_t)std::floor(bounds.top());
+    aGlyph.mWidth = (uint32_t)coverage.width();
+    aGlyph.mHeight = (uint32_t)coverage.height();
+    aGlyph.mCoverage.resize((size_t)aGlyph.mWidth * aGlyph.mHeight);
+
+    for (uint32_t y = 0; y < aGlyph.mHeight; ++y)
+    {
+        memcpy(aGlyph.mCoverage.data() + (size_t)y * aGlyph.mWidth, coverage.constScanLine((int)y), aGlyph.mWidth);
+    }
+
+    return true;
+}
+
+// The whole of aPath as one run in the top left of each panel, like a tool panel's log.
+static void loadText(const QString& aPath)
+{
+    QFile file(aPath);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        printf("Couldn't open %s\n", qPrintable(aPath));
+        return;
+    }
+
+    SetGlyphRasterizer(rasterizeWithQRawFont);
+
+    TextRun run;
+    run.mText = file.readAll().toStdString();
+    run.mOrigin = SDL_FPoint{ 0.02f, 0.05f };
+    run.mPixelSize = 14.0f;
+    gText.push_back(std::move(run));
+}
+
+// Mounts aPath for the renderers to read their assets from. A pack that fails its hashes
+// isn't mounted, so nothing's read from it and the renderers fall back to what they embed.
+static void mountAssetPack(const QString& aPath, bool aRequired)
+{
+    QByteArray path = QDir::toNativeSeparators(aPath).toLocal8Bit();
+    if (!aRequired && !QFile::exists(aPath))
+    {
+        return;
+    }
+
+    AssetPack& pack = AssetPack::Mounted();
+    if (pack.Open(path.constData()) && !pack.Verify())
+    {
+        printf("Not mounting %s\n", path.constData());
+        pack.Close();
+    }
+}
+
+// Opens aPath and reads every asset in it, once after asking the OS to drop it from the page
+// cache and then aWarmRuns times warm, reporting how long each took and the page faults it
+// cost. Opening only maps the file, so the time and faults are mostly in the reading.
+static void benchmarkAssetPack(const QString& aPath, int aWarmRuns)
+{
+    QByteArray path = QDir::toNativeSeparators(aPath).toLocal8Bit();
+
+    auto run = [&path](const char* aLabel)
+    {
+        PageFaultCounts before = GetProcessPageFaults();
+        QElapsedTimer timer;
+        timer.start();
+
+        AssetPack pack;
+        if (!pack.Open(path.constData()))
+        {
+            return false;
+        }
+
+        double openMs = timer.nsecsElapsed() / 1e6;
+        bool verified = pack.Verify();
+        double readMs = timer.nsecsElapsed() / 1e6;
+        PageFaultCounts after = GetProcessPageFaults();
+
+        printf("%-5s %zu assets, %zu bytes: open %.3f ms, open and read %.3f ms, %llu minor and %llu major page faults%s\n",
+            aLabel, pack.Entries().size(), pack.Size(), openMs, readMs,
+            (unsigned long long)(after.mMinor - before.mMinor), (unsigned long long)(after.mMajor - before.mMajor),
+            verified ? "" : ", hashes don't match");
+        return true;
+    };
+
+    if (!AssetPack::EvictFromPageCache(path.constData()))
+    {
+        printf("Couldn't drop %s from the page cache, the cold run is likely warm\n", path.constData());
+    }
+
+    if (!run("cold"))
+    {
+        return;
+    }
+
+    for (int i = 0; i < aWarmRuns; ++i)
+    {
+        run("warm");
+    }
+}
+
+QString formatRendererStats(Renderer* aRenderer)
+{
+    QStringList lines;
+    RendererStats stats;
+    {
+        auto lock = aRenderer->Lock();
+        stats = aRenderer->GetStats();
+    }
+
+    lines << QString("CPU: %1 ms").arg(stats.mCpuFrameMs, 0, 'f', 2);
+
+    for (size_t i = 0; i < stats.mPresentModes.size(); ++i)
+    {
+        const PresentModeStats& mode = stats.mPresentModes[i];
+
+        if (0 == mode.mFramesPresented)
+        {
+            continue;
+        }
+
+        lines << QString("%1: %2 ms submit to present, %3 fps")
+            .arg(PresentModeName((PresentMode)i))
+            .arg(mode.mSubmitToPresentMs, 0, 'f', 2)
+            .arg(mode.mFramesPerSecond, 0, 'f', 1);
+    }
+
+    if ((0 != stats.mFramesWithFallbackPipeline) || (0 != stats.mFramesWithSkippedDraws))
+    {
+        lines << QString("Waiting on pipelines: %1 fallback, %2 skipped frames")
+            .arg(stats.mFramesWithFallbackPipeline)
+            .arg(stats.mFramesWithSkippedDraws);
+    }
+
+    if (0 != stats.mFramesPerSubmit)
+    {
+        lines << QString("Submitted with %1 panels").arg(stats.mFramesPerSubmit);
+    }
+
+    if (0 != stats.mMaxQueuedFrames)
+    {
+        lines << QString("Queue: %1 frames max, %2 ms waiting")
+            .arg(stats.mMaxQueuedFrames)
+            .arg(stats.mQueueWaitMs, 0, 'f', 2);
+    }
+
+    if ((0 != stats.mStateCallsIssued) || (0 != stats.mStateCallsDropped))
+    {
+        lines << QString("State calls: %1 issued, %2 redundant dropped")
+            .arg(stats.mStateCallsIssued)
+            .arg(stats.mStateCallsDropped);
+    }
+
+    lines << QString("Allocations: %1 (%2 bytes) per frame, %3 steady state frames allocated")
+        .arg(stats.mFrameAllocations)
+        .arg(stats.mFrameAllocatedBytes)
+        .arg(stats.mSteadyStateFramesWithAllocations);
+
+    if ((0 != stats.mTexturesResident) || (0 != stats.mTexturesStreaming))
+    {
+        lines << QString("Textures: %1 resident, %2 streaming, %3 of %4 MB, %5 evicted")
+            .arg(stats.mTexturesResident)
+            .arg(stats.mTexturesStreaming)
+            .arg(stats.mTextureResidentBytes / (1024.0 * 1024.0), 0, 'f', 1)
+            .arg(stats.mTextureBudgetBytes / (1024 * 1024))
+            .arg(stats.mTextureEvictions);
+    }
+
+    if (0 != stats.mGraphPasses)
+    {
+        lines << QString("Render graph: %1 passes, %2 culled, %3 barriers, %4 saved by aliasing")
+            .arg(stats.mGraphPasses)
+            .arg(stats.mGraphPassesCulled)
+            .arg(stats.mGraphBarriers)
+            .arg(QLocale().formattedDataSize(stats.mGraphAliasingSavedBytes));
+    }
+
+    if (0.0 != stats.mFrameBudgetMs)
+    {
+        lines << QString("Resolution: %1%, %2 ms of %3 ms budget")
+            .arg(std::lround(stats.mRenderScale * 100.0f))
+            .arg(stats.mFrameCostMs, 0, 'f', 2)
+            .arg(stats.mFrameBudgetMs, 0, 'f', 1);
+    }
+
+    if (0 != stats.mGlyphsCached)
+    {
+        lines << QString("Glyphs: %1 cached, %2 bytes uploaded, %3 full uploads")
+            .arg(stats.mGlyphsCached)
+            .arg(stats.mGlyphUploadBytes)
+            .arg(stats.mGlyphFullUploads);
+    }
+
+    if (0 != stats.mInputEventsProcessed)
+    {
+        lines << QString("Input: %1 ms to present, %2 events, %3 dropped")
+            .arg(stats.mInputToPresentMs, 0, 'f', 2)
+            .arg(stats.mInputEventsProcessed)
+            .arg(stats.mInputEventsDropped);
+    }
+
+    return lines.join("  |  ");
+}
+
+// Everything the memory panel shows, in the shape it's exported in.
+QJsonObject buildMemoryReport()
+{
+    QJsonArray panels;
+    for (SdlPanel* sdlPanel : gPanels)
+    {
+        if (!sdlPanel->IsInitialized())
+        {
+            continue;
+        }
+
+        Renderer* renderer = sdlPanel->GetRenderer();
+        MemoryReport report;
+        {
+            auto lock = renderer->Lock();
+            report = renderer->GetMemoryReport();
+        }
+
+        QJsonArray entries;
+        for (const MemoryEntry& entry : report.mEntries)
+        {
+            QJsonObject object;
+            object["name"] = entry.mName;
+            object["bytes"] = (qint64)entry.mBytes;
+            object["estimated"] = entry.mEstimated;
+            entries.append(object);
+        }
+
+        QJsonArray heaps;
+        for (const MemoryHeapReport& heap : report.mHeaps)
+        {
+            QJsonObject object;
+            object["deviceLocal"] = heap.mDeviceLocal;
+            object["budgetBytes"] = (qint64)heap.mBudgetBytes;
+            object["usageBytes"] = (qint64)heap.mUsageBytes;
+            object["blockBytes"] = (qint64)heap.mBlockBytes;
+            object["allocationBytes"] = (qint64)heap.mAllocationBytes;
+            object["allocationCount"] = (qint64)heap.mAllocationCount;
+            heaps.append(object);
+        }
+
+        QJsonObject panel;
+        panel["renderer"] = renderer->Name();
+        panel["windowId"] = (qint64)sdlPanel->GetWindowId();
+        panel["entries"] = entries;
+        panel["heaps"] = heaps;
+        panels.append(panel);
+    }
+
+    QJsonObject root;
+    root["processResidentBytes"] = (qint64)GetProcessResidentBytes();
+    root["panels"] = panels;
+    return root;
+}
+
+void createMemoryPanel(DockOwningMainWindow* aMainWindow)
+{
+    auto tree = new QTreeWidget();
+    tree->setColumnCount(2);
+    tree->setHeaderLabels({ "Allocation", "Size" });
+
+    auto dockWidget = new ads::CDockWidget("Memory", aMainWindow);
+    dockWidget->setWidget(tree);
+    aMainWindow->GetDockManager()->addDockWidget(ads::RightDockWidgetArea, dockWidget);
+
+    auto toolBar = dockWidget->createDefaultToolBar();
+    auto exportAction = toolBar->addAction("Export JSON...");
+    QObject::connect(exportAction, &QAction::triggered, [aMainWindow]()
+    {
+        QString path = QFileDialog::getSaveFileName(aMainWindow, "Export Memory Report", "memory.json", "JSON (*.json)");
+        if (path.isEmpty())
+        {
+            return;
+        }
+
+        QFile file{ path };
+        if (!file.open(QIODevice::WriteOnly))
+        {
+            printf("Failed to open %s for writing\n", qPrintable(path));
+            return;
+        }
+
+        file.write(QJsonDocument(buildMemoryReport()).toJson());
+    });
+
+    auto bytes = [](const QJsonValue& aValue)
+    {
+        return QLocale().formattedDataSize(aValue.toInteger());
+    };
+
+    auto refresh = [tree, bytes]()
+    {
+        QJsonObject root = buildMemoryReport();
+        tree->clear();
+
+        tree->addTopLevelItem(new QTreeWidgetItem(QStringList{ "Process resident", bytes(root["processResidentBytes"]) }));
+
+        for (const QJsonValue& panelValue : root["panels"].toArray())
+        {
+            QJsonObject panel = panelValue.toObject();
+            auto panelItem = new QTreeWidgetItem(QStringList{ panel["renderer"].toString() });
+            tree->addTopLevelItem(panelItem);
+
+            qint64 total = 0;
+            for (const QJsonValue& entryValue : panel["entries"].toArray())
+            {
+                QJsonObject entry = entryValue.toObject();
+                QString name = entry["name"].toString();
+                if (entry["estimated"].toBool())
+                {
+                    name += " (estimated)";
+                }
+
+                panelItem->addChild(new QTreeWidgetItem(QStringList{ name, bytes(entry["bytes"]) }));
+                total += entry["bytes"].toInteger();
+            }
+            panelItem->setText(1, QLocale().formattedDataSize(total));
+
+            QJsonArray heaps = panel["heaps"].toArray();
+            for (qsizetype i = 0; i < heaps.size(); ++i)
+            {
+                QJsonObject heap = heaps[i].toObject();
+                QString name = QString("Heap %1%2 (device wide)").arg(i).arg(heap["deviceLocal"].toBool() ? ", device local" : "");
+                auto heapItem = new QTreeWidgetItem(QStringList{ name, QString("%1 of %2").arg(bytes(heap["usageBytes"]), bytes(heap["budgetBytes"])) });
+                heapItem->addChild(new QTreeWidgetItem(QStringList{ "Allocator blocks", bytes(heap["blockBytes"]) }));
+                heapItem->addChild(new QTreeWidgetItem(QStringList{ QString("Allocations (%1)").arg(heap["allocationCount"].toInteger()), bytes(heap["allocationBytes"]) }));
+                panelItem->addChild(heapItem);
+            }
+        }
+
+        tree->expandAll();
+    };
+
+    auto timer = new QTimer(tree);
+    QObject::connect(timer, &QTimer::timeout, refresh);
+    timer->start(1000);
+}
+
+SdlPanel* createSdlWindow(DockOwningMainWindow* aMainWindow, RendererType aType, const std::string& aRendererBackend, ads::DockWidgetArea aArea, color aClearColor)
+{
+    SdlPanel* sdlWindow = nullptr;
+    QWidget* sdlWidget = nullptr;
+    if (gSoftwareWidgets && (RendererType::SdlRenderRenderer == aType) && (aRendererBackend == SDL_SOFTWARE_RENDERER))
+    {
+        auto rasterWidget = new QSdlRasterWidget();
+        sdlWindow = rasterWidget;
+        sdlWidget = rasterWidget;
+    }
+    else
+    {
+        auto nativeWindow = new QSdlWindow(aType, aRendererBackend);
+        sdlWindow = nativeWindow;
+        sdlWidget = QWidget::createWindowContainer(nativeWindow);
+    }
+
+    auto dockWidget = new ads::CDockWidget("", aMainWindow);
+    dockWidget->setMinimumSizeHintMode(ads::CDockWidget::MinimumSizeHintFromContent);
+    //dockWidget->setAllowedAreas(Qt::BottomDockWidgetArea | Qt::TopDockWidgetArea | Qt::LeftDockWidgetArea | Qt::RightDockWidgetArea);
+
+    // Until the renderer has finished initializing on the pool we show a placeholder in
+    // the panel, then flip over to the SDL window.
+    auto placeholder = new QLabel("Initializing...");
+    placeholder->setAlignment(Qt::AlignCenter);
+
+    auto stack = new QStackedWidget();
+    stack->addWidget(placeholder);
+    stack->addWidget(sdlWidget);
+    dockWidget->setWidget(stack);
+
+    aMainWindow->GetDockManager()->addDockWidget(aArea, dockWidget);
+    sdlWidget->setMinimumSize(10, 10);
+    sdlWidget->setBaseSize(480, 320);
+    sdlWidget->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+    // Per panel controls for presentation, only usable once the renderer exists.
+    auto toolBar = dockWidget->createDefaultToolBar();
+    auto presentModes = new QComboBox();
+    for (size_t i = 0; i < (size_t)PresentMode::Count; ++i)
+    {
+        presentModes->addItem(PresentModeName((PresentMode)i));
+    }
+    presentModes->setEnabled(false);
+    toolBar->addWidget(presentModes);
+
+    auto continuous = new QCheckBox("Animate");
+    QObject::connect(continuous, &QCheckBox::toggled, [sdlWindow](bool aChecked)
+    {
+        sdlWindow->SetContinuous(aChecked);
+    });
+    toolBar->addWidget(continuous);
+
+    auto statsLabel = new QLabel();
+    toolBar->addWidget(statsLabel);
+
+    sdlWindow->SetOnInitialized([stack, placeholder, sdlWidget, sdlWindow, presentModes, statsLabel](bool aSucceeded)
+    {
+        if (!aSucceeded)
+        {
+            placeholder->setText(QString("Failed to create %1").arg(sdlWindow->GetRenderer()->Name()));
+            return;
+        }
+
+        stack->setCurrentWidget(sdlWidget);
+
+        Renderer* renderer = sdlWindow->GetRenderer();
+        {
+            auto lock = renderer->Lock();
+            presentModes->setCurrentIndex((int)renderer->SetPresentMode(PresentMode::Fifo));
+        }
+        presentModes->setEnabled(true);
+
+        QObject::connect(presentModes, &QComboBox::currentIndexChanged, [presentModes, renderer](int aIndex)
+        {
+            // Reflect what the backend actually gave us, it may have fallen back.
+            auto lock = renderer->Lock();
+            PresentMode applied = renderer->SetPresentMode((PresentMode)aIndex);
+            QSignalBlocker blocker{ presentModes };
+            presentModes->setCurrentIndex((int)applied);
+        });
+
+        auto statsTimer = new QTimer(statsLabel);
+        QObject::connect(statsTimer, &QTimer::timeout, [statsLabel, renderer]()
+        {
+            statsLabel->setText(formatRendererStats(renderer));
+        });
+        statsTimer->start(500);
+    });
+    sdlWindow->Initialize();
+
+    if (nullptr == sdlWindow->GetRenderer())
+    {
+        placeholder->setText("Failed to create renderer");
+        return nullptr;
+    }
+
+    {
+        // Initialize may still be running on a worker, which can already be drawing.
+        auto lock = sdlWindow->GetRenderer()->Lock();
+        sdlWindow->GetRenderer()->SetClearColor(aClearColor);
+        sdlWindow->GetRenderer()->SetTriangleColor({ 0x00, 0x00, 0xFF, 0xFF });
+        if (!gImages.empty())
+        {
+            sdlWindow->GetRenderer()->SetImages(gImages);
+        }
+        if (!gText.empty())
+        {
+            sdlWindow->GetRenderer()->SetText(gText);
+        }
+    }
+    placeholder->setText(QString("Initializing %1...").arg(sdlWindow->GetRenderer()->Name()));
+    sdlWidget->setWindowTitle(sdlWindow->GetRenderer()->Name());
+    dockWidget->setWindowTitle(sdlWindow->GetRenderer()->Name());
+    return sdlWindow;
+}
+
+// Creates every panel aPanel describes, aPanelIndex counts panels across the whole layout
+// so ones without a clear color of their own still get distinct ones.
+std::vector<SdlPanel*> createPanels(DockOwningMainWindow* aMainWindow, const PanelDescription& aPanel, size_t& aPanelIndex)
+{
+    std::vector<std::string> drivers{ aPanel.mDriver };
+
+    if ((RendererType::SdlRenderRenderer == aPanel.mType) && aPanel.mDriver.empty())
+    {
+        drivers.clear();
+        for (int i = 0; i < SDL_GetNumRenderDrivers(); ++i)
+        {
+            drivers.push_back(SDL_GetRenderDriver(i));
+        }
+    }
+
+    std::vector<SdlPanel*> windows;
+    for (int i = 0; i < aPanel.mCount; ++i)
+    {
+        for (const std::string& driver : drivers)
+        {
+            color clearColor = aPanel.mClearColor.value_or(PanelPaletteColor(aPanelIndex++));
+
+            if (SdlPanel* sdlWindow = createSdlWindow(aMainWindow, aPanel.mType, driver, aPanel.mArea, clearColor))
+            {
+                windows.push_back(sdlWindow);
+            }
+        }
+    }
+
+    return windows;
+}
+
+// Opens 1, 2, 4 and so on up to a maximum number of panels of one backend, draws all of them
+// continuously with vsync off, and measures aggregate frames per second at each step. The
+// per-panel cost is what tells us where the multi-viewport design stops scaling: it should
+// stay flat while the GPU has headroom, and starts climbing once the GUI thread, the driver
+// or the compositor is the bottleneck. Prints a table when done and quits.
+class ScalingBenchmark
+{
+public:
+    ScalingBenchmark(DockOwningMainWindow* aMainWindow, PanelDescription aPanel, int aMaxPanels, int aSecondsPerStep, QString aOutputPath, bool aRequireAllocationFree)
+        : mMainWindow{ aMainWindow }
+        , mPanel{ std::move(aPanel) }
+        , mMaxPanels{ aMaxPanels }
+        , mSecondsPerStep{ aSecondsPerStep }
+        , mOutputPath{ std::move(aOutputPath) }
+        , mRequireAllocationFree{ aRequireAllocationFree }
+    {
+        // One panel per step, the driver list would otherwise multiply it.
+        if ((RendererType::SdlRenderRenderer == mPanel.mType) && mPanel.mDriver.empty() && (0 < SDL_GetNumRenderDrivers()))
+        {
+            mPanel.mDriver = SDL_GetRenderDriver(0);
+        }
+
+        mPanel.mCount = 1;
+    }
+
+    void Start()
+    {
+        AddPanels(1);
+
+        auto timer = new QTimer(mMainWindow);
+        QObject::connect(timer, &QTimer::timeout, [this]()
+        {
+            Poll();
+        });
+        timer->start(100);
+    }
+
+private:
+    enum class Phase
+    {
+        Initializing,
+        WarmingUp,
+        Measuring
+    };
+
+    struct Step
+    {
+        size_t mPanels;
+        double mAggregateFps;
+        double mCpuFrameMs;
+
+        // Steady state frames measured in this step that allocated, which should be none.
+        uint64_t mFramesWithAllocations;
+    };
+
+    // Long enough for swapchains to settle and pipelines to finish compiling.
+    static constexpr qint64 cWarmUpMs = 1000;
+
+    void AddPanels(size_t aTarget)
+    {
+        while (mWindows.size() < aTarget)
+        {
+            std::vector<SdlPanel*> windows = createPanels(mMainWindow, mPanel, mPanelIndex);
+            if (windows.empty())
+            {
+                printf("Scaling benchmark stopped, couldn't create panel %zu\n", mWindows.size() + 1);
+                break;
+            }
+
+            mWindows.insert(mWindows.end(), windows.begin(), windows.end());
+        }
+
+        mTargetPanels = aTarget;
+        mPhase = Phase::Initializing;
+    }
+
+    uint64_t TotalFramesRendered() const
+    {
+        uint64_t frames = 0;
+        for (SdlPanel* sdlWindow : mWindows)
+        {
+            frames += sdlWindow->GetFramesRendered();
+        }
+
+        return frames;
+    }
+
+    uint64_t TotalFramesWithAllocations() const
+    {
+        uint64_t frames = 0;
+        for (SdlPanel* sdlWindow : mWindows)
+        {
+            auto lock = sdlWindow->GetRenderer()->Lock();
+            frames += sdlWindow->GetRenderer()->GetStats().mSteadyStateFramesWithAllocations;
+        }
+
+        return frames;
+    }
+
+    void Poll()
+    {
+        switch (mPhase)
+        {
+            case Phase::Initializing:
+            {
+                if (0 != gPendingRendererInitializations)
+                {
+                    return;
+                }
+
+                if (mWindows.empty())
+                {
+                    Finish();
+                    return;
+                }
+
+                for (SdlPanel* sdlWindow : mWindows)
+                {
+                    {
+                        auto lock = sdlWindow->GetRenderer()->Lock();
+                        sdlWindow->GetRenderer()->SetPresentMode(PresentMode::Immediate);
+                    }
+
+                    sdlWindow->SetContinuous(true);
+                }
+
+                mPhase = Phase::WarmingUp;
+                mPhaseTimer.start();
+                return;
+            }
+            case Phase::WarmingUp:
+            {
+                if (mPhaseTimer.elapsed() < cWarmUpMs)
+                {
+                    return;
+                }
+
+                // Only frames from here on count, adding panels resizes the others, which
+                // is allowed to allocate.
+                mPhase = Phase::Measuring;
+                mStartFrames = TotalFramesRendered();
+                mStartFramesWithAllocations = TotalFramesWithAllocations();
+                mPhaseTimer.start();
+                return;
+            }
+            case Phase::Measuring:
+            {
+                if (mPhaseTimer.elapsed() < (mSecondsPerStep * 1000))
+                {
+                    return;
+                }
+
+                double seconds = mPhaseTimer.elapsed() / 1000.0;
+                double cpuFrameMs = 0.0;
+                for (SdlPanel* sdlWindow : mWindows)
+                {
+                    auto lock = sdlWindow->GetRenderer()->Lock();
+                    cpuFrameMs += sdlWindow->GetRenderer()->GetStats().mCpuFrameMs;
+                }
+
+                Step step;
+                step.mPanels = mWindows.size();
+                step.mAggregateFps = (TotalFramesRendered() - mStartFrames) / seconds;
+                step.mCpuFrameMs = cpuFrameMs / mWindows.size();
+                step.mFramesWithAllocations = TotalFramesWithAllocations() - mStartFramesWithAllocations;
+                mSteps.push_back(step);
+
+                printf("Scaling: %zu panels, %.1f fps aggregate, %s threading\n", step.mPanels, step.mAggregateFps, ThreadingModelName(gThreadingModel));
+
+                if ((mTargetPanels == mWindows.size()) && ((mWindows.size() * 2) <= (size_t)mMaxPanels))
+                {
+                    AddPanels(mWindows.size() * 2);
+                    return;
+                }
+
+                Finish();
+                return;
+            }
+        }
+    }
+
+    // With --scaling-allocation-free, a measured frame that allocated fails the run, so it
+    // can gate changes rather than just print.
+    void Finish()
+    {
+        Report();
+
+        uint64_t framesWithAllocations = 0;
+        for (const Step& step : mSteps)
+        {
+            framesWithAllocations += step.mFramesWithAllocations;
+        }
+
+        if (mRequireAllocationFree && (0 != framesWithAllocations))
+        {
+            printf("Scaling benchmark failed, %llu steady state frames made heap allocations\n", (unsigned long long)framesWithAllocations);
+            QApplication::exit(1);
+            return;
+        }
+
+        QApplication::quit();
+    }
+
+    void Report()
+    {
+        QStringList lines;
+        lines << "threading,panels,aggregate_fps,fps_per_panel,ms_per_frame,cpu_ms_per_frame,marginal_ms_per_panel,frames_with_allocations";
+
+        size_t peak = 0;
+        for (size_t i = 0; i < mSteps.size(); ++i)
+        {
+            const Step& step = mSteps[i];
+
+            // Wall time each frame costs when the panels take turns, and how much of that
+            // was added per panel since the previous step.
+            double msPerFrame = (0.0 < step.mAggregateFps) ? (1000.0 / step.mAggregateFps) : 0.0;
+            double marginalMs = 0.0;
+            if (0 < i)
+            {
+                const Step& previous = mSteps[i - 1];
+                double previousMsPerRound = (0.0 < previous.mAggregateFps) ? (1000.0 * previous.mPanels / previous.mAggregateFps) : 0.0;
+                marginalMs = ((msPerFrame * step.mPanels) - previousMsPerRound) / (step.mPanels - previous.mPanels);
+            }
+
+            lines << QString("%1,%2,%3,%4,%5,%6,%7,%8")
+                .arg(ThreadingModelName(gThreadingModel))
+                .arg(step.mPanels)
+                .arg(step.mAggregateFps, 0, 'f', 1)
+                .arg(step.mAggregateFps / step.mPanels, 0, 'f', 1)
+                .arg(msPerFrame, 0, 'f', 3)
+                .arg(step.mCpuFrameMs, 0, 'f', 3)
+                .arg(marginalMs, 0, 'f', 3)
+                .arg(step.mFramesWithAllocations);
+
+            if (step.mAggregateFps > mSteps[peak].mAggregateFps)
+            {
+                peak = i;
+            }
+        }
+
+        QString table = lines.join("\n");
+        printf("%s\n", qPrintable(table));
+
+        if (!mSteps.empty())
+        {
+            printf("Aggregate fps peaked at %zu panels\n", mSteps[peak].mPanels);
+        }
+
+        if (mOutputPath.isEmpty())
+        {
+            return;
+        }
+
+        QFile file{ mOutputPath };
+        if (!file.open(QIODevice::WriteOnly))
+        {
+            printf("Failed to open %s for writing\n", qPrintable(mOutputPath));
+            return;
+        }
+
+        file.write(table.toUtf8());
+        file.write("\n");
+    }
+
+    DockOwningMainWindow* mMainWindow;
+    PanelDescription mPanel;
+    int mMaxPanels;
+    int mSecondsPerStep;
+    QString mOutputPath;
+    bool mRequireAllocationFree;
+
+    std::vector<SdlPanel*> mWindows;
+    size_t mPanelIndex = 0;
+    size_t mTargetPanels = 0;
+    Phase mPhase = Phase::Initializing;
+    QElapsedTimer mPhaseTimer;
+    uint64_t mStartFrames = 0;
+    uint64_t mStartFramesWithAllocations = 0;
+    std::vector<Step> mSteps;
+};
+
+int main(int argc, char *argv[])
+{
+    // Renderers report what they allocate per frame, SDL's allocations included.
+    InstallSdlAllocationHooks();
+
+    if (!SDL_Init(SDL_INIT_VIDEO))
+    {
+        printf( "SDL could not initialize! SDL_Error: %s\n", SDL_GetError() );
+    }
+
+    QApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Renders into SDL windows docked in a Qt window, one backend per panel.");
+    parser.addHelpOption();
+    parser.addOptions({
+        { "layout", "Creates the panels listed in the JSON <file>.", "file" },
+        { "panel", "Adds panels, as backend[:driver][*count][@area], for example vulkan*4@top. Repeatable.", "panel" },
+        { "scaling", "Benchmarks 1, 2, 4 and so on panels of <panel> and reports aggregate fps.", "panel" },
+        { "scaling-max", "Largest panel count for --scaling, 64 by default.", "count", "64" },
+        { "scaling-seconds", "Seconds measured per --scaling step, 5 by default.", "seconds", "5" },
+        { "scaling-output", "Also writes the --scaling results to <file> as CSV.", "file" },
+        { "scaling-allocation-free", "Makes --scaling exit with status 1 if any measured frame made heap allocations." },
+        { "threading", "Where panels render: gui (the default), shared, per-panel or pool.", "model", "gui" },
+        { "images", "Draws every image in <dir> in a grid in each panel, streamed in as they're needed.", "dir" },
+        { "text", "Draws the UTF-8 text in <file> over each panel.", "file" },
+        { "assets", "Mounts the asset pack <file> instead of the Assets.pack next to the executable.", "file" },
+        { "asset-benchmark", "Times cold and warm loads of the asset pack <file>, with page faults, and quits.", "file" },
+        { "software-widgets", "Shows SDL software renderer panels in plain Qt widgets, drawn straight into their pixels." },
+    });
+    parser.process(app);
+
+    std::vector<PanelDescription> panels;
+    if (parser.isSet("layout") && !LoadPanelLayout(parser.value("layout"), panels))
+    {
+        return 1;
+    }
+
+    for (const QString& text : parser.values("panel"))
+    {
+        PanelDescription panel;
+        if (!ParsePanelDescription(text, panel))
+        {
+            return 1;
+        }
+
+        panels.push_back(panel);
+    }
+
+    if (!parser.isSet("layout") && panels.empty())
+    {
+        panels = DefaultPanelLayout();
+    }
+
+    QString threadingOption = parser.value("threading");
+    bool foundThreadingModel = false;
+    for (size_t i = 0; i < (size_t)ThreadingModel::Count; ++i)
+    {
+        if (threadingOption == ThreadingModelName((ThreadingModel)i))
+        {
+            gThreadingModel = (ThreadingModel)i;
+            foundThreadingModel = true;
+        }
+    }
+
+    if (!foundThreadingModel)
+    {
+        printf("Unknown threading model \"%s\"\n", qPrintable(threadingOption));
+        return 1;
+    }
+
+    if (parser.isSet("asset-benchmark"))
+    {
+        benchmarkAssetPack(parser.value("asset-benchmark"), 5);
+        return 0;
+    }
+
+    if (parser.isSet("assets"))
+    {
+        mountAssetPack(parser.value("assets"), true);
+    }
+    else
+    {
+        mountAssetPack(QDir(QCoreApplication::applicationDirPath()).filePath("Assets.pack"), false);
+    }
+
+    gRenderScheduler = CreateRenderScheduler(gThreadingModel);
+    gSoftwareWidgets = parser.isSet("software-widgets");
+
+    if (parser.isSet("images"))
+    {
+        loadImageGrid(parser.value("images"));
+    }
+
+    if (parser.isSet("text"))
+    {
+        loadText(parser.value("text"));
+    }
+
+    QString scalingOption = parser.value("scaling");
+    int scalingMaxPanels = std::max(1, parser.value("scaling-max").toInt());
+    int scalingSeconds = std::max(1, parser.value("scaling-seconds").toInt());
+
+    // Make a window. This type has support for docking and gives a 
+    // central window in the middle of the docking panels that doesn't move.
+    auto window = new DockOwningMainWindow;
+    //window->setCentralWidget(nullptr);
+    //auto centralWidget = new QWidget();
+    //window->setCentralWidget(centralWidget);
+    //window->centralWidget()->setBaseSize(0, 0);
+    //window->centralWidget()->setMinimumSize(0, 0);
+    //window->centralWidget()->setMaximumSize(0,0);
+    //window->centralWidget()->hide();
+
+    // Enables "infinite docking".
+    window->setDockNestingEnabled(true);
+
+    // Sets the default window size.
+    window->resize(850, 700);
+
+    //// Used to store widgets in the central widget.
+    //auto centralTabs = new QTabWidget;
+    //window->setCentralWidget(centralTabs);
+    //
+    //// Adding a menuTab layer for menu options.
+    //auto menuTabs = new QMenuBar(centralTabs);
+    //window->setMenuBar(menuTabs);
+    //
+    //// Adding a toolTab layer for tools options.
+    //auto toolTabs = new QToolBar(centralTabs);
     //window->addToolBar(toolTabs);
     //
     //// Actions that will handle the events from our buttons.
@@ -294,14 +1885,6 @@ int main(int argc, char *argv[])
     //createSdlWindow(window, RendererType::VkRenderer, nullptr, ads::LeftDockWidgetArea, { 0x00, 0x00, 0xFF, 0xFF });
     //createSdlWindow(window, RendererType::OpenGL3_3Renderer, nullptr, ads::RightDockWidgetArea, { 0xFF, 0x00, 0x00, 0xFF });
 
-#if WIN32
-    createSdlWindow(window, RendererType::Dx11Renderer, nullptr, ads::TopDockWidgetArea, { 0x00, 0xFF, 0x00, 0xFF });
-    createSdlWindow(window, RendererType::Dx12Renderer, nullptr, ads::TopDockWidgetArea, { 0xFF, 0x00, 0xFF, 0xFF });
-#endif // WIN32
-
-    createSdlWindow(window, RendererType::VkRenderer, nullptr, ads::TopDockWidgetArea, { 0x00, 0x00, 0xFF, 0xFF });
-    createSdlWindow(window, RendererType::OpenGL3_3Renderer, nullptr, ads::TopDockWidgetArea, { 0xFF, 0x00, 0x00, 0xFF });
-
     auto drivers = SDL_GetNumRenderDrivers();
 
     printf("Drivers Start\n;");
@@ -310,8 +1893,29 @@ int main(int argc, char *argv[])
     }
     printf("Drivers End\n;");
 
-    for (size_t i = 0; i < drivers; ++i) {
-        createSdlWindow(window, RendererType::SdlRenderRenderer, SDL_GetRenderDriver(i), ads::BottomDockWidgetArea, {0x00, 0x00, 0x00, 0xFF});
+    if (!scalingOption.isEmpty())
+    {
+        PanelDescription panel;
+        if (!ParsePanelDescription(scalingOption, panel))
+        {
+            return 1;
+        }
+
+        // Leave the panels as much room as the screen allows, they get small quickly.
+        window->resize(1600, 1000);
+
+        auto benchmark = new ScalingBenchmark(window, panel, scalingMaxPanels, scalingSeconds, parser.value("scaling-output"), parser.isSet("scaling-allocation-free"));
+        benchmark->Start();
+    }
+    else
+    {
+        size_t panelIndex = 0;
+        for (const PanelDescription& panel : panels)
+        {
+            createPanels(window, panel, panelIndex);
+        }
+
+        createMemoryPanel(window);
     }
 
     QTimer::singleShot(0, []()
@@ -321,5 +1925,9 @@ int main(int argc, char *argv[])
 
     window->show();
   
-    return QApplication::exec();
+    int result = QApplication::exec();
+
+    // Render threads have to be done before the renderers and pools they use go away.
+    gRenderScheduler.reset();
+    return result;
 }